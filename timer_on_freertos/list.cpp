@@ -96,14 +96,21 @@ ListItem_t * const pxIndex = pxList->pxIndex;
 	/* Remember which list the item is in. */
 	pxNewListItem->pvContainer = ( void * ) pxList;
 
-	( pxList->uxNumberOfItems )++;
+	( pxList->uxNumberOfItems ) = ( UBaseType_t ) ( pxList->uxNumberOfItems + 1U );
 }
 /*-----------------------------------------------------------*/
 
 void vListInsert( List_t * const pxList, ListItem_t * const pxNewListItem )
+{
+	( void ) uxListInsert( pxList, pxNewListItem );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxListInsert( List_t * const pxList, ListItem_t * const pxNewListItem )
 {
 ListItem_t *pxIterator;
 const TickType_t xValueOfInsertion = pxNewListItem->xItemValue;
+UBaseType_t uxItemsPassed = ( UBaseType_t ) 0U;
 
 	/* Only effective when configASSERT() is also defined, these tests may catch
 	the list data structures being overwritten in memory.  They will not catch
@@ -149,8 +156,9 @@ const TickType_t xValueOfInsertion = pxNewListItem->xItemValue;
 
 		for( pxIterator = ( ListItem_t * ) &( pxList->xListEnd ); pxIterator->pxNext->xItemValue <= xValueOfInsertion; pxIterator = pxIterator->pxNext ) /*lint !e826 !e740 The mini list structure is used as the list end to save RAM.  This is checked and valid. */
 		{
-			/* There is nothing to do here, just iterating to the wanted
-			insertion position. */
+			/* Just iterating to the wanted insertion position, counting
+			the items passed for the caller. */
+			uxItemsPassed++;
 		}
 	}
 
@@ -163,7 +171,9 @@ const TickType_t xValueOfInsertion = pxNewListItem->xItemValue;
 	item later. */
 	pxNewListItem->pvContainer = ( void * ) pxList;
 
-	( pxList->uxNumberOfItems )++;
+	( pxList->uxNumberOfItems ) = ( UBaseType_t ) ( pxList->uxNumberOfItems + 1U );
+
+	return uxItemsPassed;
 }
 /*-----------------------------------------------------------*/
 
@@ -190,9 +200,107 @@ List_t * const pxList = ( List_t * ) pxItemToRemove->pvContainer;
 	}
 
 	pxItemToRemove->pvContainer = NULL;
-	( pxList->uxNumberOfItems )--;
+	( pxList->uxNumberOfItems ) = ( UBaseType_t ) ( pxList->uxNumberOfItems - 1U );
 
 	return pxList->uxNumberOfItems;
 }
 /*-----------------------------------------------------------*/
 
+void vIndexListInitialise( IndexListItem_t * const pxPool, const ListIndex_t ulList )
+{
+IndexListItem_t * const pxListEnd = &( pxPool[ ulList ] );
+
+	/* As with xListEnd the end marker holds the highest possible value and
+	links to itself while the list is empty.  Its container member counts the
+	items in the list. */
+	pxListEnd->xItemValue = portMAX_DELAY;
+	pxListEnd->ulNext = ulList;
+	pxListEnd->ulPrevious = ulList;
+	pxListEnd->ulContainer = ( ListIndex_t ) 0U;
+}
+/*-----------------------------------------------------------*/
+
+void vIndexListInitialiseItem( IndexListItem_t * const pxPool, const ListIndex_t ulItem )
+{
+	/* Make sure the list item is not recorded as being on a list. */
+	pxPool[ ulItem ].ulContainer = listINDEX_NONE;
+}
+/*-----------------------------------------------------------*/
+
+void vIndexListInsert( IndexListItem_t * const pxPool, const ListIndex_t ulList, const ListIndex_t ulNewItem )
+{
+	( void ) uxIndexListInsert( pxPool, ulList, ulNewItem );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxIndexListInsert( IndexListItem_t * const pxPool, const ListIndex_t ulList, const ListIndex_t ulNewItem )
+{
+IndexListItem_t * const pxNewListItem = &( pxPool[ ulNewItem ] );
+const TickType_t xValueOfInsertion = pxNewListItem->xItemValue;
+ListIndex_t ulIterator;
+UBaseType_t uxItemsPassed = ( UBaseType_t ) 0U;
+
+	/* See vListInsert() - items with equal values are placed after the items
+	already in the list, with the end marker value handled separately so the
+	walk below is guaranteed to terminate. */
+	if( xValueOfInsertion == portMAX_DELAY )
+	{
+		ulIterator = pxPool[ ulList ].ulPrevious;
+	}
+	else
+	{
+		for( ulIterator = ulList; pxPool[ pxPool[ ulIterator ].ulNext ].xItemValue <= xValueOfInsertion; ulIterator = pxPool[ ulIterator ].ulNext )
+		{
+			/* Just iterating to the wanted insertion position, counting
+			the items passed for the caller. */
+			uxItemsPassed++;
+		}
+	}
+
+	pxNewListItem->ulNext = pxPool[ ulIterator ].ulNext;
+	pxPool[ pxNewListItem->ulNext ].ulPrevious = ulNewItem;
+	pxNewListItem->ulPrevious = ulIterator;
+	pxPool[ ulIterator ].ulNext = ulNewItem;
+
+	/* Remember which list the item is in.  This allows fast removal of the
+	item later. */
+	pxNewListItem->ulContainer = ulList;
+
+	( pxPool[ ulList ].ulContainer )++;
+
+	return uxItemsPassed;
+}
+/*-----------------------------------------------------------*/
+
+void vIndexListInsertEnd( IndexListItem_t * const pxPool, const ListIndex_t ulList, const ListIndex_t ulNewItem )
+{
+IndexListItem_t * const pxNewListItem = &( pxPool[ ulNewItem ] );
+
+	pxNewListItem->ulNext = ulList;
+	pxNewListItem->ulPrevious = pxPool[ ulList ].ulPrevious;
+	pxPool[ pxNewListItem->ulPrevious ].ulNext = ulNewItem;
+	pxPool[ ulList ].ulPrevious = ulNewItem;
+
+	pxNewListItem->ulContainer = ulList;
+
+	( pxPool[ ulList ].ulContainer )++;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxIndexListRemove( IndexListItem_t * const pxPool, const ListIndex_t ulItemToRemove )
+{
+IndexListItem_t * const pxItemToRemove = &( pxPool[ ulItemToRemove ] );
+IndexListItem_t * const pxListEnd = &( pxPool[ pxItemToRemove->ulContainer ] );
+
+	pxPool[ pxItemToRemove->ulNext ].ulPrevious = pxItemToRemove->ulPrevious;
+	pxPool[ pxItemToRemove->ulPrevious ].ulNext = pxItemToRemove->ulNext;
+
+	/* Only used during decision coverage testing. */
+	mtCOVERAGE_TEST_DELAY();
+
+	pxItemToRemove->ulContainer = listINDEX_NONE;
+	( pxListEnd->ulContainer )--;
+
+	return ( UBaseType_t ) pxListEnd->ulContainer;
+}
+/*-----------------------------------------------------------*/
@@ -367,6 +367,12 @@ void vListInitialiseItem( ListItem_t * const pxItem ) /*PRIVILEGED_FUNCTION*/;
  */
 void vListInsert( List_t * const pxList, ListItem_t * const pxNewListItem ) /*PRIVILEGED_FUNCTION*/;
 
+/*
+ * As vListInsert(), returning the number of items walked past to find the
+ * position of the new item.
+ */
+UBaseType_t uxListInsert( List_t * const pxList, ListItem_t * const pxNewListItem ) /*PRIVILEGED_FUNCTION*/;
+
 /*
  * Insert a list item into a list.  The item will be inserted in a position
  * such that it will be the last item within the list returned by multiple
@@ -403,6 +409,88 @@ void vListInsertEnd( List_t * const pxList, ListItem_t * const pxNewListItem ) /
  */
 UBaseType_t uxListRemove( ListItem_t * const pxItemToRemove ) /*PRIVILEGED_FUNCTION*/;
 
+/*-----------------------------------------------------------
+ * COMPACT INDEXED LISTS
+ *----------------------------------------------------------*/
+
+/*
+ * A compact variant of the list for objects that are allocated from a pool
+ * (an array).  The links are 32-bit indices into an array of IndexListItem_t
+ * rather than pointers, and no owner pointer is stored - the owner is the
+ * element of the pool with the same index as the item.  An item is therefore
+ * 16 bytes on every target instead of the 40 bytes a ListItem_t occupies on a
+ * 64-bit target, and a walk of the list only touches the densely packed item
+ * array.
+ *
+ * A list is identified by the index of its end marker, which occupies a slot
+ * of the same item array so the links can refer to it.  The end marker holds
+ * portMAX_DELAY as its value, exactly as xListEnd does, and its ulContainer
+ * member is used to hold the number of items in the list.
+ */
+typedef uint32_t ListIndex_t;
+
+/* The ulContainer value of an item that is not in any list. */
+#define listINDEX_NONE ( ( ListIndex_t ) 0xffffffffUL )
+
+struct xINDEX_LIST_ITEM
+{
+	configLIST_VOLATILE TickType_t xItemValue;			/*< The value being listed. */
+	configLIST_VOLATILE ListIndex_t ulNext;				/*< Index of the next item in the list. */
+	configLIST_VOLATILE ListIndex_t ulPrevious;			/*< Index of the previous item in the list. */
+	configLIST_VOLATILE ListIndex_t ulContainer;		/*< Index of the end marker of the list the item is in, or listINDEX_NONE.  The number of items for an end marker. */
+};
+typedef struct xINDEX_LIST_ITEM IndexListItem_t;
+
+/*
+ * Access macro to obtain the owner at index ulIndex of an owner array that
+ * starts at pvOwnerBase and whose elements are xStride bytes apart.  A pool
+ * that keeps its end markers at the start of the item array subtracts the
+ * number of end markers from the item index first.
+ */
+#define listINDEX_GET_OWNER( pvOwnerBase, xStride, ulIndex ) ( ( void * ) ( ( ( uint8_t * ) ( pvOwnerBase ) ) + ( ( size_t ) ( ulIndex ) * ( size_t ) ( xStride ) ) ) )
+
+#define listINDEX_SET_LIST_ITEM_VALUE( pxPool, ulItem, xValue )	( ( pxPool )[ ( ulItem ) ].xItemValue = ( xValue ) )
+#define listINDEX_GET_LIST_ITEM_VALUE( pxPool, ulItem )			( ( pxPool )[ ( ulItem ) ].xItemValue )
+#define listINDEX_GET_HEAD_ENTRY( pxPool, ulList )					( ( pxPool )[ ( ulList ) ].ulNext )
+#define listINDEX_GET_ITEM_VALUE_OF_HEAD_ENTRY( pxPool, ulList )	( ( pxPool )[ ( pxPool )[ ( ulList ) ].ulNext ].xItemValue )
+#define listINDEX_GET_ITEM_VALUE_OF_TAIL_ENTRY( pxPool, ulList )	( ( pxPool )[ ( pxPool )[ ( ulList ) ].ulPrevious ].xItemValue )
+#define listINDEX_LIST_IS_EMPTY( pxPool, ulList )					( ( BaseType_t ) ( ( pxPool )[ ( ulList ) ].ulContainer == ( ListIndex_t ) 0 ) )
+#define listINDEX_CURRENT_LIST_LENGTH( pxPool, ulList )			( ( pxPool )[ ( ulList ) ].ulContainer )
+#define listINDEX_LIST_ITEM_CONTAINER( pxPool, ulItem )			( ( pxPool )[ ( ulItem ) ].ulContainer )
+#define listINDEX_IS_CONTAINED_WITHIN( pxPool, ulList, ulItem )	( ( BaseType_t ) ( ( pxPool )[ ( ulItem ) ].ulContainer == ( ulList ) ) )
+
+/*
+ * Initialise the end marker at index ulList of pxPool as an empty list.
+ */
+void vIndexListInitialise( IndexListItem_t * const pxPool, const ListIndex_t ulList ) /*PRIVILEGED_FUNCTION*/;
+
+/*
+ * Mark the item at index ulItem of pxPool as not being in any list.
+ */
+void vIndexListInitialiseItem( IndexListItem_t * const pxPool, const ListIndex_t ulItem ) /*PRIVILEGED_FUNCTION*/;
+
+/*
+ * The indexed equivalent of vListInsert() - insert the item at index ulNewItem
+ * into the list whose end marker is at index ulList, in item value order.
+ */
+void vIndexListInsert( IndexListItem_t * const pxPool, const ListIndex_t ulList, const ListIndex_t ulNewItem ) /*PRIVILEGED_FUNCTION*/;
+UBaseType_t uxIndexListInsert( IndexListItem_t * const pxPool, const ListIndex_t ulList, const ListIndex_t ulNewItem ) /*PRIVILEGED_FUNCTION*/;
+
+/*
+ * Append the item at index ulNewItem to the end of the list whose end marker
+ * is at index ulList, without sorting, as vListInsertEnd() does for a list
+ * that is never walked with listGET_OWNER_OF_NEXT_ENTRY().
+ */
+void vIndexListInsertEnd( IndexListItem_t * const pxPool, const ListIndex_t ulList, const ListIndex_t ulNewItem ) /*PRIVILEGED_FUNCTION*/;
+
+/*
+ * The indexed equivalent of uxListRemove().
+ *
+ * @return The number of items that remain in the list after the list item has
+ * been removed.
+ */
+UBaseType_t uxIndexListRemove( IndexListItem_t * const pxPool, const ListIndex_t ulItemToRemove ) /*PRIVILEGED_FUNCTION*/;
+
 #ifdef __cplusplus
 }
 #endif
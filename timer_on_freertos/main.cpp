@@ -4,6 +4,10 @@
 #include "list.h"
 #include "task.h"
 
+/* timer_bench.cpp, main_test.cpp or timer_trace_convert.cpp provides main()
+instead. */
+#if (configTIMER_BENCHMARK == 0) && (configTIMER_SELF_TEST == 0) && (configTIMER_TRACE_CONVERTER == 0)
+
 /* The periods assigned to the one-shot and auto-reload timers respectively. */
 #define mainONE_SHOT_TIMER_PERIOD (pdMS_TO_TICKS(3333UL))
 
@@ -11,7 +15,7 @@ static void prvOneShotTimerCallback(TimerHandle_t xTimer);
 
 int main() {
 
-    timer_t timer1;
+    LightweightTimer_t timer1;
     timer1.tick_count = 50;
     // timer1.callback = CB;
 
@@ -64,3 +68,5 @@ static void prvOneShotTimerCallback(TimerHandle_t xTimer) {
     /* Output a string to show the time at which the callback was executed. */
     printf("One-shot timer callback executing %d\n", xTimeNow);
 }
+
+#endif /* configTIMER_BENCHMARK, configTIMER_SELF_TEST, configTIMER_TRACE_CONVERTER */
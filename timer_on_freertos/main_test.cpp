@@ -1,18 +1,1116 @@
-#if 0 
+#include "uds.h"
+
+#if (configTIMER_SELF_TEST == 1)
+
+#include "task.h"
+#include "timer.h"
+#include "timer_capture.h"
+#include "timer_coroutine.h"
+#include "timer_pdes.h"
+#include "timer_rate_limiter.h"
 #include <stdio.h>
-#include <Windows.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+/*
+ * Self checks of the timer service, built instead of main.cpp when
+ * configTIMER_SELF_TEST is 1.  The kernel cannot be restarted, so each check
+ * runs in a process of its own, named on the command line:
+ *
+ *   uds_test virtual_time
+ *
+ * The process exits with 0 if the check passed.  CMakeLists.txt registers
+ * every check with CTest.  The coroutine check is only built by the C++20
+ * target, uds_test_cxx20.  snapshot_restore reads the file snapshot_save
+ * writes, and is also run by uds_test_slow_tick, built at another tick rate.
+ */
+
+#if (configUSE_VIRTUAL_TIME == 0)
+    #error configTIMER_SELF_TEST needs configUSE_VIRTUAL_TIME to drive the tick from the checks
+#endif
+
+/* The virtual time check runs an hour of three auto-reload timers and a
+one-shot timer that restarts itself a few times. */
+#define testHOUR_TICKS (pdMS_TO_TICKS(3600000UL))
+#define testONE_SHOT_PERIOD ((TickType_t)1000U)
+#define testONE_SHOT_CALLS 5UL
+#define testHOUR_TIMERS 4U
+
+/* The catch-up check stalls the timer service task in a callback
+testSTALL_AT ticks after starting its timers, for testSTALL_TICKS ticks. */
+#define testCATCH_UP_PERIOD ((TickType_t)100U)
+#define testSTALL_AT ((TickType_t)50U)
+#define testSTALL_TICKS ((TickType_t)1000U)
+#define testCATCH_UP_TIMERS 3U
+
+/* The number of periods the stall holds each catch-up timer up by. */
+#define testPERIODS_DUE ((testSTALL_AT + testSTALL_TICKS) / testCATCH_UP_PERIOD)
+
+/* Close enough to the tick count wrapping that the stall crosses it. */
+#define testWRAP_START ((TickType_t)(portMAX_DELAY - (TickType_t)0xFFU))
+
+/* The PDES check runs the same network of testPDES_PROCESSES processes of
+testPDES_ECUS timers each once for every entry of uxPdesWorkers. */
+#define testPDES_PROCESSES 4U
+#define testPDES_ECUS 100U
+#define testPDES_RUNS 3U
+#define testPDES_LOOKAHEAD ((TickType_t)5U)
+#define testPDES_END_TIME 20000ULL
+
+typedef struct {
+    const char *pcName;
+    BaseType_t (*pxCheck)(void);
+} TestCheck_t;
+
+/* The timers of one run of the virtual time scenario. */
+typedef struct {
+    TimerDomainHandle_t xDomain;
+    uint32_t ulCalls[testHOUR_TIMERS];
+    uint64_t ullHash; /*<< Of the order and tick of every callback. */
+} TestScenario_t;
+
+typedef struct {
+    TestScenario_t *pxScenario;
+    UBaseType_t uxIndex;
+} TestTimer_t;
+
+static const TickType_t xHourPeriods[testHOUR_TIMERS] = {(TickType_t)1U, (TickType_t)7U, (TickType_t)13U,
+                                                         testONE_SHOT_PERIOD};
+
+static std::atomic<BaseType_t> xStalled(pdFALSE);
+static std::atomic<BaseType_t> xReleased(pdFALSE);
+static uint32_t ulCatchUpCalls[testCATCH_UP_TIMERS];
+static UBaseType_t uxCatchUpMissed[testCATCH_UP_TIMERS];
+
+#if (configUSE_TIMER_PDES == 1)
+/* What one run of the network did in each logical process. */
+typedef struct {
+    PdesEngineHandle_t xEngine;
+    uint32_t ulCalls[testPDES_PROCESSES];
+    uint32_t ulEvents[testPDES_PROCESSES];
+    uint64_t ullHashes[testPDES_PROCESSES]; /*<< Of the order and time of every callback and event. */
+} TestPdesRun_t;
+
+typedef struct {
+    TestPdesRun_t *pxRun;
+    UBaseType_t uxProcess;
+    UBaseType_t uxEcu;
+} TestPdesTimer_t;
+
+static const UBaseType_t uxPdesWorkers[testPDES_RUNS] = {1U, 2U, 4U};
+#endif
+
+#if (configUSE_TIMER_SNAPSHOT == 1)
+/* The snapshot checks save testSNAPSHOT_TIMERS timers testSNAPSHOT_SAVED_AT
+ticks after starting them, at testSNAPSHOT_TICK_RATE_HZ, and restore them and
+run them for testSNAPSHOT_RUN_TICKS at that rate, rescaled to the tick rate of
+the restoring build. */
+#define testSNAPSHOT_FILE "uds_test.snap"
+#define testSNAPSHOT_TICK_RATE_HZ 100U
+#define testSNAPSHOT_TIMERS 6U
+#define testSNAPSHOT_SAVED_AT ((TickType_t)30U)
+#define testSNAPSHOT_RUN_TICKS ((TickType_t)1000U)
+#define testSNAPSHOT_TICKS(xTicks) \
+    ((TickType_t)(((uint64_t)(xTicks) * configTICK_RATE_HZ) / testSNAPSHOT_TICK_RATE_HZ))
+
+/* Timers 1 and 2 expire on the same tick, so must be restored in the order
+they were saved in.  The even ones are auto-reload. */
+static const TickType_t xSnapshotPeriods[testSNAPSHOT_TIMERS] = {(TickType_t)130U, (TickType_t)70U,
+                                                                 (TickType_t)70U,  (TickType_t)250U,
+                                                                 (TickType_t)90U,  (TickType_t)1000U};
+
+static uint32_t ulSnapshotCalls[testSNAPSHOT_TIMERS];
+static TickType_t xSnapshotFirstCall[testSNAPSHOT_TIMERS];
+static UBaseType_t uxSnapshotOrder[testSNAPSHOT_TIMERS];
+static UBaseType_t uxSnapshotFirstCalls = 0U;
+static UBaseType_t uxSnapshotRestored = 0U;
+#endif
+
+#if (configUSE_TIMER_CAPTURE == 1)
+/* The capture check captures calls on testCAPTURE_TIMERS timers, replays them
+while capturing the replay, and compares the two captures. */
+#define testCAPTURE_FILE "uds_test.capture"
+#define testREPLAY_CAPTURE_FILE "uds_test_replay.capture"
+#define testCAPTURE_TIMERS 5U
+#define testCAPTURE_MAX_RECORDS 64U
+#define testCAPTURE_TICKS ((TickType_t)20U)
+#endif
+
+/* The rate limiter check refills a bucket of testRATE_BUCKET tokens by one
+token a tick, queueing the requests of xRateRequestTokens while it is empty. */
+#define testRATE_BUCKET 4U
+#define testRATE_REQUESTS 4U
+#define testRATE_IDLE_TICKS ((TickType_t)100U)
+
+static const uint32_t ulRateRequestTokens[testRATE_REQUESTS] = {2U, 1U, 3U, 1U};
+
+/* The tick, counted from emptying the bucket, each request is granted at. */
+static const TickType_t xRateGrantTicks[testRATE_REQUESTS] = {(TickType_t)2U, (TickType_t)3U, (TickType_t)6U,
+                                                              (TickType_t)7U};
+
+static UBaseType_t uxRateGrants = 0U;
+static UBaseType_t uxRateGrantOrder[testRATE_REQUESTS + 1U];
+static TickType_t xRateGrantedAt[testRATE_REQUESTS + 1U];
+
+#if defined(__cpp_impl_coroutine)
+/* The coroutine check sleeps for testSLEEP_TICKS, and gives operations taking
+testFAST_TICKS and testSLOW_TICKS testTIMEOUT_TICKS to finish. */
+#define testSLEEP_TICKS ((TickType_t)10U)
+#define testFAST_TICKS ((TickType_t)5U)
+#define testSLOW_TICKS ((TickType_t)50U)
+#define testTIMEOUT_TICKS ((TickType_t)20U)
+#define testOPERATION_RESULT 42
+
+/* What one of the coroutines saw when it carried on. */
+typedef struct {
+    BaseType_t xResumed;
+    BaseType_t xHasResult;
+    int iResult;
+    TickType_t xTick;
+} TestAwait_t;
+#endif
+
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+static uint32_t ulPendedCallsRun = 0U;
+static BaseType_t xPendedCallsInOrder = pdTRUE;
+#endif
+
+static BaseType_t prvExpect(const char *const pcWhat, const uint64_t ullValue, const uint64_t ullExpected) {
+    if (ullValue != ullExpected) {
+        printf("%s is %llu, expected %llu\n", pcWhat, (unsigned long long)ullValue,
+               (unsigned long long)ullExpected);
+        return pdFAIL;
+    }
+
+    return pdPASS;
+}
+
+static void prvHourCallback(TimerHandle_t xTimer) {
+    const TestTimer_t *const pxTestTimer = (const TestTimer_t *)pvTimerGetTimerID(xTimer);
+    TestScenario_t *const pxScenario = pxTestTimer->pxScenario;
+
+    pxScenario->ulCalls[pxTestTimer->uxIndex]++;
+    pxScenario->ullHash = (pxScenario->ullHash * 31U) + ((uint64_t)pxTestTimer->uxIndex * 1000003U) +
+                          (uint64_t)xTimerDomainGetTickCount(pxScenario->xDomain);
+
+    /* The one-shot timer restarts itself until it has been called
+    testONE_SHOT_CALLS times. */
+    if ((pxTestTimer->uxIndex == (testHOUR_TIMERS - 1U)) &&
+        (pxScenario->ulCalls[pxTestTimer->uxIndex] < testONE_SHOT_CALLS)) {
+        (void)xTimerChangePeriod(xTimer, testONE_SHOT_PERIOD, 0);
+    }
+}
+
+/* Run an hour of the scenario in xDomain and stop its timers again. */
+static void prvRunHour(TestScenario_t *const pxScenario, TestTimer_t *const pxTestTimers) {
+    TimerHandle_t xTimers[testHOUR_TIMERS];
+    UBaseType_t x;
+
+    for (x = 0U; x < testHOUR_TIMERS; x++) {
+        pxTestTimers[x].pxScenario = pxScenario;
+        pxTestTimers[x].uxIndex    = x;
+        xTimers[x] = xTimerCreateInDomain(pxScenario->xDomain, "Hour", xHourPeriods[x],
+                                          (x < (testHOUR_TIMERS - 1U)) ? pdTRUE : pdFALSE, &(pxTestTimers[x]),
+                                          prvHourCallback);
+        configASSERT(xTimers[x]);
+        (void)xTimerStart(xTimers[x], 0);
+    }
+
+    (void)xTimerDomainAdvanceTime(pxScenario->xDomain, testHOUR_TICKS);
+
+    for (x = 0U; x < testHOUR_TIMERS; x++) {
+        (void)xTimerStop(xTimers[x], 0);
+    }
+    vTimerDomainWaitUntilIdle(pxScenario->xDomain);
+}
+
+/*
+ * An hour of virtual time runs in seconds, calls every callback the number of
+ * times the periods give, and calls them in the same order on the same ticks
+ * in the default domain as in a domain of its own.
+ */
+static BaseType_t prvCheckVirtualTime(void) {
+    static const TimerDomainParameters_t xParameters = {"Hour", 0U, 0U};
+    static TestScenario_t xScenarios[2];
+    static TestTimer_t xTestTimers[2][testHOUR_TIMERS];
+    BaseType_t xResult = pdPASS;
+    UBaseType_t uxScenario;
+    UBaseType_t x;
+    char cWhat[64];
+    const std::chrono::steady_clock::time_point xStart = std::chrono::steady_clock::now();
+
+    CreateTimerManageTask();
+
+    xScenarios[0].xDomain = xTimerGetDefaultDomain();
+    xScenarios[1].xDomain = xTimerDomainCreate(&xParameters);
+    configASSERT(xScenarios[1].xDomain);
+    (void)xTimerDomainStart(xScenarios[1].xDomain);
+
+    for (uxScenario = 0U; uxScenario < 2U; uxScenario++) {
+        prvRunHour(&(xScenarios[uxScenario]), xTestTimers[uxScenario]);
+
+        snprintf(cWhat, sizeof(cWhat), "tick count of run %u", (unsigned)uxScenario);
+        if (prvExpect(cWhat, xTimerDomainGetTickCount(xScenarios[uxScenario].xDomain), testHOUR_TICKS) == pdFAIL) {
+            xResult = pdFAIL;
+        }
+
+        for (x = 0U; x < testHOUR_TIMERS; x++) {
+            snprintf(cWhat, sizeof(cWhat), "calls of timer %u in run %u", (unsigned)x, (unsigned)uxScenario);
+            if (prvExpect(cWhat, xScenarios[uxScenario].ulCalls[x],
+                          (x < (testHOUR_TIMERS - 1U)) ? (testHOUR_TICKS / xHourPeriods[x]) : testONE_SHOT_CALLS) ==
+                pdFAIL) {
+                xResult = pdFAIL;
+            }
+        }
+    }
+
+    if (prvExpect("hash of the second run", xScenarios[1].ullHash, xScenarios[0].ullHash) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    printf("virtual_time: 2 x %u ticks in %lld ms, hash %016llx\n", (unsigned)testHOUR_TICKS,
+           (long long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - xStart)
+               .count(),
+           (unsigned long long)xScenarios[0].ullHash);
+
+    return xResult;
+}
+
+static void prvCatchUpCallback(TimerHandle_t xTimer) {
+    const UBaseType_t uxIndex = (UBaseType_t)(uintptr_t)pvTimerGetTimerID(xTimer);
+
+    ulCatchUpCalls[uxIndex]++;
+    uxCatchUpMissed[uxIndex] = uxTimerGetMissedPeriods(xTimer);
+}
+
+static void prvStallCallback(TimerHandle_t xTimer) {
+    (void)xTimer;
+
+    xStalled.store(pdTRUE);
+    while (xReleased.load() == pdFALSE) {
+        std::this_thread::yield();
+    }
+}
+
+static void prvAdvanceToStall(void) {
+    (void)xTimerDomainAdvanceToNextWake(NULL);
+}
+
+/*
+ * Start the catch-up timers at xStartTick, hold the timer service task in a
+ * callback until testPERIODS_DUE of their periods have passed, and check what
+ * each policy called.
+ */
+static BaseType_t prvStallTimers(TimerHandle_t *const pxTimers, TimerHandle_t xStallTimer,
+                                 const TickType_t xStartTick) {
+    static const uint32_t ulCallsAfterStall[testCATCH_UP_TIMERS] = {(uint32_t)testPERIODS_DUE, 1U, 1U};
+    static const UBaseType_t uxMissedAfterStall[testCATCH_UP_TIMERS] = {0U, 0U, (UBaseType_t)testPERIODS_DUE - 1U};
+    BaseType_t xResult = pdPASS;
+    TickType_t xTick;
+    UBaseType_t x;
+    char cWhat[64];
+
+    (void)xTimerDomainAdvanceTime(NULL, (TickType_t)(xStartTick - xTaskGetTickCount()));
+
+    memset(ulCatchUpCalls, 0, sizeof(ulCatchUpCalls));
+    xStalled.store(pdFALSE);
+    xReleased.store(pdFALSE);
+
+    for (x = 0U; x < testCATCH_UP_TIMERS; x++) {
+        (void)xTimerStart(pxTimers[x], 0);
+    }
+    (void)xTimerStart(xStallTimer, 0);
+
+    /* The harness waits for the stalled task, so it is moved on from here
+    instead, as a long callback or a starved task would find it. */
+    std::thread xHarness(prvAdvanceToStall);
+    while (xStalled.load() == pdFALSE) {
+        std::this_thread::yield();
+    }
+    for (xTick = 0U; xTick < testSTALL_TICKS; xTick++) {
+        (void)xTickSourceIncrement(pxTaskGetTickSource());
+    }
+    xReleased.store(pdTRUE);
+    xHarness.join();
+    vTimerDomainWaitUntilIdle(NULL);
+
+    for (x = 0U; x < testCATCH_UP_TIMERS; x++) {
+        snprintf(cWhat, sizeof(cWhat), "calls of policy %u from tick %u", (unsigned)x, (unsigned)xStartTick);
+        if (prvExpect(cWhat, ulCatchUpCalls[x], ulCallsAfterStall[x]) == pdFAIL) {
+            xResult = pdFAIL;
+        }
+
+        snprintf(cWhat, sizeof(cWhat), "missed periods of policy %u from tick %u", (unsigned)x, (unsigned)xStartTick);
+        if (prvExpect(cWhat, uxCatchUpMissed[x], uxMissedAfterStall[x]) == pdFAIL) {
+            xResult = pdFAIL;
+        }
+    }
+
+    /* Every policy keeps the timers in phase, so each is called once more
+    a period on. */
+    (void)xTimerDomainAdvanceTime(NULL, testCATCH_UP_PERIOD);
+
+    for (x = 0U; x < testCATCH_UP_TIMERS; x++) {
+        snprintf(cWhat, sizeof(cWhat), "calls of policy %u a period on from tick %u", (unsigned)x,
+                 (unsigned)xStartTick);
+        if (prvExpect(cWhat, ulCatchUpCalls[x], ulCallsAfterStall[x] + 1U) == pdFAIL) {
+            xResult = pdFAIL;
+        }
+
+        (void)xTimerStop(pxTimers[x], 0);
+    }
+    vTimerDomainWaitUntilIdle(NULL);
+
+    return xResult;
+}
+
+/*
+ * Each catch-up policy calls its timer as documented after a stall, both
+ * away from and across the tick count wrapping.
+ */
+static BaseType_t prvCheckCatchUp(void) {
+    static const UBaseType_t uxPolicies[testCATCH_UP_TIMERS] = {tmrCATCH_UP_FIRE_ALL, tmrCATCH_UP_SKIP,
+                                                                tmrCATCH_UP_SKIP_AND_COUNT};
+    TimerHandle_t xTimers[testCATCH_UP_TIMERS];
+    TimerHandle_t xStallTimer;
+    BaseType_t xResult = pdPASS;
+    UBaseType_t x;
+
+    for (x = 0U; x < testCATCH_UP_TIMERS; x++) {
+        xTimers[x] = xTimerCreate("CatchUp", testCATCH_UP_PERIOD, pdTRUE, (void *)(uintptr_t)x, prvCatchUpCallback);
+        configASSERT(xTimers[x]);
+        vTimerSetCatchUpPolicy(xTimers[x], uxPolicies[x]);
+    }
+    xStallTimer = xTimerCreate("Stall", testSTALL_AT, pdFALSE, NULL, prvStallCallback);
+    configASSERT(xStallTimer);
+
+    CreateTimerManageTask();
+
+    if (prvStallTimers(xTimers, xStallTimer, (TickType_t)0x1000U) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    if (prvStallTimers(xTimers, xStallTimer, testWRAP_START) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    return xResult;
+}
+
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+
+static void prvPendedFunction(void *pvParameter1, uint32_t ulParameter2) {
+    (void)pvParameter1;
+
+    if (ulParameter2 != ulPendedCallsRun) {
+        xPendedCallsInOrder = pdFALSE;
+    }
+    ulPendedCallsRun++;
+}
+
+/*
+ * A full queue of pended calls rejects and counts further calls, and every
+ * call it accepted is run, in order, once the timer service task starts.
+ */
+static BaseType_t prvCheckPendedCallsFull(void) {
+    BaseType_t xResult = pdPASS;
+    uint32_t ulPended = 0U;
+
+    /* Nothing runs the calls before the timer service task starts. */
+    while ((ulPended <= (uint32_t)configTIMER_PEND_QUEUE_LENGTH) &&
+           (xTimerPendFunctionCallFromISR(prvPendedFunction, NULL, ulPended, NULL) == pdPASS)) {
+        ulPended++;
+    }
+
+    if (prvExpect("calls accepted", ulPended, configTIMER_PEND_QUEUE_LENGTH) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+    if (prvExpect("calls rejected from an interrupt", uxTimerGetPendedFunctionCallsRejected(), 1U) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    if (prvExpect("result of a task call", (uint64_t)xTimerPendFunctionCall(prvPendedFunction, NULL, ulPended, 0),
+                  (uint64_t)pdFAIL) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+    if (prvExpect("calls rejected", uxTimerGetPendedFunctionCallsRejected(), 2U) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    CreateTimerManageTask();
+    vTimerDomainWaitUntilIdle(NULL);
+
+    if (prvExpect("calls run", ulPendedCallsRun, ulPended) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    /* There is room again. */
+    if (prvExpect("result of a call after the queue drained",
+                  (uint64_t)xTimerPendFunctionCall(prvPendedFunction, NULL, ulPended, 0), (uint64_t)pdPASS) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+    vTimerDomainWaitUntilIdle(NULL);
+
+    if (prvExpect("calls run after the queue drained", ulPendedCallsRun, ulPended + 1U) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+    if (prvExpect("calls run in order", (uint64_t)xPendedCallsInOrder, (uint64_t)pdTRUE) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    return xResult;
+}
+
+#endif /* INCLUDE_xTimerPendFunctionCall */
+
+#if (configUSE_TIMER_PDES == 1)
+
+static void prvPdesEvent(UBaseType_t uxLogicalProcess, void *pvParameter, uint32_t ulParameter) {
+    TestPdesRun_t *const pxRun = (TestPdesRun_t *)pvParameter;
+
+    pxRun->ulEvents[uxLogicalProcess]++;
+    pxRun->ullHashes[uxLogicalProcess] = (pxRun->ullHashes[uxLogicalProcess] * 1000003U) ^
+                                         ((ullPdesGetTime(pxRun->xEngine, uxLogicalProcess) * 7U) + ulParameter);
+}
+
+/* Every tenth ECU sends an event to the next process each time it is called. */
+static void prvPdesCallback(TimerHandle_t xTimer) {
+    const TestPdesTimer_t *const pxPdesTimer = (const TestPdesTimer_t *)pvTimerGetTimerID(xTimer);
+    TestPdesRun_t *const pxRun = pxPdesTimer->pxRun;
+    const UBaseType_t uxProcess = pxPdesTimer->uxProcess;
+
+    pxRun->ulCalls[uxProcess]++;
+    pxRun->ullHashes[uxProcess] = (pxRun->ullHashes[uxProcess] * 31U) + ((uint64_t)pxPdesTimer->uxEcu * 131U) +
+                                  ullPdesGetTime(pxRun->xEngine, uxProcess);
+
+    if ((pxPdesTimer->uxEcu % 10U) == 0U) {
+        (void)xPdesSend(pxRun->xEngine, uxProcess, (uxProcess + 1U) % testPDES_PROCESSES,
+                        testPDES_LOOKAHEAD + (TickType_t)(pxPdesTimer->uxEcu % 7U), prvPdesEvent, pxRun,
+                        (uint32_t)pxPdesTimer->uxEcu);
+    }
+}
+
+/* Build the network on an engine of uxWorkers threads and run it, returning
+the number of windows run. */
+static uint64_t prvRunPdesNetwork(TestPdesRun_t *const pxRun, TestPdesTimer_t *const pxPdesTimers,
+                                  const UBaseType_t uxWorkers) {
+    static const TimerDomainParameters_t xParameters = {"Partition", 0U, 0U};
+    TimerDomainHandle_t xDomain;
+    TimerHandle_t xTimer;
+    UBaseType_t uxProcess;
+    UBaseType_t uxEcu;
+    TestPdesTimer_t *pxPdesTimer;
+
+    pxRun->xEngine = xPdesCreate(uxWorkers, testPDES_LOOKAHEAD);
+    configASSERT(pxRun->xEngine);
+
+    for (uxProcess = 0U; uxProcess < testPDES_PROCESSES; uxProcess++) {
+        xDomain = xTimerDomainCreate(&xParameters);
+        configASSERT(xDomain);
+        (void)xTimerDomainStart(xDomain);
+        (void)xPdesAddLogicalProcess(pxRun->xEngine, xDomain, &uxProcess);
+
+        for (uxEcu = 0U; uxEcu < testPDES_ECUS; uxEcu++) {
+            pxPdesTimer            = &(pxPdesTimers[(uxProcess * testPDES_ECUS) + uxEcu]);
+            pxPdesTimer->pxRun     = pxRun;
+            pxPdesTimer->uxProcess = uxProcess;
+            pxPdesTimer->uxEcu     = uxEcu;
+
+            xTimer = xTimerCreateInDomain(xDomain, "Ecu", (TickType_t)(10U + (((uxEcu * 7U) + uxProcess) % 50U)),
+                                          pdTRUE, pxPdesTimer, prvPdesCallback);
+            configASSERT(xTimer);
+            (void)xTimerStart(xTimer, portMAX_DELAY);
+        }
+    }
+
+    return ullPdesRun(pxRun->xEngine, testPDES_END_TIME);
+}
 
-#pragma comment(lib, "winmm.lib")
+/*
+ * The parallel engine gives the same callbacks and events, in the same order
+ * at the same virtual times, whatever the number of worker threads.
+ */
+static BaseType_t prvCheckPdesWorkers(void) {
+    static TestPdesRun_t xRuns[testPDES_RUNS];
+    static TestPdesTimer_t xPdesTimers[testPDES_RUNS][testPDES_PROCESSES * testPDES_ECUS];
+    BaseType_t xResult = pdPASS;
+    UBaseType_t uxRun;
+    UBaseType_t uxProcess;
+    uint64_t ullWindows;
+    char cWhat[80];
+    std::chrono::steady_clock::time_point xStart;
 
-static void* pvInterruptEventMutex = NULL;
+    CreateTimerManageTask();
 
-int main() {
+    for (uxRun = 0U; uxRun < testPDES_RUNS; uxRun++) {
+        xStart     = std::chrono::steady_clock::now();
+        ullWindows = prvRunPdesNetwork(&(xRuns[uxRun]), xPdesTimers[uxRun], uxPdesWorkers[uxRun]);
 
-	pvInterruptEventMutex = CreateMutex(NULL, FALSE, NULL);
-	if (pvInterruptEventMutex != NULL) {
-		WaitForSingleObject(pvInterruptEventMutex, INFINITE);
-	}
+        printf("pdes_workers: %u workers, %llu windows in %lld ms, %lu callbacks and %lu events in process 0, hash "
+               "%016llx\n",
+               (unsigned)uxPdesWorkers[uxRun], (unsigned long long)ullWindows,
+               (long long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                                xStart)
+                   .count(),
+               (unsigned long)xRuns[uxRun].ulCalls[0], (unsigned long)xRuns[uxRun].ulEvents[0],
+               (unsigned long long)xRuns[uxRun].ullHashes[0]);
 
-	return 0;
+        for (uxProcess = 0U; uxProcess < testPDES_PROCESSES; uxProcess++) {
+            snprintf(cWhat, sizeof(cWhat), "time of process %u with %u workers", (unsigned)uxProcess,
+                     (unsigned)uxPdesWorkers[uxRun]);
+            if (prvExpect(cWhat, ullPdesGetTime(xRuns[uxRun].xEngine, uxProcess), testPDES_END_TIME) == pdFAIL) {
+                xResult = pdFAIL;
+            }
+
+            /* The first run is the reference for the others. */
+            if (uxRun == 0U) {
+                if (xRuns[0].ulEvents[uxProcess] == 0U) {
+                    printf("process %u received no events\n", (unsigned)uxProcess);
+                    xResult = pdFAIL;
+                }
+                continue;
+            }
+
+            snprintf(cWhat, sizeof(cWhat), "callbacks of process %u with %u workers", (unsigned)uxProcess,
+                     (unsigned)uxPdesWorkers[uxRun]);
+            if (prvExpect(cWhat, xRuns[uxRun].ulCalls[uxProcess], xRuns[0].ulCalls[uxProcess]) == pdFAIL) {
+                xResult = pdFAIL;
+            }
+
+            snprintf(cWhat, sizeof(cWhat), "events of process %u with %u workers", (unsigned)uxProcess,
+                     (unsigned)uxPdesWorkers[uxRun]);
+            if (prvExpect(cWhat, xRuns[uxRun].ulEvents[uxProcess], xRuns[0].ulEvents[uxProcess]) == pdFAIL) {
+                xResult = pdFAIL;
+            }
+
+            snprintf(cWhat, sizeof(cWhat), "hash of process %u with %u workers", (unsigned)uxProcess,
+                     (unsigned)uxPdesWorkers[uxRun]);
+            if (prvExpect(cWhat, xRuns[uxRun].ullHashes[uxProcess], xRuns[0].ullHashes[uxProcess]) == pdFAIL) {
+                xResult = pdFAIL;
+            }
+        }
+
+        vPdesDelete(xRuns[uxRun].xEngine);
+    }
+
+    return xResult;
+}
+
+#endif /* configUSE_TIMER_PDES */
+
+#if (configUSE_TIMER_SNAPSHOT == 1)
+
+static void prvSnapshotCallback(TimerHandle_t xTimer) {
+    const UBaseType_t uxIndex = (UBaseType_t)(uintptr_t)pvTimerGetTimerID(xTimer);
+
+    if (ulSnapshotCalls[uxIndex] == 0U) {
+        xSnapshotFirstCall[uxIndex] = xTaskGetTickCount();
+        uxSnapshotOrder[uxIndex]    = uxSnapshotFirstCalls++;
+    }
+    ulSnapshotCalls[uxIndex]++;
+}
+
+/* Not listed in the snapshot parameters, so its timer is not saved. */
+static void prvUnsavedCallback(TimerHandle_t xTimer) {
+    (void)xTimer;
+}
+
+static void prvSnapshotRestored(TimerHandle_t xTimer) {
+    (void)xTimer;
+    uxSnapshotRestored++;
+}
+
+static const TimerCallbackFunction_t xSnapshotCallbacks[] = {prvSnapshotCallback};
+static const TimerSnapshotParameters_t xSnapshotParameters = {testSNAPSHOT_FILE, xSnapshotCallbacks, 1U,
+                                                              prvSnapshotRestored};
+
+/*
+ * Save the snapshot snapshot_restore reads, with the timers part way through
+ * their first periods and one timer whose callback is not listed.
+ */
+static BaseType_t prvCheckSnapshotSave(void) {
+    TimerHandle_t xTimer;
+    UBaseType_t x;
+    BaseType_t xResult = pdPASS;
+
+    CreateTimerManageTask();
+
+    if (prvExpect("tick rate", configTICK_RATE_HZ, testSNAPSHOT_TICK_RATE_HZ) == pdFAIL) {
+        return pdFAIL;
+    }
+
+    for (x = 0U; x < testSNAPSHOT_TIMERS; x++) {
+        xTimer = xTimerCreate("Snapshot", xSnapshotPeriods[x], ((x % 2U) == 0U) ? pdTRUE : pdFALSE,
+                              (void *)(uintptr_t)x, prvSnapshotCallback);
+        configASSERT(xTimer);
+        (void)xTimerStart(xTimer, 0);
+    }
+    xTimer = xTimerCreate("Unsaved", (TickType_t)50U, pdFALSE, NULL, prvUnsavedCallback);
+    configASSERT(xTimer);
+    (void)xTimerStart(xTimer, 0);
+
+    (void)xTimerDomainAdvanceTime(NULL, testSNAPSHOT_SAVED_AT);
+    vTimerDomainWaitUntilIdle(NULL);
+
+    if (prvExpect("snapshot save", (uint64_t)xTimerSnapshotSave(&xSnapshotParameters), (uint64_t)pdPASS) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    return xResult;
+}
+
+/*
+ * Restore the timers snapshot_save saved and check each expires after the
+ * ticks it had left, rescaled to the tick rate of this build, and carries on
+ * with its period rescaled, with the timers that expire together in the order
+ * they were saved in.
+ */
+static BaseType_t prvCheckSnapshotRestore(void) {
+    UBaseType_t uxRestored = 0U;
+    BaseType_t xResult = pdPASS;
+    TickType_t xFirstCall;
+    TickType_t xPeriod;
+    uint32_t ulCalls;
+    UBaseType_t x;
+    char cWhat[64];
+
+    if (prvExpect("snapshot restore", (uint64_t)xTimerSnapshotRestore(&xSnapshotParameters, &uxRestored),
+                  (uint64_t)pdPASS) == pdFAIL) {
+        return pdFAIL;
+    }
+    if (prvExpect("timers restored", uxRestored, testSNAPSHOT_TIMERS) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+    if (prvExpect("restored timer calls", uxSnapshotRestored, testSNAPSHOT_TIMERS) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    CreateTimerManageTask();
+    (void)xTimerDomainAdvanceTime(NULL, testSNAPSHOT_TICKS(testSNAPSHOT_RUN_TICKS));
+    vTimerDomainWaitUntilIdle(NULL);
+
+    for (x = 0U; x < testSNAPSHOT_TIMERS; x++) {
+        xFirstCall = testSNAPSHOT_TICKS(xSnapshotPeriods[x] - testSNAPSHOT_SAVED_AT);
+        xPeriod    = testSNAPSHOT_TICKS(xSnapshotPeriods[x]);
+        ulCalls    = ((x % 2U) == 0U) ? (1U + ((testSNAPSHOT_TICKS(testSNAPSHOT_RUN_TICKS) - xFirstCall) / xPeriod))
+                                      : 1U;
+
+        snprintf(cWhat, sizeof(cWhat), "first call of timer %u", (unsigned)x);
+        if (prvExpect(cWhat, xSnapshotFirstCall[x], xFirstCall) == pdFAIL) {
+            xResult = pdFAIL;
+        }
+        snprintf(cWhat, sizeof(cWhat), "calls of timer %u", (unsigned)x);
+        if (prvExpect(cWhat, ulSnapshotCalls[x], ulCalls) == pdFAIL) {
+            xResult = pdFAIL;
+        }
+    }
+
+    if (prvExpect("timer 1 called before timer 2", (uint64_t)(uxSnapshotOrder[1] < uxSnapshotOrder[2]), 1U) ==
+        pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    printf("snapshot_restore: %u timers at %u Hz, saved at %u Hz\n", (unsigned)uxRestored,
+           (unsigned)configTICK_RATE_HZ, (unsigned)testSNAPSHOT_TICK_RATE_HZ);
+
+    return xResult;
+}
+
+#endif /* configUSE_TIMER_SNAPSHOT */
+
+#if (configUSE_TIMER_CAPTURE == 1)
+
+static void prvCaptureCallback(TimerHandle_t xTimer) {
+    (void)xTimer;
+}
+
+/* Read the records of a capture file, returning how many there are, or
+testCAPTURE_MAX_RECORDS + 1 if the file is not a capture or holds too many. */
+static size_t prvReadCapture(const char *const pcFileName, TimerCaptureRecord_t *const pxRecords) {
+    TimerCaptureFileHeader_t xHeader;
+    size_t xRecords = testCAPTURE_MAX_RECORDS + 1U;
+    FILE *const pxFile = fopen(pcFileName, "rb");
+
+    if (pxFile != NULL) {
+        if ((fread(&xHeader, sizeof(xHeader), 1U, pxFile) == 1U) && (xHeader.ulMagic == tmrCAPTURE_FILE_MAGIC) &&
+            (xHeader.ulRecordSize == (uint32_t)sizeof(TimerCaptureRecord_t))) {
+            xRecords = fread(pxRecords, sizeof(TimerCaptureRecord_t), testCAPTURE_MAX_RECORDS + 1U, pxFile);
+        }
+        (void)fclose(pxFile);
+    }
+
+    return xRecords;
+}
+
+/*
+ * Capturing a replay gives back the capture it replayed: the same timers
+ * created, and the same commands with the same values and results, followed
+ * by the deletes of the timers the replay leaves.  A timer created before the
+ * capture started is included from its first command.
+ */
+static BaseType_t prvCheckCaptureReplay(void) {
+    static TimerCaptureRecord_t xCaptured[testCAPTURE_MAX_RECORDS + 1U];
+    static TimerCaptureRecord_t xReplayed[testCAPTURE_MAX_RECORDS + 1U];
+    TimerHandle_t xTimers[testCAPTURE_TIMERS];
+    TimerReplayResult_t xReplay;
+    size_t xNumberCaptured;
+    size_t xNumberReplayed;
+    size_t x;
+    BaseType_t xResult = pdPASS;
+    char cWhat[64];
+
+    CreateTimerManageTask();
+
+    xTimers[0] = xTimerCreate("Early", (TickType_t)10U, pdTRUE, NULL, prvCaptureCallback);
+    configASSERT(xTimers[0]);
+
+    if (prvExpect("capture start", (uint64_t)xTimerCaptureStart(testCAPTURE_FILE), (uint64_t)pdPASS) == pdFAIL) {
+        return pdFAIL;
+    }
+
+    (void)xTimerStart(xTimers[0], 0);
+    for (x = 1U; x < testCAPTURE_TIMERS; x++) {
+        xTimers[x] = xTimerCreate("Captured", (TickType_t)(3U + (2U * x)), ((x % 2U) == 0U) ? pdTRUE : pdFALSE,
+                                  NULL, prvCaptureCallback);
+        configASSERT(xTimers[x]);
+        (void)xTimerStart(xTimers[x], 0);
+    }
+    (void)xTimerDomainAdvanceTime(NULL, testCAPTURE_TICKS);
+
+    (void)xTimerChangePeriod(xTimers[1], (TickType_t)9U, 0);
+    (void)xTimerStop(xTimers[2], 0);
+    (void)xTimerReset(xTimers[3], 0);
+    (void)xTimerDelete(xTimers[4], 0);
+    (void)xTimerDomainAdvanceTime(NULL, testCAPTURE_TICKS);
+    (void)xTimerStop(xTimers[0], 0);
+    vTimerDomainWaitUntilIdle(NULL);
+    vTimerCaptureStop();
+
+    if (prvExpect("replay capture start", (uint64_t)xTimerCaptureStart(testREPLAY_CAPTURE_FILE),
+                  (uint64_t)pdPASS) == pdFAIL) {
+        return pdFAIL;
+    }
+    if (prvExpect("replay", (uint64_t)xTimerReplay(testCAPTURE_FILE, pdFALSE, NULL, &xReplay), (uint64_t)pdPASS) ==
+        pdFAIL) {
+        xResult = pdFAIL;
+    }
+    vTimerDomainWaitUntilIdle(NULL);
+    vTimerCaptureStop();
+
+    xNumberCaptured = prvReadCapture(testCAPTURE_FILE, xCaptured);
+    xNumberReplayed = prvReadCapture(testREPLAY_CAPTURE_FILE, xReplayed);
+
+    /* A create and a start for each timer, four more commands and a stop. */
+    if (prvExpect("records captured", xNumberCaptured, (2U * testCAPTURE_TIMERS) + 5U) == pdFAIL) {
+        return pdFAIL;
+    }
+    if (prvExpect("records replayed", xReplay.ullRecords, xNumberCaptured) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+    if (prvExpect("commands failed in the replay",
+                  xReplay.ullCommandsFailed + xReplay.ullCreatesFailed + xReplay.ullCommandsFailedInCapture,
+                  0U) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    /* Every timer but the deleted one is deleted by the replay. */
+    if (prvExpect("records captured from the replay", xNumberReplayed, xNumberCaptured + testCAPTURE_TIMERS - 1U) ==
+        pdFAIL) {
+        return pdFAIL;
+    }
+
+    for (x = 0U; x < xNumberReplayed; x++) {
+        snprintf(cWhat, sizeof(cWhat), "command of replayed record %u", (unsigned)x);
+        if (x >= xNumberCaptured) {
+            if (prvExpect(cWhat, (uint64_t)xReplayed[x].cCommand, (uint64_t)tmrCOMMAND_DELETE) == pdFAIL) {
+                xResult = pdFAIL;
+            }
+        } else if ((prvExpect(cWhat, (uint64_t)xReplayed[x].cCommand, (uint64_t)xCaptured[x].cCommand) == pdFAIL) ||
+                   (xReplayed[x].ulTimer != xCaptured[x].ulTimer) || (xReplayed[x].ulValue != xCaptured[x].ulValue) ||
+                   (xReplayed[x].ucAutoReload != xCaptured[x].ucAutoReload) ||
+                   (xReplayed[x].ucResult != xCaptured[x].ucResult)) {
+            printf("replayed record %u is timer %lu value %lu, captured as timer %lu value %lu\n", (unsigned)x,
+                   (unsigned long)xReplayed[x].ulTimer, (unsigned long)xReplayed[x].ulValue,
+                   (unsigned long)xCaptured[x].ulTimer, (unsigned long)xCaptured[x].ulValue);
+            xResult = pdFAIL;
+        }
+    }
+
+    return xResult;
 }
-#endif
\ No newline at end of file
+
+#endif /* configUSE_TIMER_CAPTURE */
+
+static void prvRateGrant(RateLimiterHandle_t xLimiter, void *pvParameter) {
+    (void)xLimiter;
+
+    /* Only the timer service task calls it. */
+    if (uxRateGrants <= testRATE_REQUESTS) {
+        uxRateGrantOrder[uxRateGrants] = (UBaseType_t)(uintptr_t)pvParameter;
+        xRateGrantedAt[uxRateGrants] = xTaskGetTickCount();
+    }
+    uxRateGrants++;
+}
+
+/* Whether the timer service task has a timer to wake for. */
+static BaseType_t prvTimerServiceHasWake(void) {
+    TickType_t xWakeTick;
+
+    return xTimerDomainGetNextWake(NULL, &xWakeTick);
+}
+
+/*
+ * Empty a rate limiter with xRateLimiterTryAcquire(), queue requests behind
+ * it that are granted oldest first as the bucket refills, and check the
+ * refill timer only runs while a bucket is short of tokens or being deleted,
+ * and that deleting a limiter drops the requests still waiting.
+ */
+static BaseType_t prvCheckRateLimiter(void) {
+    RateLimiterHandle_t xLimiter;
+    TickType_t xEmptiedAt;
+    UBaseType_t x;
+    BaseType_t xResult = pdPASS;
+    char cWhat[64];
+
+    CreateTimerManageTask();
+
+    xLimiter = xRateLimiterCreate(configTICK_RATE_HZ / configRATE_LIMITER_REFILL_TICKS, testRATE_BUCKET,
+                                  testRATE_REQUESTS);
+    configASSERT(xLimiter);
+
+    if (prvExpect("refill timer running with full buckets", (uint64_t)prvTimerServiceHasWake(),
+                  (uint64_t)pdFALSE) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    for (x = 0U; x < testRATE_BUCKET; x++) {
+        snprintf(cWhat, sizeof(cWhat), "try acquire %u", (unsigned)x);
+        if (prvExpect(cWhat, (uint64_t)xRateLimiterTryAcquire(xLimiter, 1U), (uint64_t)pdPASS) == pdFAIL) {
+            return pdFAIL;
+        }
+    }
+    xEmptiedAt = xTaskGetTickCount();
+
+    if ((prvExpect("try acquire from an empty bucket", (uint64_t)xRateLimiterTryAcquire(xLimiter, 1U),
+                   (uint64_t)pdFAIL) == pdFAIL) ||
+        (prvExpect("acquire more than the bucket",
+                   (uint64_t)xRateLimiterAcquire(xLimiter, testRATE_BUCKET + 1U, prvRateGrant, NULL),
+                   (uint64_t)pdFAIL) == pdFAIL)) {
+        xResult = pdFAIL;
+    }
+
+    for (x = 0U; x < testRATE_REQUESTS; x++) {
+        snprintf(cWhat, sizeof(cWhat), "acquire %u", (unsigned)x);
+        if (prvExpect(cWhat,
+                      (uint64_t)xRateLimiterAcquire(xLimiter, ulRateRequestTokens[x], prvRateGrant,
+                                                    (void *)(uintptr_t)x),
+                      (uint64_t)tmrRATE_PENDING) == pdFAIL) {
+            return pdFAIL;
+        }
+    }
+    if (prvExpect("acquire with every request slot taken",
+                  (uint64_t)xRateLimiterAcquire(xLimiter, 1U, prvRateGrant, NULL), (uint64_t)pdFAIL) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    /* A token is back, but the first request waits for two, and the later
+    ones come after it. */
+    (void)xTimerDomainAdvanceTime(NULL, (TickType_t)1U);
+    if ((prvExpect("tokens after one tick", ulRateLimiterGetTokens(xLimiter), 1U) == pdFAIL) ||
+        (prvExpect("try acquire jumping the queue", (uint64_t)xRateLimiterTryAcquire(xLimiter, 1U),
+                   (uint64_t)pdFAIL) == pdFAIL)) {
+        xResult = pdFAIL;
+    }
+
+    (void)xTimerDomainAdvanceTime(NULL, testRATE_IDLE_TICKS);
+    if (prvExpect("grants", uxRateGrants, testRATE_REQUESTS) == pdFAIL) {
+        return pdFAIL;
+    }
+    for (x = 0U; x < testRATE_REQUESTS; x++) {
+        snprintf(cWhat, sizeof(cWhat), "request granted %u", (unsigned)x);
+        if ((prvExpect(cWhat, uxRateGrantOrder[x], x) == pdFAIL) ||
+            (prvExpect("tick of the grant", (uint64_t)(TickType_t)(xRateGrantedAt[x] - xEmptiedAt),
+                       (uint64_t)xRateGrantTicks[x]) == pdFAIL)) {
+            xResult = pdFAIL;
+        }
+    }
+
+    /* Refilled long ago, so the refill timer stopped itself. */
+    if ((prvExpect("tokens when idle", ulRateLimiterGetTokens(xLimiter), testRATE_BUCKET) == pdFAIL) ||
+        (prvExpect("refill timer running when idle", (uint64_t)prvTimerServiceHasWake(), (uint64_t)pdFALSE) ==
+         pdFAIL)) {
+        xResult = pdFAIL;
+    }
+
+    /* Delete the limiter with a request waiting; it is not granted, and the
+    refill timer stops once the limiter is freed. */
+    if ((prvExpect("try acquire the bucket", (uint64_t)xRateLimiterTryAcquire(xLimiter, testRATE_BUCKET),
+                   (uint64_t)pdPASS) == pdFAIL) ||
+        (prvExpect("acquire before the delete",
+                   (uint64_t)xRateLimiterAcquire(xLimiter, testRATE_BUCKET, prvRateGrant,
+                                                 (void *)(uintptr_t)testRATE_REQUESTS),
+                   (uint64_t)tmrRATE_PENDING) == pdFAIL)) {
+        return pdFAIL;
+    }
+    vRateLimiterDelete(xLimiter);
+
+    (void)xTimerDomainAdvanceTime(NULL, testRATE_IDLE_TICKS);
+    if ((prvExpect("grants after the delete", uxRateGrants, testRATE_REQUESTS) == pdFAIL) ||
+        (prvExpect("refill timer running after the delete", (uint64_t)prvTimerServiceHasWake(),
+                   (uint64_t)pdFALSE) == pdFAIL)) {
+        xResult = pdFAIL;
+    }
+
+    return xResult;
+}
+
+#if defined(__cpp_impl_coroutine)
+
+static BaseType_t xOperationStarted = pdFALSE;
+
+static TimerTask<int> prvOperation(const TickType_t xTicks) {
+    xOperationStarted = pdTRUE;
+    co_await timer_sleep(xTicks);
+    co_return testOPERATION_RESULT;
+}
+
+static TimerTask<> prvSleepFlow(TestAwait_t *const pxAwait) {
+    co_await timer_sleep(testSLEEP_TICKS);
+    pxAwait->xTick    = xTaskGetTickCount();
+    pxAwait->xResumed = pdTRUE;
+}
+
+static TimerTask<> prvTimeoutFlow(TestAwait_t *const pxAwait, const TickType_t xOperationTicks,
+                                  const TickType_t xTimeoutTicks) {
+    const std::optional<int> xResult = co_await with_timeout(prvOperation(xOperationTicks), xTimeoutTicks);
+
+    pxAwait->xTick      = xTaskGetTickCount();
+    pxAwait->xHasResult = xResult.has_value() ? pdTRUE : pdFALSE;
+    pxAwait->iResult    = xResult.value_or(0);
+    pxAwait->xResumed   = pdTRUE;
+}
+
+static BaseType_t prvExpectAwait(const char *const pcFlow, const TestAwait_t *const pxAwait,
+                                 const BaseType_t xHasResult, const TickType_t xTick) {
+    BaseType_t xResult = pdPASS;
+    char cWhat[64];
+
+    snprintf(cWhat, sizeof(cWhat), "resumption of the %s", pcFlow);
+    if (prvExpect(cWhat, (uint64_t)pxAwait->xResumed, (uint64_t)pdTRUE) == pdFAIL) {
+        return pdFAIL;
+    }
+
+    snprintf(cWhat, sizeof(cWhat), "tick the %s resumed on", pcFlow);
+    if (prvExpect(cWhat, pxAwait->xTick, xTick) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    snprintf(cWhat, sizeof(cWhat), "result of the %s", pcFlow);
+    if (prvExpect(cWhat, (uint64_t)pxAwait->iResult, (xHasResult != pdFALSE) ? testOPERATION_RESULT : 0) ==
+        pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    return xResult;
+}
+
+/*
+ * timer_sleep() resumes a coroutine after its ticks, and with_timeout()
+ * produces the result of an operation that finishes in time and nothing for
+ * one that does not, or for a timeout of 0, which does not start it.
+ */
+static BaseType_t prvCheckCoroutines(void) {
+    static TestAwait_t xSleep, xCompleted, xTimedOut, xZero;
+    BaseType_t xResult = pdPASS;
+
+    CreateTimerManageTask();
+
+    prvTimeoutFlow(&xZero, testFAST_TICKS, 0U).vStart();
+    if (prvExpectAwait("zero timeout", &xZero, pdFALSE, 0U) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+    if (prvExpect("operation started by a zero timeout", (uint64_t)xOperationStarted, (uint64_t)pdFALSE) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    prvSleepFlow(&xSleep).vStart();
+    prvTimeoutFlow(&xCompleted, testFAST_TICKS, testTIMEOUT_TICKS).vStart();
+    prvTimeoutFlow(&xTimedOut, testSLOW_TICKS, testTIMEOUT_TICKS).vStart();
+
+    /* Past the end of the slow operation, which runs on after timing out. */
+    (void)xTimerDomainAdvanceTime(NULL, testSLOW_TICKS * 2U);
+    vTimerDomainWaitUntilIdle(NULL);
+
+    if (prvExpectAwait("sleep", &xSleep, pdFALSE, testSLEEP_TICKS) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+    if (prvExpectAwait("completed operation", &xCompleted, pdTRUE, testFAST_TICKS) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+    if (prvExpectAwait("timed out operation", &xTimedOut, pdFALSE, testTIMEOUT_TICKS) == pdFAIL) {
+        xResult = pdFAIL;
+    }
+    if (prvExpect("result of the timed out operation", (uint64_t)xTimedOut.xHasResult, (uint64_t)pdFALSE) ==
+        pdFAIL) {
+        xResult = pdFAIL;
+    }
+
+    return xResult;
+}
+
+#endif /* __cpp_impl_coroutine */
+
+static const TestCheck_t xChecks[] = {
+    {"virtual_time", prvCheckVirtualTime},
+    {"catch_up", prvCheckCatchUp},
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+    {"pended_calls_full", prvCheckPendedCallsFull},
+#endif
+#if (configUSE_TIMER_PDES == 1)
+    {"pdes_workers", prvCheckPdesWorkers},
+#endif
+    {"rate_limiter", prvCheckRateLimiter},
+#if (configUSE_TIMER_CAPTURE == 1)
+    {"capture_replay", prvCheckCaptureReplay},
+#endif
+#if (configUSE_TIMER_SNAPSHOT == 1)
+    {"snapshot_save", prvCheckSnapshotSave},
+    {"snapshot_restore", prvCheckSnapshotRestore},
+#endif
+#if defined(__cpp_impl_coroutine)
+    {"coroutines", prvCheckCoroutines},
+#endif
+};
+
+int main(int argc, char **argv) {
+    const size_t xNumberOfChecks = sizeof(xChecks) / sizeof(xChecks[0]);
+    BaseType_t xResult = pdFAIL;
+    size_t x;
+
+    for (x = 0U; x < xNumberOfChecks; x++) {
+        if ((argc == 2) && (strcmp(argv[1], xChecks[x].pcName) == 0)) {
+            break;
+        }
+    }
+
+    if (x == xNumberOfChecks) {
+        fprintf(stderr, "usage: %s <check>, one of:\n", argv[0]);
+        for (x = 0U; x < xNumberOfChecks; x++) {
+            fprintf(stderr, "  %s\n", xChecks[x].pcName);
+        }
+        return 2;
+    }
+
+    xResult = xChecks[x].pxCheck();
+    printf("%s: %s\n", xChecks[x].pcName, (xResult == pdPASS) ? "passed" : "FAILED");
+
+    /* The timer service task never returns, so leave without waiting for it
+    or running the static destructors under it. */
+    fflush(stdout);
+    std::quick_exit((xResult == pdPASS) ? 0 : 1);
+}
+
+#endif /* configTIMER_SELF_TEST */
@@ -2,6 +2,8 @@
 #include "..\task.h"
 #include "portable.h"
 #include <Windows.h>
+#include <malloc.h>
+#include <atomic>
 
 #ifdef __GNUC__
     #include "mmsystem.h"
@@ -25,6 +27,22 @@ Windows interfering with the timing. */
     #define portSIMULATED_TIMER_THREAD_PRIORITY THREAD_PRIORITY_ABOVE_NORMAL
 #endif
 
+/* The simulation threads share CPU 0 unless configured otherwise, so a tick
+and the interrupt it raises never run at the same time. */
+#if (configTICK_THREAD_AFFINITY != 0)
+    #define portSIMULATED_TIMER_THREAD_AFFINITY ((DWORD_PTR)configTICK_THREAD_AFFINITY)
+#else
+    #define portSIMULATED_TIMER_THREAD_AFFINITY ((DWORD_PTR)0x01)
+#endif
+#if (configINTERRUPT_THREAD_AFFINITY != 0)
+    #define portSIMULATED_INTERRUPTS_THREAD_AFFINITY ((DWORD_PTR)configINTERRUPT_THREAD_AFFINITY)
+#else
+    #define portSIMULATED_INTERRUPTS_THREAD_AFFINITY ((DWORD_PTR)0x01)
+#endif
+
+/* The page size touched by prvPrefaultStack(). */
+#define portSTACK_PAGE_SIZE ((size_t)4096U)
+
 /*
  * Created as a high priority thread, this function uses a timer to simulate
  * a tick interrupt being generated on an embedded target.  In this Windows
@@ -90,6 +108,9 @@ static uint32_t (*ulIsrHandler[portMAX_INTERRUPTS])(void) = {0};
 /* Used to ensure nothing is processed during the startup sequence. */
 static BaseType_t xPortRunning = pdFALSE;
 
+/* The portCONFIGURE_ bits of every failed configuration. */
+static std::atomic<uint32_t> ulConfigureFailures(0U);
+
 static DWORD WINAPI prvSimulatedPeripheralTimer(LPVOID lpParameter) {
     TickType_t xMinimumWindowsBlockTime;
     TIMECAPS   xTimeCaps;
@@ -109,6 +130,11 @@ static DWORD WINAPI prvSimulatedPeripheralTimer(LPVOID lpParameter) {
     /* Just to prevent compiler warnings. */
     (void)lpParameter;
 
+    if (xPortConfigureThread(0U, (int32_t)configTICK_THREAD_REALTIME_PRIORITY,
+                             (size_t)configTIMER_THREAD_STACK_PREFAULT) == pdFAIL) {
+        vPortRecordConfigureFailure(portCONFIGURE_TICK_THREAD);
+    }
+
     for (;;) {
         /* Wait until the timer expires and we can access the simulated interrupt
         variables.  *NOTE* this is not a 'real time' way of generating tick
@@ -192,21 +218,36 @@ BaseType_t StartPortScheduler(void) {
             lSuccess = pdFAIL;
         }
         SetThreadPriorityBoost(pvHandle, TRUE);
-        SetThreadAffinityMask(pvHandle, 0x01);
+        SetThreadAffinityMask(pvHandle, portSIMULATED_INTERRUPTS_THREAD_AFFINITY);
+        if (xPortConfigureThread(0U, (int32_t)configINTERRUPT_THREAD_REALTIME_PRIORITY,
+                                 (size_t)configTIMER_THREAD_STACK_PREFAULT) == pdFAIL) {
+            vPortRecordConfigureFailure(portCONFIGURE_INTERRUPT_THREAD);
+        }
+
+        /* configINTERRUPT_THREAD_REALTIME_PRIORITY may only raise this thread.
+        The mapping in xPortConfigureThread() can put it under
+        portSIMULATED_INTERRUPTS_THREAD_PRIORITY, which would let the other
+        threads hold off the simulated interrupts. */
+        if (GetThreadPriority(pvHandle) < portSIMULATED_INTERRUPTS_THREAD_PRIORITY) {
+            (void)SetThreadPriority(pvHandle, portSIMULATED_INTERRUPTS_THREAD_PRIORITY);
+        }
     }
 
     if (lSuccess == pdPASS) {
+#if (configUSE_VIRTUAL_TIME == 0)
         /* Start the thread that simulates the timer peripheral to generate
         tick interrupts.  The priority is set below that of the simulated
         interrupt handler so the interrupt event mutex is used for the
-        handshake / overrun protection. */
+        handshake / overrun protection.  With virtual time the harness
+        advances the tick instead, see xTimerDomainAdvanceTime(). */
         pvHandle = CreateThread(NULL, 0, prvSimulatedPeripheralTimer, NULL, CREATE_SUSPENDED, NULL);
         if (pvHandle != NULL) {
             SetThreadPriority(pvHandle, portSIMULATED_TIMER_THREAD_PRIORITY);
             SetThreadPriorityBoost(pvHandle, TRUE);
-            SetThreadAffinityMask(pvHandle, 0x01);
+            SetThreadAffinityMask(pvHandle, portSIMULATED_TIMER_THREAD_AFFINITY);
             ResumeThread(pvHandle);
         }
+#endif
 
         /* Start the highest priority task by obtaining its associated thread
         state structure, in which is stored the thread handle. */
@@ -332,4 +373,126 @@ void vPortSetInterruptHandler(uint32_t ulInterruptNumber, uint32_t (*pvHandler)(
             ulIsrHandler[ulInterruptNumber] = pvHandler;
         }
     }
-}
\ No newline at end of file
+}
+
+void *pvPortMapFile(const char *pcFileName, size_t xSize, size_t *pxMappedSize) {
+    void *        pvFile;
+    void *        pvMapping;
+    void *        pvAddress = NULL;
+    LARGE_INTEGER xFileSize;
+
+    pvFile = CreateFileA(pcFileName, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                         (xSize != 0) ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (pvFile == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    if (xSize == 0) {
+        if ((GetFileSizeEx(pvFile, &xFileSize) != 0) && (xFileSize.QuadPart > 0)) {
+            xSize = (size_t)xFileSize.QuadPart;
+        }
+    } else {
+        xFileSize.QuadPart = (LONGLONG)xSize;
+    }
+
+    if (xSize != 0) {
+        /* The mapping grows the file to the size asked for. */
+        pvMapping = CreateFileMappingA(pvFile, NULL, PAGE_READWRITE, (DWORD)(xFileSize.QuadPart >> 32),
+                                       (DWORD)xFileSize.QuadPart, NULL);
+        if (pvMapping != NULL) {
+            pvAddress = MapViewOfFile(pvMapping, FILE_MAP_ALL_ACCESS, 0, 0, xSize);
+
+            /* The view keeps the mapping and the file open. */
+            CloseHandle(pvMapping);
+        }
+    }
+
+    CloseHandle(pvFile);
+
+    if ((pvAddress != NULL) && (pxMappedSize != NULL)) {
+        *pxMappedSize = xSize;
+    }
+
+    return pvAddress;
+}
+
+void vPortUnmapFile(void *pvAddress, size_t xSize) {
+    (void)FlushViewOfFile(pvAddress, xSize);
+    (void)UnmapViewOfFile(pvAddress);
+}
+
+uint64_t ullPortGetThreadCpuTime(void) {
+    FILETIME       xCreationTime, xExitTime, xKernelTime, xUserTime;
+    ULARGE_INTEGER xKernel, xUser;
+
+    /* Windows only updates these on a scheduler tick, so short callbacks
+    mostly read as 0 and the occasional one as a whole tick. */
+    if (GetThreadTimes(GetCurrentThread(), &xCreationTime, &xExitTime, &xKernelTime, &xUserTime) == 0) {
+        return 0U;
+    }
+
+    xKernel.LowPart  = xKernelTime.dwLowDateTime;
+    xKernel.HighPart = xKernelTime.dwHighDateTime;
+    xUser.LowPart    = xUserTime.dwLowDateTime;
+    xUser.HighPart   = xUserTime.dwHighDateTime;
+
+    /* In units of 100ns. */
+    return (uint64_t)(xKernel.QuadPart + xUser.QuadPart) * 100U;
+}
+
+/* Touch xSize bytes below the current stack pointer, a page at a time. */
+static __declspec(noinline) void prvPrefaultStack(size_t xSize) {
+    volatile uint8_t *const pucStack = (volatile uint8_t *)_alloca(xSize);
+    size_t x;
+
+    for (x = 0U; x < xSize; x += portSTACK_PAGE_SIZE) {
+        pucStack[x] = 0U;
+    }
+}
+
+BaseType_t xPortConfigureThread(uint64_t ullAffinityMask, int32_t lRealTimePriority, size_t xPrefaultStackSize) {
+    BaseType_t xReturn = pdPASS;
+    int        iPriority;
+
+    if (ullAffinityMask != 0U) {
+        if (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)ullAffinityMask) == 0) {
+            xReturn = pdFAIL;
+        }
+    }
+
+    if (lRealTimePriority != 0) {
+        if (lRealTimePriority < 0) {
+            iPriority = THREAD_PRIORITY_NORMAL;
+        } else if (lRealTimePriority >= 90) {
+            iPriority = THREAD_PRIORITY_TIME_CRITICAL;
+        } else if (lRealTimePriority >= 50) {
+            iPriority = THREAD_PRIORITY_HIGHEST;
+        } else {
+            iPriority = THREAD_PRIORITY_ABOVE_NORMAL;
+        }
+
+        if (SetThreadPriority(GetCurrentThread(), iPriority) == 0) {
+            xReturn = pdFAIL;
+        }
+    }
+
+    if (xPrefaultStackSize != 0U) {
+        prvPrefaultStack(xPrefaultStackSize);
+    }
+
+    return xReturn;
+}
+
+BaseType_t xPortLockMemory(void) {
+    /* Windows can only lock ranges the size of the working set, not the
+    whole of a process as it grows. */
+    return pdFAIL;
+}
+
+void vPortRecordConfigureFailure(uint32_t ulWhat) {
+    (void)ulConfigureFailures.fetch_or(ulWhat, std::memory_order_relaxed);
+}
+
+uint32_t ulPortGetConfigureFailures(void) {
+    return ulConfigureFailures.load(std::memory_order_relaxed);
+}
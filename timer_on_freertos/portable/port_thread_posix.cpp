@@ -0,0 +1,338 @@
+#ifndef _WIN32
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include "../uds.h"
+#include "../task.h"
+#include "portable.h"
+#include <alloca.h>
+#include <atomic>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * The port for Linux and other POSIX hosts, for when the simulator is built
+ * outside Windows, see CMakeLists.txt.  It follows port.cpp: a thread raises
+ * the simulated tick interrupt and the thread that calls StartPortScheduler()
+ * runs the handlers.
+ */
+
+#define portMAX_INTERRUPTS                                                                         \
+    ((uint32_t)sizeof(uint32_t) * 8UL) /* The number of bits in an uint32_t. */
+
+/* The tick period, for the simulated timer peripheral. */
+#define portTICK_PERIOD_NS ((long)(1000000000L / (long)configTICK_RATE_HZ))
+#define portNS_PER_SECOND (1000000000L)
+
+/* The page size touched by prvPrefaultStack(). */
+#define portSTACK_PAGE_SIZE ((size_t)4096U)
+
+/* The portCONFIGURE_ bits of every failed configuration. */
+static std::atomic<uint32_t> ulConfigureFailures(0U);
+
+#if (configUSE_VIRTUAL_TIME == 0)
+
+/*
+ * Created as a separate thread, this function raises a simulated tick
+ * interrupt every tick period.
+ */
+static void *prvSimulatedPeripheralTimer(void *pvParameter);
+
+#endif
+
+/*
+ * Process all the simulated interrupts - each represented by a bit in
+ * ulPendingInterrupts variable.
+ */
+static void prvProcessSimulatedInterrupts(void);
+
+/*
+ * Interrupt handlers used by the kernel itself.  These are executed from the
+ * simulated interrupt handler thread.
+ */
+static uint32_t prvProcessYieldInterrupt(void);
+static uint32_t prvProcessTickInterrupt(void);
+
+/* Simulated interrupts waiting to be processed.  This is a bit mask where each
+bit represents one interrupt, so a maximum of 32 interrupts can be simulated. */
+static uint32_t ulPendingInterrupts = 0UL;
+
+/* Protects all the simulated interrupt variables that are accessed by multiple
+threads, and tells the simulated interrupt processing thread that an interrupt
+is pending. */
+static pthread_mutex_t xInterruptMutex   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  xInterruptPending = PTHREAD_COND_INITIALIZER;
+
+/* Handlers for all the simulated software interrupts.  The first two positions
+are used for the Yield and Tick interrupts so are handled slightly differently,
+all the other interrupts can be user defined. */
+static uint32_t (*ulIsrHandler[portMAX_INTERRUPTS])(void) = {0};
+
+/* Used to ensure nothing is processed during the startup sequence. */
+static BaseType_t xPortRunning = pdFALSE;
+
+#if (configUSE_VIRTUAL_TIME == 0)
+
+static void *prvSimulatedPeripheralTimer(void *pvParameter) {
+    struct timespec xNextTick;
+
+    /* Just to prevent compiler warnings. */
+    (void)pvParameter;
+
+    if (xPortConfigureThread((uint64_t)configTICK_THREAD_AFFINITY, (int32_t)configTICK_THREAD_REALTIME_PRIORITY,
+                             (size_t)configTIMER_THREAD_STACK_PREFAULT) == pdFAIL) {
+        vPortRecordConfigureFailure(portCONFIGURE_TICK_THREAD);
+    }
+    (void)clock_gettime(CLOCK_MONOTONIC, &xNextTick);
+
+    for (;;) {
+        /* Unlike the Windows port, each tick is timed from the previous one
+        rather than from when the thread woke, so the tick does not drift. */
+        xNextTick.tv_nsec += portTICK_PERIOD_NS;
+        while (xNextTick.tv_nsec >= portNS_PER_SECOND) {
+            xNextTick.tv_nsec -= portNS_PER_SECOND;
+            xNextTick.tv_sec++;
+        }
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &xNextTick, NULL) == EINTR) {
+        }
+
+        configASSERT(xPortRunning);
+
+        /* The timer has expired, generate the simulated tick event and
+        notify the simulated interrupt handler thread. */
+        (void)pthread_mutex_lock(&xInterruptMutex);
+        ulPendingInterrupts |= (1UL << portINTERRUPT_TICK);
+        (void)pthread_cond_signal(&xInterruptPending);
+        (void)pthread_mutex_unlock(&xInterruptMutex);
+    }
+
+    return NULL;
+}
+
+#endif /* configUSE_VIRTUAL_TIME */
+
+BaseType_t StartPortScheduler(void) {
+    BaseType_t xSuccess = pdPASS;
+#if (configUSE_VIRTUAL_TIME == 0)
+    pthread_t xTimerThread;
+#endif
+
+    /* Install the interrupt handlers used by the scheduler itself. */
+    vPortSetInterruptHandler(portINTERRUPT_YIELD, prvProcessYieldInterrupt);
+    vPortSetInterruptHandler(portINTERRUPT_TICK, prvProcessTickInterrupt);
+
+    /* Without permission for real time priorities this thread carries on at
+    its normal priority, as do the tick thread and the task threads. */
+    if (xPortConfigureThread((uint64_t)configINTERRUPT_THREAD_AFFINITY,
+                             (int32_t)configINTERRUPT_THREAD_REALTIME_PRIORITY,
+                             (size_t)configTIMER_THREAD_STACK_PREFAULT) == pdFAIL) {
+        vPortRecordConfigureFailure(portCONFIGURE_INTERRUPT_THREAD);
+    }
+
+#if (configUSE_VIRTUAL_TIME == 0)
+    /* Start the thread that simulates the timer peripheral to generate tick
+    interrupts.  With virtual time the harness advances the tick instead, see
+    xTimerDomainAdvanceTime(). */
+    if (pthread_create(&xTimerThread, NULL, prvSimulatedPeripheralTimer, NULL) == 0) {
+        (void)pthread_detach(xTimerThread);
+    } else {
+        xSuccess = pdFAIL;
+    }
+#endif
+
+    if (xSuccess == pdPASS) {
+        /* Handle all simulated interrupts - including yield requests and
+        simulated ticks. */
+        prvProcessSimulatedInterrupts();
+    }
+
+    /* Would not expect to return from prvProcessSimulatedInterrupts(), so
+    should not get here. */
+    return 0;
+}
+
+static uint32_t prvProcessYieldInterrupt(void) {
+    return pdTRUE;
+}
+
+static uint32_t prvProcessTickInterrupt(void) {
+    /* Process the tick itself. */
+    configASSERT(xPortRunning);
+    (void)xTaskIncrementTick();
+
+    return pdFALSE;
+}
+
+static void prvProcessSimulatedInterrupts(void) {
+    uint32_t i;
+
+    (void)pthread_mutex_lock(&xInterruptMutex);
+
+    /* Create a pending tick to ensure the first task is started as soon as
+    this thread pends. */
+    ulPendingInterrupts |= (1UL << portINTERRUPT_TICK);
+
+    xPortRunning = pdTRUE;
+
+    for (;;) {
+        while (ulPendingInterrupts == 0UL) {
+            (void)pthread_cond_wait(&xInterruptPending, &xInterruptMutex);
+        }
+
+        /* For each interrupt we are interested in processing, each of which
+        is represented by a bit in the 32bit ulPendingInterrupts variable. */
+        for (i = 0; i < portMAX_INTERRUPTS; i++) {
+            if ((ulPendingInterrupts & (1UL << i)) != 0UL) {
+                if (ulIsrHandler[i] != NULL) {
+                    (void)ulIsrHandler[i]();
+                }
+
+                /* Clear the interrupt pending bit. */
+                ulPendingInterrupts &= ~(1UL << i);
+            }
+        }
+    }
+}
+
+void vPortSetInterruptHandler(uint32_t ulInterruptNumber, uint32_t (*pvHandler)(void)) {
+    if (ulInterruptNumber < portMAX_INTERRUPTS) {
+        (void)pthread_mutex_lock(&xInterruptMutex);
+        ulIsrHandler[ulInterruptNumber] = pvHandler;
+        (void)pthread_mutex_unlock(&xInterruptMutex);
+    }
+}
+
+void *pvPortMapFile(const char *pcFileName, size_t xSize, size_t *pxMappedSize) {
+    int         iFile;
+    void *      pvAddress = NULL;
+    struct stat xFileStat;
+
+    iFile = open(pcFileName, (xSize != 0) ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+    if (iFile < 0) {
+        return NULL;
+    }
+
+    if (xSize == 0) {
+        if ((fstat(iFile, &xFileStat) == 0) && (xFileStat.st_size > 0)) {
+            xSize = (size_t)xFileStat.st_size;
+        }
+    } else if (ftruncate(iFile, (off_t)xSize) != 0) {
+        xSize = 0;
+    }
+
+    if (xSize != 0) {
+        pvAddress = mmap(NULL, xSize, PROT_READ | PROT_WRITE, MAP_SHARED, iFile, 0);
+        if (pvAddress == MAP_FAILED) {
+            pvAddress = NULL;
+        }
+    }
+
+    /* The mapping keeps the file open. */
+    (void)close(iFile);
+
+    if ((pvAddress != NULL) && (pxMappedSize != NULL)) {
+        *pxMappedSize = xSize;
+    }
+
+    return pvAddress;
+}
+
+void vPortUnmapFile(void *pvAddress, size_t xSize) {
+    (void)msync(pvAddress, xSize, MS_SYNC);
+    (void)munmap(pvAddress, xSize);
+}
+
+uint64_t ullPortGetThreadCpuTime(void) {
+    struct timespec xTime;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &xTime) != 0) {
+        return 0U;
+    }
+
+    return ((uint64_t)xTime.tv_sec * 1000000000ULL) + (uint64_t)xTime.tv_nsec;
+}
+
+/* Touch xSize bytes below the current stack pointer, a page at a time. */
+static __attribute__((noinline)) void prvPrefaultStack(size_t xSize) {
+    volatile uint8_t *const pucStack = (volatile uint8_t *)alloca(xSize);
+    size_t x;
+
+    for (x = 0U; x < xSize; x += portSTACK_PAGE_SIZE) {
+        pucStack[x] = 0U;
+    }
+}
+
+BaseType_t xPortConfigureThread(uint64_t ullAffinityMask, int32_t lRealTimePriority, size_t xPrefaultStackSize) {
+    BaseType_t         xReturn = pdPASS;
+    struct sched_param xParam;
+    cpu_set_t          xCpus;
+    int                iPolicy;
+    int                iCpu;
+
+    if (ullAffinityMask != 0U) {
+        CPU_ZERO(&xCpus);
+        for (iCpu = 0; iCpu < 64; iCpu++) {
+            if ((ullAffinityMask & (1ULL << iCpu)) != 0U) {
+                CPU_SET(iCpu, &xCpus);
+            }
+        }
+
+        if (pthread_setaffinity_np(pthread_self(), sizeof(xCpus), &xCpus) != 0) {
+            xReturn = pdFAIL;
+        }
+    }
+
+    if (lRealTimePriority != 0) {
+        if (lRealTimePriority < 0) {
+            iPolicy               = SCHED_OTHER;
+            xParam.sched_priority = 0;
+        } else {
+            iPolicy               = SCHED_FIFO;
+            xParam.sched_priority = (int)lRealTimePriority;
+            if (xParam.sched_priority > sched_get_priority_max(SCHED_FIFO)) {
+                xParam.sched_priority = sched_get_priority_max(SCHED_FIFO);
+            }
+        }
+
+        /* Needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowance for SCHED_FIFO. */
+        if (pthread_setschedparam(pthread_self(), iPolicy, &xParam) != 0) {
+            xReturn = pdFAIL;
+        }
+    }
+
+    if (xPrefaultStackSize != 0U) {
+        prvPrefaultStack(xPrefaultStackSize);
+    }
+
+    return xReturn;
+}
+
+BaseType_t xPortLockMemory(void) {
+    BaseType_t xReturn = pdPASS;
+
+    /* Needs CAP_IPC_LOCK or an RLIMIT_MEMLOCK large enough for the process. */
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        xReturn = pdFAIL;
+    }
+
+    return xReturn;
+}
+
+void vPortRecordConfigureFailure(uint32_t ulWhat) {
+    (void)ulConfigureFailures.fetch_or(ulWhat, std::memory_order_relaxed);
+}
+
+uint32_t ulPortGetConfigureFailures(void) {
+    return ulConfigureFailures.load(std::memory_order_relaxed);
+}
+
+#endif /* _WIN32 */
@@ -9,4 +9,72 @@ void vPortSetInterruptHandler(uint32_t ulInterruptNumber, uint32_t (*pvHandler)(
  */
 BaseType_t StartPortScheduler( void ) /*PRIVILEGED_FUNCTION*/;
 
+/*
+ * Map the file pcFileName into memory for reading and writing.  If xSize is
+ * not 0 the file is created, or truncated, to xSize bytes.  If xSize is 0 the
+ * existing file is mapped whole and its size written to pxMappedSize.
+ * Returns NULL if the file cannot be mapped.
+ */
+void *pvPortMapFile( const char *pcFileName, size_t xSize, size_t *pxMappedSize );
+
+/*
+ * Write any changes back to the file and unmap it.
+ */
+void vPortUnmapFile( void *pvAddress, size_t xSize );
+
+/*
+ * The CPU time the calling thread has used, in nanoseconds.  Only differences
+ * between two calls on the same thread mean anything.
+ */
+uint64_t ullPortGetThreadCpuTime( void );
+
+/*
+ * Place and schedule the calling thread, for the timer service tasks, the tick
+ * threads and the simulated interrupt thread, see configTIMER_TASK_AFFINITY:
+ *
+ * ullAffinityMask - the CPUs the thread may run on, bit 0 for CPU 0, or 0 to
+ * leave it as it is.
+ *
+ * lRealTimePriority - 1 to 99 to run the thread SCHED_FIFO at that priority,
+ * -1 to set it back to SCHED_OTHER, or 0 to leave it as it is.  Windows has no
+ * fixed priority class for a single thread, so the value is mapped onto the
+ * highest few thread priorities.
+ *
+ * xPrefaultStackSize - the number of bytes of stack to touch now, so the
+ * thread does not take page faults on it later.
+ *
+ * Returns pdFAIL if any of them could not be applied, most often for lack of
+ * permission to use real time priorities, after applying the rest.  The
+ * Windows version is in port.cpp and the POSIX one in port_thread_posix.cpp.
+ */
+BaseType_t xPortConfigureThread( uint64_t ullAffinityMask, int32_t lRealTimePriority, size_t xPrefaultStackSize );
+
+/*
+ * Lock every page of the process, present and future, in memory.  Returns
+ * pdFAIL if that is not allowed or not supported.
+ */
+BaseType_t xPortLockMemory( void );
+
+/* Bits of ulPortGetConfigureFailures(), for the threads configured by
+xPortConfigureThread() and for xPortLockMemory(). */
+#define portCONFIGURE_TIMER_TASK ( ( uint32_t ) 0x01U )
+#define portCONFIGURE_TICK_THREAD ( ( uint32_t ) 0x02U )
+#define portCONFIGURE_INTERRUPT_THREAD ( ( uint32_t ) 0x04U )
+#define portCONFIGURE_LOCK_MEMORY ( ( uint32_t ) 0x08U )
+
+/*
+ * Called with one of the bits above when xPortConfigureThread() or
+ * xPortLockMemory() returns pdFAIL.  The thread carries on as it is, so the
+ * failure is only recorded, for ulPortGetConfigureFailures().
+ */
+void vPortRecordConfigureFailure( uint32_t ulWhat );
+
+/*
+ * The bits above for every configuration that has failed since the process
+ * started.  An application that needs the affinities, real time priorities or
+ * locked memory of uds.h can check it is 0 once the timer service tasks and
+ * the scheduler have started.
+ */
+uint32_t ulPortGetConfigureFailures( void );
+
 #endif
\ No newline at end of file
@@ -1,6 +1,13 @@
 #include "uds.h"
 #include "list.h"
 #include "queue.h"
+#include "task.h"
+#include "timer_probes.h"
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
 
 /* Constants used with the cRxLock and cTxLock structure members. */
 #define queueUNLOCKED ((int8_t)-1)
@@ -28,6 +35,7 @@ typedef struct QueueDefinition {
                                       queue.  Stored in priority order. */
 
     volatile UBaseType_t uxMessagesWaiting; /*< The number of items currently in the queue. */
+    UBaseType_t uxHighWaterMark; /*< The most items the queue has held since it was reset. */
     UBaseType_t uxLength;   /*< The length of the queue defined as the number of items it will hold,
                                not the number of bytes. */
     UBaseType_t uxItemSize; /*< The size of each items that the queue will hold. */
@@ -53,12 +61,59 @@ typedef struct QueueDefinition {
     uint8_t     ucQueueType;
 #endif
 
+    std::mutex              xCriticalSection; /*< Held around every access to the queue. */
+    std::condition_variable xChanged; /*< Notified whenever the queue changes, or the tick source
+                                         whose task waits on it reaches its unblock time. */
 } xQUEUE;
 
 /* The old xQUEUE name is maintained above then typedefed to the new Queue_t
 name below to enable the use of older kernel aware debuggers. */
 typedef xQUEUE Queue_t;
 
+/* The simulator runs every task and simulated interrupt in its own thread, so
+the critical section around the accesses to a queue is a mutex of its own,
+and blocked senders and receivers wait on a condition variable of the queue
+that is notified whenever it changes.  Timer service tasks of different
+domains therefore never contend for a lock. */
+
+/*
+ * Copy an item into the queue, either at the front of the queue or the back.
+ * Must be called from within the queue critical section.
+ */
+static void prvCopyDataToQueue(Queue_t *const pxQueue, const void *pvItemToQueue,
+                               const BaseType_t xPosition);
+
+/*
+ * Copy an item out of the queue.  Must be called from within the queue
+ * critical section.
+ */
+static void prvCopyDataFromQueue(Queue_t *const pxQueue, void *const pvBuffer);
+
+/*
+ * Wait on the xChanged of the queue until xCondition is true or xTicksToWait ticks have
+ * passed.  portMAX_DELAY waits indefinitely.
+ */
+template <typename Condition>
+static BaseType_t prvWaitForQueue(Queue_t *const pxQueue, std::unique_lock<std::mutex> &xLock,
+                                  const TickType_t xTicksToWait, Condition xCondition) {
+    if (xTicksToWait == portMAX_DELAY) {
+        pxQueue->xChanged.wait(xLock, xCondition);
+        return pdTRUE;
+    }
+
+    if (xTicksToWait == (TickType_t)0U) {
+        /* A timed wait that has already expired still costs a system call,
+        and on Linux the timer slack on top of it. */
+        return xCondition() ? pdTRUE : pdFALSE;
+    }
+
+    return pxQueue->xChanged.wait_for(xLock,
+                                      std::chrono::milliseconds((uint64_t)xTicksToWait * portTICK_PERIOD_MS),
+                                      xCondition)
+               ? pdTRUE
+               : pdFALSE;
+}
+
 BaseType_t xQueueGenericReset(QueueHandle_t xQueue, BaseType_t xNewQueue) {
     Queue_t *const pxQueue = (Queue_t *)xQueue;
 
@@ -68,6 +123,7 @@ BaseType_t xQueueGenericReset(QueueHandle_t xQueue, BaseType_t xNewQueue) {
     {
         pxQueue->pcTail            = pxQueue->pcHead + (pxQueue->uxLength * pxQueue->uxItemSize);
         pxQueue->uxMessagesWaiting = (UBaseType_t)0U;
+        pxQueue->uxHighWaterMark   = (UBaseType_t)0U;
         pxQueue->pcWriteTo         = pxQueue->pcHead;
         pxQueue->u.pcReadFrom =
             pxQueue->pcHead + ((pxQueue->uxLength - (UBaseType_t)1U) * pxQueue->uxItemSize);
@@ -135,6 +191,7 @@ static void prvInitialiseNewQueue(const UBaseType_t uxQueueLength, const UBaseTy
 #endif /* configUSE_QUEUE_SETS */
 
     traceQUEUE_CREATE(pxNewQueue);
+    queuePROBE_CREATE(pxNewQueue, uxQueueLength, uxItemSize);
 }
 
 QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize,
@@ -157,9 +214,12 @@ QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseTy
     }
 
     //pxNewQueue = (Queue_t *)pvPortMalloc(sizeof(Queue_t) + xQueueSizeInBytes);
-    pxNewQueue = new Queue_t[(sizeof(Queue_t) + xQueueSizeInBytes)];
+    pxNewQueue = (Queue_t *)::operator new(sizeof(Queue_t) + xQueueSizeInBytes, std::nothrow);
 
     if (pxNewQueue != NULL) {
+        /* The mutex and condition variable need constructing. */
+        pxNewQueue = new (pxNewQueue) Queue_t();
+
         /* Jump past the queue structure to find the location of the queue
         storage area. */
         pucQueueStorage = ((uint8_t *)pxNewQueue) + sizeof(Queue_t);
@@ -179,33 +239,261 @@ QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseTy
     return pxNewQueue;
 }
 
-void vQueueWaitForMessageRestricted( QueueHandle_t xQueue, TickType_t xTicksToWait, const BaseType_t xWaitIndefinitely )
-{
-Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+void vQueueWaitForMessageRestricted(QueueHandle_t xQueue, TickType_t xTicksToWait,
+                                    const BaseType_t xWaitIndefinitely) {
+    const TickType_t xTimeNow = xTickSourceGetCount(pxTaskGetTickSource());
+
+    vQueueWaitForMessageUntil(xQueue, pxTaskGetTickSource(), xTimeNow, xTimeNow + xTicksToWait,
+                              xWaitIndefinitely, queueNO_DEADLINE);
+}
+
+void vQueueWaitForMessageUntil(QueueHandle_t xQueue, TickSource_t *const pxTickSource,
+                               const TickType_t xTimeNow, const TickType_t xWakeTick,
+                               const BaseType_t xWaitIndefinitely, const uint64_t ullDeadline) {
+    Queue_t *const pxQueue = (Queue_t *)xQueue;
+    const TickType_t xStartTick = xTimeNow;
+    const TickType_t xTicksToWait = xWakeTick - xTimeNow;
 
     /* This function should not be called by application code hence the
     'Restricted' in its name.  It is not part of the public API.  It is
-    designed for use by kernel code, and has special calling requirements.
-    It can result in vListInsert() being called on a list that can only
-    possibly ever have one item in it, so the list will be fast, but even
-    so it should be called with the scheduler locked and not from a critical
-    section. */
-
-    /* Only do anything if there are no messages in the queue.  This function
-    will not actually cause the task to block, just place it on a blocked
-    list.  It will not block until the scheduler is unlocked - at which
-    time a yield will be performed.  If an item is added to the queue while
-    the queue is locked, and the calling task blocks on the queue, then the
-    calling task will be immediately unblocked when the queue is unlocked. */
-    //prvLockQueue( pxQueue );
-    //if( pxQueue->uxMessagesWaiting == ( UBaseType_t ) 0U )
-    //{
-    //    /* There is nothing in the queue, block for the specified period. */
-    //    vTaskPlaceOnEventListRestricted( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait, xWaitIndefinitely );
-    //}
-    //else
-    //{
-    //    mtCOVERAGE_TEST_MARKER();
-    //}
-    //prvUnlockQueue( pxQueue );
+    designed for use by the timer service tasks, each of which waits on its
+    own tick source, so a single unblock time per tick source is enough.  The tick count is
+    compared relative to the caller's xTimeNow so an overflow is handled, and
+    ticks that arrived since it was sampled count towards the wait. */
+    auto xCondition = [pxQueue, pxTickSource, xStartTick, xTicksToWait, xWaitIndefinitely] {
+        return (pxQueue->uxMessagesWaiting > (UBaseType_t)0) ||
+               ((xWaitIndefinitely == pdFALSE) &&
+                ((TickType_t)(xTickSourceGetCount(pxTickSource) - xStartTick) >= xTicksToWait));
+    };
+
+    configASSERT(pxQueue);
+    /* vQueueUnblockWaitingTasks() wakes the task through this queue. */
+    configASSERT(pxTickSource->pvWakeQueue.load() == xQueue);
+
+    std::unique_lock<std::mutex> xLock(pxQueue->xCriticalSection);
+
+    if (xWaitIndefinitely == pdFALSE) {
+        vTickSourceSetNextUnblockTime(pxTickSource, xWakeTick);
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+#if (configUSE_VIRTUAL_TIME == 1)
+    pxTickSource->pvWaitingQueue    = xQueue;
+    pxTickSource->xWaitStartTick    = xStartTick;
+    pxTickSource->xWaitTicks        = xTicksToWait;
+    pxTickSource->xWaitIndefinitely = xWaitIndefinitely;
+
+    /* Let vQueueWaitUntilTickSourceIdle() see the task is waiting. */
+    pxQueue->xChanged.notify_all();
+#endif
+
+    if (ullDeadline == queueNO_DEADLINE) {
+        pxQueue->xChanged.wait(xLock, xCondition);
+    } else {
+        (void)pxQueue->xChanged.wait_until(
+            xLock,
+            std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::nanoseconds(ullDeadline))),
+            xCondition);
+    }
+
+#if (configUSE_VIRTUAL_TIME == 1)
+    pxTickSource->pvWaitingQueue = NULL;
+#endif
+}
+
+#if (configUSE_VIRTUAL_TIME == 1)
+
+BaseType_t xQueueWaitUntilTickSourceIdle(TickSource_t *const pxTickSource, TickType_t *const pxWakeTick) {
+    Queue_t *pxWakeQueue;
+
+    configASSERT(pxTickSource);
+    configASSERT(pxWakeTick);
+
+    pxWakeQueue = (Queue_t *)pxTickSource->pvWakeQueue.load();
+    configASSERT(pxWakeQueue);
+
+    std::unique_lock<std::mutex> xLock(pxWakeQueue->xCriticalSection);
+
+    /* The same test as the waiting task makes, negated.  A task that has been
+    woken but has not yet run still fails it, so is not taken for idle. */
+    pxWakeQueue->xChanged.wait(xLock, [pxTickSource] {
+        const Queue_t *const pxQueue = (const Queue_t *)pxTickSource->pvWaitingQueue;
+
+        return (pxQueue != NULL) && (pxQueue->uxMessagesWaiting == (UBaseType_t)0) &&
+               ((pxTickSource->xWaitIndefinitely != pdFALSE) ||
+                ((TickType_t)(xTickSourceGetCount(pxTickSource) - pxTickSource->xWaitStartTick) <
+                 pxTickSource->xWaitTicks));
+    });
+
+    *pxWakeTick = pxTickSource->xWaitStartTick + pxTickSource->xWaitTicks;
+    return (pxTickSource->xWaitIndefinitely == pdFALSE) ? pdTRUE : pdFALSE;
+}
+
+#endif /* configUSE_VIRTUAL_TIME */
+
+void vQueueUnblockWaitingTasks(TickSource_t *const pxTickSource) {
+    Queue_t *const pxQueue = (Queue_t *)pxTickSource->pvWakeQueue.load();
+
+    if (pxQueue != NULL) {
+        /* Taking the lock means a task that has just evaluated its wait
+        condition is waiting by the time it is notified. */
+        { std::lock_guard<std::mutex> xLock(pxQueue->xCriticalSection); }
+        pxQueue->xChanged.notify_all();
+    } else {
+        /* No task can be waiting before its queue is bound. */
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+static void prvCopyDataToQueue(Queue_t *const pxQueue, const void *pvItemToQueue,
+                               const BaseType_t xPosition) {
+    if (pxQueue->uxItemSize == (UBaseType_t)0) {
+        mtCOVERAGE_TEST_MARKER();
+    } else if (xPosition == queueSEND_TO_BACK) {
+        (void)memcpy((void *)pxQueue->pcWriteTo, pvItemToQueue, (size_t)pxQueue->uxItemSize);
+        pxQueue->pcWriteTo += pxQueue->uxItemSize;
+        if (pxQueue->pcWriteTo >= pxQueue->pcTail) {
+            pxQueue->pcWriteTo = pxQueue->pcHead;
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    } else {
+        (void)memcpy((void *)pxQueue->u.pcReadFrom, pvItemToQueue, (size_t)pxQueue->uxItemSize);
+        pxQueue->u.pcReadFrom -= pxQueue->uxItemSize;
+        if (pxQueue->u.pcReadFrom < pxQueue->pcHead) {
+            pxQueue->u.pcReadFrom = (pxQueue->pcTail - pxQueue->uxItemSize);
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+
+    pxQueue->uxMessagesWaiting = pxQueue->uxMessagesWaiting + (UBaseType_t)1;
+    if (pxQueue->uxMessagesWaiting > pxQueue->uxHighWaterMark) {
+        pxQueue->uxHighWaterMark = pxQueue->uxMessagesWaiting;
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+static void prvCopyDataFromQueue(Queue_t *const pxQueue, void *const pvBuffer) {
+    if (pxQueue->uxItemSize != (UBaseType_t)0) {
+        pxQueue->u.pcReadFrom += pxQueue->uxItemSize;
+        if (pxQueue->u.pcReadFrom >= pxQueue->pcTail) {
+            pxQueue->u.pcReadFrom = pxQueue->pcHead;
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+        (void)memcpy((void *)pvBuffer, (void *)pxQueue->u.pcReadFrom, (size_t)pxQueue->uxItemSize);
+    }
+
+    pxQueue->uxMessagesWaiting = pxQueue->uxMessagesWaiting - (UBaseType_t)1;
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void *const pvItemToQueue,
+                             TickType_t xTicksToWait, const BaseType_t xCopyPosition) {
+    Queue_t *const pxQueue = (Queue_t *)xQueue;
+    BaseType_t     xReturn;
+
+    configASSERT(pxQueue);
+
+    {
+        std::unique_lock<std::mutex> xLock(pxQueue->xCriticalSection);
+
+        xReturn = prvWaitForQueue(pxQueue, xLock, xTicksToWait, [pxQueue] {
+            return pxQueue->uxMessagesWaiting < pxQueue->uxLength;
+        });
+
+        if (xReturn != pdFALSE) {
+            prvCopyDataToQueue(pxQueue, pvItemToQueue, xCopyPosition);
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+
+    if (xReturn != pdFALSE) {
+        pxQueue->xChanged.notify_all();
+    }
+
+    return (xReturn != pdFALSE) ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t xQueue, const void *const pvItemToQueue,
+                                    BaseType_t *const pxHigherPriorityTaskWoken,
+                                    const BaseType_t xCopyPosition) {
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+
+    return xQueueGenericSend(xQueue, pvItemToQueue, (TickType_t)0U, xCopyPosition);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *const pvBuffer, TickType_t xTicksToWait) {
+    Queue_t *const pxQueue = (Queue_t *)xQueue;
+    BaseType_t     xReturn;
+
+    configASSERT(pxQueue);
+
+    {
+        std::unique_lock<std::mutex> xLock(pxQueue->xCriticalSection);
+
+        xReturn = prvWaitForQueue(pxQueue, xLock, xTicksToWait, [pxQueue] {
+            return pxQueue->uxMessagesWaiting > (UBaseType_t)0;
+        });
+
+        if (xReturn != pdFALSE) {
+            prvCopyDataFromQueue(pxQueue, pvBuffer);
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+
+    if (xReturn != pdFALSE) {
+        pxQueue->xChanged.notify_all();
+    }
+
+    return (xReturn != pdFALSE) ? pdPASS : pdFAIL;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue) {
+    configASSERT(xQueue);
+
+    std::lock_guard<std::mutex> xLock(((Queue_t *)xQueue)->xCriticalSection);
+
+    return ((Queue_t *)xQueue)->uxMessagesWaiting;
+}
+
+UBaseType_t uxQueueGetHighWaterMark(const QueueHandle_t xQueue) {
+    configASSERT(xQueue);
+
+    std::lock_guard<std::mutex> xLock(((Queue_t *)xQueue)->xCriticalSection);
+
+    return ((Queue_t *)xQueue)->uxHighWaterMark;
+}
+
+void vQueueForEachWaitingItem(QueueHandle_t xQueue, void (*pxVisit)(void *pvItem, void *pvContext),
+                              void *pvContext) {
+    Queue_t *const pxQueue = (Queue_t *)xQueue;
+    int8_t *       pcItem;
+    UBaseType_t    uxItem;
+
+    configASSERT(pxQueue);
+    configASSERT(pxVisit);
+
+    std::lock_guard<std::mutex> xLock(pxQueue->xCriticalSection);
+
+    /* The same walk as prvCopyDataFromQueue() makes, without moving the read
+    position. */
+    pcItem = pxQueue->u.pcReadFrom;
+    for (uxItem = (UBaseType_t)0U; uxItem < pxQueue->uxMessagesWaiting; uxItem++) {
+        pcItem += pxQueue->uxItemSize;
+        if (pcItem >= pxQueue->pcTail) {
+            pcItem = pxQueue->pcHead;
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        pxVisit((void *)pcItem, pvContext);
+    }
 }
@@ -16,3 +16,100 @@ QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseTy
 #define xQueueCreate(uxQueueLength, uxItemSize)                                                    \
     xQueueGenericCreate((uxQueueLength), (uxItemSize), (queueQUEUE_TYPE_BASE))
 
+/* For internal use only. */
+#define queueSEND_TO_BACK ((BaseType_t)0)
+#define queueSEND_TO_FRONT ((BaseType_t)1)
+
+/*
+ * Post an item to a queue, blocking for up to xTicksToWait ticks for space to
+ * become available.  The item is copied into the queue.
+ *
+ * @return pdPASS if the item was posted, otherwise pdFAIL (errQUEUE_FULL).
+ */
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void *const pvItemToQueue,
+                             TickType_t xTicksToWait, const BaseType_t xCopyPosition);
+
+/*
+ * As xQueueGenericSend(), but never blocks.  pxHigherPriorityTaskWoken is set
+ * to pdFALSE as no task is ever unblocked directly in the simulator.
+ */
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t xQueue, const void *const pvItemToQueue,
+                                    BaseType_t *const pxHigherPriorityTaskWoken,
+                                    const BaseType_t xCopyPosition);
+
+/*
+ * Receive an item from a queue, blocking for up to xTicksToWait ticks for one
+ * to become available.  The item is copied into pvBuffer.
+ *
+ * @return pdPASS if an item was received, otherwise pdFAIL.
+ */
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *const pvBuffer, TickType_t xTicksToWait);
+
+/*
+ * Return the number of items currently held in the queue.
+ */
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue);
+
+/*
+ * Return the most items the queue has held at once since it was created or
+ * reset.
+ */
+UBaseType_t uxQueueGetHighWaterMark(const QueueHandle_t xQueue);
+
+/*
+ * Call pxVisit on every item waiting in the queue, oldest first, in place and
+ * with the queue locked, so the owner of the queue can rewrite items it no
+ * longer wants to receive.  pxVisit must not use the queue.  Not part of the
+ * FreeRTOS API.
+ */
+void vQueueForEachWaitingItem(QueueHandle_t xQueue, void (*pxVisit)(void *pvItem, void *pvContext),
+                              void *pvContext);
+
+/* ullDeadline value meaning vQueueWaitForMessageUntil() has no deadline. */
+#define queueNO_DEADLINE ((uint64_t)UINT64_MAX)
+
+/*
+ * For use by the timer service task only.  Block until the queue is not
+ * empty, or until xTicksToWait ticks have passed unless xWaitIndefinitely is
+ * pdTRUE, without removing anything from the queue.
+ */
+void vQueueWaitForMessageRestricted(QueueHandle_t xQueue, TickType_t xTicksToWait,
+                                    const BaseType_t xWaitIndefinitely);
+
+/*
+ * As vQueueWaitForMessageRestricted(), but waits until pxTickSource reaches
+ * xWakeTick rather than for a number of kernel ticks, and also returns once
+ * std::chrono::steady_clock reaches ullDeadline nanoseconds, unless ullDeadline
+ * is queueNO_DEADLINE.  xTimeNow is the tick count the caller worked xWakeTick
+ * out from, so a tick arriving in between does not delay the wake and an
+ * overflow is handled.  xQueue must be the queue bound to pxTickSource, see
+ * TickSource_t.
+ */
+void vQueueWaitForMessageUntil(QueueHandle_t xQueue, struct xTICK_SOURCE *const pxTickSource,
+                               const TickType_t xTimeNow, const TickType_t xWakeTick,
+                               const BaseType_t xWaitIndefinitely, const uint64_t ullDeadline);
+
+#if (configUSE_VIRTUAL_TIME == 1)
+/*
+ * Block until a task is waiting in vQueueWaitForMessageUntil() on
+ * pxTickSource with nothing in its queue and its timeout not yet reached, so
+ * it will do nothing more until a message arrives or the tick source is
+ * advanced.  Returns pdTRUE and the tick count it waits for in *pxWakeTick,
+ * or pdFALSE if it waits only for a message.
+ */
+BaseType_t xQueueWaitUntilTickSourceIdle(struct xTICK_SOURCE *const pxTickSource, TickType_t *const pxWakeTick);
+#endif
+
+/*
+ * Called by xTickSourceIncrement() when the tick set by
+ * vTickSourceSetNextUnblockTime() is reached, to wake the task blocked in
+ * vQueueWaitForMessageUntil() on the queue bound to pxTickSource.
+ */
+void vQueueUnblockWaitingTasks(struct xTICK_SOURCE *const pxTickSource);
+
+#define xQueueSendToBack(xQueue, pvItemToQueue, xTicksToWait)                                     \
+    xQueueGenericSend((xQueue), (pvItemToQueue), (xTicksToWait), queueSEND_TO_BACK)
+
+#define xQueueSendToBackFromISR(xQueue, pvItemToQueue, pxHigherPriorityTaskWoken)                 \
+    xQueueGenericSendFromISR((xQueue), (pvItemToQueue), (pxHigherPriorityTaskWoken),              \
+                             queueSEND_TO_BACK)
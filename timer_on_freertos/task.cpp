@@ -1,61 +1,128 @@
 #include "uds.h"
 #include "task.h"
+#include "queue.h"
+#include "timer_probes.h"
 #include <thread>
+#include <atomic>
+#include <chrono>
 
-/*PRIVILEGED_DATA */ static volatile TickType_t  xTickCount    = (TickType_t)0U;
+/* The kernel tick, and the tick at which tasks blocked with a timeout must be
+woken. */
+/*PRIVILEGED_DATA */ static TickSource_t xSystemTickSource = {
+    (TickType_t)0U,
+    portMAX_DELAY,
+    {NULL},
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+    {(uint64_t)0U},
+#endif
+#if (configUSE_VIRTUAL_TIME == 1)
+    NULL,
+    (TickType_t)0U,
+    (TickType_t)0U,
+    pdFALSE,
+#endif
+};
 /*PRIVILEGED_DATA */ static volatile UBaseType_t uxPendedTicks = (UBaseType_t)0U;
-/*PRIVILEGED_DATA */ static volatile TickType_t  xNextTaskUnblockTime =
-    (TickType_t)0U; /* Initialised to portMAX_DELAY before the scheduler starts. */
 
 /*PRIVILEGED_DATA */ static volatile UBaseType_t uxSchedulerSuspended = (UBaseType_t)pdFALSE;
 //PRIVILEGED_DATA                                  TCB_t *volatile pxCurrentTCB = NULL;
 
+TickSource_t *pxTaskGetTickSource(void) {
+    return &xSystemTickSource;
+}
+
 TickType_t xTaskGetTickCount(void) {
+    return xTickSourceGetCount(&xSystemTickSource);
+}
+
+TickType_t xTickSourceGetCount(const TickSource_t *const pxTickSource) {
     TickType_t xTicks;
 
     /* Critical section required if running on a 16 bit processor. */
     // portTICK_TYPE_ENTER_CRITICAL();
-    { xTicks = xTickCount; }
+    { xTicks = pxTickSource->xTickCount; }
     // portTICK_TYPE_EXIT_CRITICAL();
 
     return xTicks;
 }
 
+void vTaskSetNextUnblockTime(const TickType_t xUnblockTime) {
+    vTickSourceSetNextUnblockTime(&xSystemTickSource, xUnblockTime);
+}
+
+void vTickSourceSetNextUnblockTime(TickSource_t *const pxTickSource, const TickType_t xUnblockTime) {
+    pxTickSource->xNextUnblockTime = xUnblockTime;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
 BaseType_t xTaskIncrementTick(void) {
-    //TCB_t *    pxTCB;
-    TickType_t xItemValue;
     BaseType_t xSwitchRequired = pdFALSE;
     
-    traceTASK_INCREMENT_TICK(xTickCount);
+    traceTASK_INCREMENT_TICK(xSystemTickSource.xTickCount);
+    taskPROBE_TICK(xSystemTickSource.xTickCount);
     if (uxSchedulerSuspended == (UBaseType_t)pdFALSE) {
 #ifdef _DEBUG
         //printf("Tick Value: %d", xTickCount++);
 #endif // _DEBUG
-        /* Minor optimisation.  The tick count cannot change in this
-        block. */
-        const TickType_t xConstTickCount = xTickCount + 1;
-
-        /* Increment the RTOS tick, switching the delayed and overflowed
-        delayed lists if it wraps to 0. */
-        xTickCount = xConstTickCount;
-
-        if (xConstTickCount == (TickType_t)0U)
-        {
-            //taskSWITCH_DELAYED_LISTS();
-        }
-        else
-        {
-            mtCOVERAGE_TEST_MARKER();
-        }
-        /* See if this tick has made a timeout expire.  Tasks are stored in
-        the	queue in the order of their wake time - meaning once one task
-        has been found whose block time has not expired there is no need to
-        look any further down the list. */
-        if (xConstTickCount >= xNextTaskUnblockTime)
-        {
-        }
+        xSwitchRequired = xTickSourceIncrement(&xSystemTickSource);
     } else {
-        ++uxPendedTicks;
+        uxPendedTicks = uxPendedTicks + 1U;
+    }
+
+    return xSwitchRequired;
+}
+
+BaseType_t xTickSourceIncrement(TickSource_t *const pxTickSource) {
+    BaseType_t xSwitchRequired = pdFALSE;
+
+    /* Minor optimisation.  The tick count cannot change in this
+    block. */
+    const TickType_t xConstTickCount = pxTickSource->xTickCount + 1;
+
+    /* Increment the RTOS tick, switching the delayed and overflowed
+    delayed lists if it wraps to 0. */
+    pxTickSource->xTickCount = xConstTickCount;
+
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+    /* Same clock as ullTimerGetMonotonicTime(), for measuring how long after
+    this tick the timers it made due are called. */
+    pxTickSource->ullLastTickTime.store((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::steady_clock::now().time_since_epoch())
+                                            .count(),
+                                        std::memory_order_relaxed);
+#endif
+
+    /* Pairs with the fence in vTickSourceSetNextUnblockTime() - either this
+    thread sees the new unblock time, or the blocked task sees the new
+    tick count before it waits. */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (xConstTickCount == (TickType_t)0U)
+    {
+        //taskSWITCH_DELAYED_LISTS();
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+    /* See if this tick has made a timeout expire.  Tasks are stored in
+    the	queue in the order of their wake time - meaning once one task
+    has been found whose block time has not expired there is no need to
+    look any further down the list. */
+    if (xConstTickCount == pxTickSource->xNextUnblockTime)
+    {
+        /* Every tick value is passed through, so an exact match cannot
+        be missed and is not confused by the tick count overflowing.  The
+        unblock time is left as it is rather than reset, as the task may
+        already have set the next one under the queue lock, and a reset
+        here would overwrite it.  A stale value only costs a spurious wake
+        when the tick count comes round to it again. */
+        vQueueUnblockWaitingTasks(pxTickSource);
+        xSwitchRequired = pdTRUE;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
     }
 
     return xSwitchRequired;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 /* Definitions returned by xTaskGetSchedulerState().  taskSCHEDULER_SUSPENDED is
 0 to generate more optimal code when configASSERT() is defined as the constant
 is used in assert() statements. */
@@ -14,6 +16,54 @@ is used in assert() statements. */
 BaseType_t CreateTimerManageTask(void);
 BaseType_t xTaskIncrementTick(void);
 
+/*
+ * A tick count and the tick at which a task blocked on it must be woken.  The
+ * kernel tick driven by xTaskIncrementTick() is one tick source, timer domains
+ * with their own tick rate (see xTimerDomainCreate()) each have another.
+ */
+typedef struct xTICK_SOURCE {
+    volatile TickType_t xTickCount;
+    volatile TickType_t xNextUnblockTime; /*<< portMAX_DELAY until a task first waits, not reset once reached. */
+    /* The queue the task of the tick source waits on, bound when the queue is
+    created and read by the tick thread to wake the task. */
+    std::atomic<void *> pvWakeQueue; /*<< NULL until bound. */
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+    /* Written by the tick thread and read by the timer service task, relaxed
+    as it is only used for statistics. */
+    std::atomic<uint64_t> ullLastTickTime; /*<< The monotonic time of the last tick, 0 before the first. */
+#endif
+#if (configUSE_VIRTUAL_TIME == 1)
+    /* The wait of the task blocked in vQueueWaitForMessageUntil(), if any, so
+    vQueueWaitUntilTickSourceIdle() can tell whether it is due to wake.  Only
+    accessed with the lock of pvWakeQueue held. */
+    void *     pvWaitingQueue; /*<< NULL if no task is blocked on this tick source. */
+    TickType_t xWaitStartTick;
+    TickType_t xWaitTicks;
+    BaseType_t xWaitIndefinitely;
+#endif
+} TickSource_t;
+
+/* The tick source advanced by xTaskIncrementTick(). */
+TickSource_t *pxTaskGetTickSource(void);
+
+TickType_t xTickSourceGetCount(const TickSource_t *const pxTickSource);
+
+/*
+ * Advance the tick source by one tick, waking a task blocked in
+ * vQueueWaitForMessageUntil() if its timeout has been reached.  Returns pdTRUE
+ * if a task was woken.
+ */
+BaseType_t xTickSourceIncrement(TickSource_t *const pxTickSource);
+
+void vTickSourceSetNextUnblockTime(TickSource_t *const pxTickSource, const TickType_t xUnblockTime);
+
+/*
+ * Set the tick count at which xTaskIncrementTick() wakes tasks blocked with a
+ * timeout, see vQueueWaitForMessageRestricted().  portMAX_DELAY if no task
+ * needs to be woken.
+ */
+void vTaskSetNextUnblockTime(const TickType_t xUnblockTime);
+
     /**
  * task. h
  * <PRE>TickType_t xTaskGetTickCount( void );</PRE>
@@ -4,7 +4,21 @@
 #include "list.h"
 #include "timer.h"
 #include "queue.h"
+#include "timer_probes.h"
+#include "timer_capture.h"
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <new>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#if ((configUSE_TIMER_POOL == 1) && (configSUPPORT_STATIC_ALLOCATION == 1))
+    #error configUSE_TIMER_POOL cannot be used with configSUPPORT_STATIC_ALLOCATION as every timer must live in the pool
+#endif
 
 /* Misc definitions. */
 #define tmrNO_DELAY (TickType_t)0U
@@ -18,19 +32,30 @@ enum TimerState
     STATE_STOPPED,
 };
 
-/* The definition of the timers themselves. */
-typedef struct tmrTimerControl {
+#if (configUSE_TIMER_CALLBACK_ACCOUNTING == 1)
+/* What the callback of a timer has cost, see vTimerGetCallbackStats().  Only
+the timer service task writes the counters. */
+typedef struct tmrTimerCallbackAccount {
+    std::atomic<uint64_t> ullBudget; /*<< In nanoseconds, or 0 for no limit. */
+    std::atomic<uint64_t> ullCalls;
+    std::atomic<uint64_t> ullWallTime;
+    std::atomic<uint64_t> ullCpuTime;
+    std::atomic<uint64_t> ullMaxWallTime;
+    std::atomic<uint64_t> ullOverruns;
+} TimerCallbackAccount_t;
+#endif
+
+/* Timer fields that are only touched when a timer is created, deleted,
+expires or is inspected by a debugger.  They are kept out of Timer_t so the list
+walks that insert timers and the expiry scans do not drag them through the
+cache. */
+typedef struct tmrTimerMetadata {
+    TimerCallbackFunction_t
+        pxCallbackFunction; /*<< The function that will be called when the timer expires. */
     const char				*pcTimerName;		/*<< Text name.  This is not used by the kernel, it is included simply to make debugging easier. */ /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
-    ListItem_t xTimerListItem; /*<< Standard linked list item as used by all kernel features for
-                                  event management. */
-    TickType_t xTimerPeriodInTicks; /*<< How quickly and often the timer expires. */
-    UBaseType_t
-        uxAutoReload; /*<< Set to pdTRUE if the timer should be automatically restarted once
-                         expired.  Set to pdFALSE if the timer is, in effect, a one-shot timer. */
     void *pvTimerID;  /*<< An ID to identify the timer.  This allows the timer to be identified when
                          the same callback is used for multiple timers. */
-    TimerCallbackFunction_t
-        pxCallbackFunction; /*<< The function that will be called when the timer expires. */
+    struct tmrTimerDomain *pxDomain; /*<< The domain whose timer service task runs the timer. */
 #if (configUSE_TRACE_FACILITY == 1)
     UBaseType_t uxTimerNumber; /*<< An ID assigned by trace tools such as FreeRTOS+Trace */
 #endif
@@ -40,18 +65,120 @@ typedef struct tmrTimerControl {
         ucStaticallyAllocated; /*<< Set to pdTRUE if the timer was created statically so no attempt
                                   is made to free the memory again if the timer is later deleted. */
 #endif
+
+#if (configUSE_TIMER_POOL == 0)
+    TimerContextDestructor_t
+        pxContextDestructor; /*<< Called on the storage given by xTimerCreateWithContext() when the
+                                timer is deleted, or NULL. */
+    struct tmrTimerArray *pxArray; /*<< The block holding the timer if it was created by
+                                      xTimerCreateArray(), otherwise NULL. */
+#endif
+
+#if (configUSE_TIMER_CALLBACK_ACCOUNTING == 1)
+    TimerCallbackAccount_t xAccount;
+#endif
+} TimerMetadata_t;
+
+/* The definition of the timers themselves.  Only the fields used while a
+timer is inserted, scanned or rescheduled live here.  Rather than a ListItem_t
+the timer carries its own links, see TimerList_t, with the expiry time and the
+next link that a sorted insertion walks first, so the walk reads the first 16
+bytes of each timer it passes.  The structure is 48 bytes on 64-bit targets
+(and 28 bytes on 32-bit ones), four timers to three 64 byte cache lines where
+timers are stored together, as by xTimerCreateArray() and static tables.  When
+configUSE_TIMER_POOL is 1 the links and metadata are found from the position of
+the timer in the pool instead, leaving 8 bytes per timer here plus a 16 byte
+IndexListItem_t. */
+typedef struct tmrTimerControl {
+#if (configUSE_TIMER_POOL == 0)
+    TickType_t xItemValue; /*<< The tick the timer expires on, the key of the sorted list. */
+#endif
+    TickType_t xTimerPeriodInTicks; /*<< How quickly and often the timer expires.  Fills what would
+                                       otherwise be padding before pxNext. */
+#if (configUSE_TIMER_POOL == 0)
+    struct tmrTimerControl *pxNext;     /*<< The next timer in the list, or its end marker. */
+    struct tmrTimerControl *pxPrevious; /*<< The previous timer in the list, or its end marker. */
+    struct tmrTimerList *pxContainer;   /*<< The list the timer is in, or NULL. */
+#endif
+    uint8_t
+        ucAutoReload; /*<< Set to pdTRUE if the timer should be automatically restarted once
+                         expired.  Set to pdFALSE if the timer is, in effect, a one-shot timer. */
+    uint8_t ucCatchUpPolicy : 4; /*<< One of the tmrCATCH_UP_* values, see vTimerSetCatchUpPolicy().
+                                    Uses what would otherwise be padding. */
+    uint8_t ucPriority : 4;      /*<< The priority class, see vTimerSetPriority().  Shares the byte
+                                    with ucCatchUpPolicy. */
+    uint16_t usMissedPeriods; /*<< Periods skipped before the current expiry, see
+                                 uxTimerGetMissedPeriods().  Also in padding. */
+#if (configUSE_TIMER_POOL == 0)
+    TimerMetadata_t *pxMetadata; /*<< The rarely used part of the timer, see TimerMetadata_t. */
+#endif
 } xTIMER;
 
 /* The old xTIMER name is maintained above then typedefed to the new Timer_t
 name below to enable the use of older kernel aware debuggers. */
 typedef xTIMER Timer_t;
 
+#if (configUSE_TIMER_POOL == 0)
+/* A dynamically allocated timer is followed in the same allocation by any
+storage requested through xTimerCreateWithContext(), aligned for any type. */
+#define tmrCONTEXT_OFFSET                                                                        \
+    ((sizeof(Timer_t) + alignof(std::max_align_t) - 1U) & ~(alignof(std::max_align_t) - 1U))
+#endif
+
+#if (configUSE_TIMER_POOL == 0)
+/* The header of the block allocated by xTimerCreateArray(), which is followed
+by the hot parts of all the timers and then their metadata.  The block is freed
+when the last of its timers is deleted. */
+typedef struct tmrTimerArray {
+    UBaseType_t uxTimersNotDeleted; /*<< Only accessed by the timer service task once created. */
+} TimerArray_t;
+
+#define tmrARRAY_HEADER_SIZE                                                                     \
+    ((sizeof(TimerArray_t) + alignof(std::max_align_t) - 1U) & ~(alignof(std::max_align_t) - 1U))
+
+/* Where the metadata starts in a block of uxNumberOfTimers timers. */
+#define tmrARRAY_METADATA_OFFSET(uxNumberOfTimers)                                               \
+    ((tmrARRAY_HEADER_SIZE + ((uxNumberOfTimers) * sizeof(Timer_t)) + alignof(TimerMetadata_t) - 1U) & \
+     ~(alignof(TimerMetadata_t) - 1U))
+#endif
+
+/* The layout of a statically allocated timer.  StaticTimer_t in uds.h mirrors
+this structure. */
+typedef struct tmrStaticTimerStorage {
+    Timer_t         xTimer;
+    TimerMetadata_t xMetadata;
+} StaticTimerStorage_t;
+
 typedef struct tmrTimerParameters {
     TickType_t xMessageValue; /*<< An optional value used by a subset of commands, for example, when
                                  changing the period of a timer. */
     Timer_t *pxTimer;         /*<< The timer to which the command will be applied. */
 } TimerParameter_t;
 
+#if (configUSE_HIGH_RES_TIMERS == 1)
+
+/* A timer whose period and expiry time are in nanoseconds of the monotonic
+clock rather than in ticks.  Active high resolution timers are kept in their
+own list, in expiry time order, which only the timer service task accesses. */
+typedef struct tmrHighResTimer {
+    uint64_t ullExpiryTime; /*<< When the timer next expires, see ullTimerGetMonotonicTime(). */
+    uint64_t ullPeriod;     /*<< The period in nanoseconds. */
+    struct tmrHighResTimer *pxNext;
+    struct tmrHighResTimer *pxPrevious;
+    HighResTimerCallbackFunction_t pxCallbackFunction;
+    uint8_t ucAutoReload;
+    uint8_t ucIsActive; /*<< pdTRUE while the timer is in the active list. */
+    const char *pcTimerName;
+    void *pvTimerID;
+} HighResTimer_t;
+
+typedef struct tmrHighResTimerParameters {
+    uint64_t ullMessageValue;  /*<< The command time, or the new period. */
+    HighResTimer_t *pxTimer;
+} HighResTimerParameter_t;
+
+#endif /* configUSE_HIGH_RES_TIMERS */
+
 typedef struct tmrCallbackParameters {
     PendedFunction_t pxCallbackFunction; /* << The callback function to execute. */
     void *pvParameter1; /* << The value that will be used as the callback functions first parameter.
@@ -60,58 +187,427 @@ typedef struct tmrCallbackParameters {
                               parameter. */
 } CallbackParameters_t;
 
+/* Passed by a tmrCOMMAND_FENCE message, see prvWaitForTimerTask(). */
+typedef struct tmrTimerFence {
+    std::mutex              xMutex;
+    std::condition_variable xPassed;
+    BaseType_t              xHasPassed; /*<< Set by the timer service task, under xMutex. */
+} TimerFence_t;
+
 /* The structure that contains the two message types, along with an identifier
 that is used to determine which message type is valid. */
 typedef struct tmrTimerQueueMessage {
     BaseType_t xMessageID; /*<< The command being sent to the timer service task. */
     union {
         TimerParameter_t xTimerParameters;
+#if (configUSE_HIGH_RES_TIMERS == 1)
+        HighResTimerParameter_t xHighResTimerParameters;
+#endif
+        TimerFence_t *pxFence; /*<< For tmrCOMMAND_FENCE. */
 
-/* Don't include xCallbackParameters if it is not going to be used as
-it makes the structure (and therefore the timer queue) larger. */
-#if (INCLUDE_xTimerPendFunctionCall == 1)
-        CallbackParameters_t xCallbackParameters;
-#endif /* INCLUDE_xTimerPendFunctionCall */
+        /* Pended function calls are not carried by the message, a
+        tmrCOMMAND_EXECUTE_CALLBACK message only wakes the timer service task
+        to run those waiting in xPendedCalls. */
     } u;
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+    uint64_t ullSendTime; /*<< When the command was sent, see tmrHISTOGRAM_COMMAND_LATENCY. */
+#endif
 } DaemonTaskMessage_t;
 
-/* The list in which active timers are stored.  
-Timers are referenced in expire time order, with the nearest expiry time at the front of the list.  
-Only the timer service task is allowed to access these lists. */
-/*PRIVILEGED_DATA */static List_t xActiveTimerList1;
-/*PRIVILEGED_DATA */static List_t xActiveTimerList2;
-static List_t *pxCurrentTimerList;
-static List_t *pxOverflowTimerList ;
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+
+#if ((configTIMER_PEND_QUEUE_LENGTH & (configTIMER_PEND_QUEUE_LENGTH - 1)) != 0)
+    #error configTIMER_PEND_QUEUE_LENGTH must be a power of two
+#endif
+
+/* A slot of the bounded multi-producer queue of pended function calls.  The
+slot used for call number x is x % configTIMER_PEND_QUEUE_LENGTH, and
+xSequence says what the slot is waiting for: call x to be written when it
+holds x, or call x to be read when it holds x + 1.  xSequence is stored less
+the slot index so the zero initialised array starts out empty. */
+typedef struct tmrPendedCallSlot {
+    std::atomic<size_t>  xSequence;
+    CallbackParameters_t xCall;
+} PendedCallSlot_t;
+
+static PendedCallSlot_t xPendedCalls[configTIMER_PEND_QUEUE_LENGTH];
+static std::atomic<size_t> xNextPendedCallToWrite(0U);
+static size_t xNextPendedCallToRead = 0U; /*<< Only used by the timer service task. */
+
+/* Set while a tmrCOMMAND_EXECUTE_CALLBACK message is on its way, so only the
+first of a burst of pended calls sends one. */
+static std::atomic<bool> xPendedCallsSignalled(false);
+static std::atomic<UBaseType_t> uxPendedCallsRejected(0U);
+
+/* Tasks in xTimerPendFunctionCall() waiting for space. */
+static std::atomic<UBaseType_t> uxPendedCallWaiters(0U);
+static std::mutex xPendedCallSpaceMutex;
+static std::condition_variable xPendedCallSpace;
+
+#endif /* INCLUDE_xTimerPendFunctionCall */
+
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+
+#define tmrHISTOGRAMS ((UBaseType_t)2)
+#define tmrHISTOGRAM_CLASSES (tmrPRIORITY_HIGHEST + 1U)
+
+/* Each power of two from 8 up is split into 1 << tmrHISTOGRAM_SUB_BUCKET_BITS
+buckets, giving tmrHISTOGRAM_BUCKETS buckets for a 64-bit value. */
+#define tmrHISTOGRAM_SUB_BUCKET_BITS 3U
+#define tmrHISTOGRAM_SUB_BUCKETS (1U << tmrHISTOGRAM_SUB_BUCKET_BITS)
+
+/* Written by the timer service task of every domain, so the counts are
+atomic, but only their totals matter so relaxed ordering is enough. */
+typedef struct tmrHistogram {
+    std::atomic<uint32_t> ulCounts[tmrHISTOGRAM_BUCKETS];
+} Histogram_t;
+
+static Histogram_t xHistograms[tmrHISTOGRAMS][tmrHISTOGRAM_CLASSES];
+
+#endif /* configUSE_TIMER_HISTOGRAMS */
+
+#if (configUSE_TIMER_BATCH_CALLBACKS == 1)
+
+/* A callback function that has a batch form registered, see
+xTimerRegisterBatchCallback(). */
+typedef struct tmrBatchCallback {
+    TimerCallbackFunction_t      pxCallbackFunction;
+    TimerBatchCallbackFunction_t pxBatchCallbackFunction;
+} BatchCallback_t;
+
+/* The timers of one domain that expired in the current sweep and use the
+batch callback with the same index. */
+typedef struct tmrPendingBatch {
+    size_t        xPendingTimers;
+    TimerHandle_t xTimers[configTIMER_BATCH_LENGTH];
+} PendingBatch_t;
+
+/*PRIVILEGED_DATA */static BatchCallback_t xBatchCallbacks[configTIMER_BATCH_CALLBACKS];
+
+/* Entries are only ever added, and are complete before the count is
+published, so the timer service task reads the table without locking. */
+static std::atomic<UBaseType_t> uxBatchCallbacksRegistered(0U);
+static std::mutex xBatchCallbackMutex;
+
+#endif /* configUSE_TIMER_BATCH_CALLBACKS */
+
+#if (configUSE_TIMER_POOL == 1)
+
+/* The end markers of the two active timer lists of each domain occupy the
+first slots of the list item array, the timers themselves follow. */
+#define tmrPOOL_LIST_END_SLOTS ((ListIndex_t)(2U * configTIMER_MAX_DOMAINS))
+
+/* The pool from which all timers are allocated.  Slot n of xTimerListItems
+(n >= tmrPOOL_LIST_END_SLOTS) is the list item of xTimerPool[n -
+tmrPOOL_LIST_END_SLOTS], and xTimerMetadataPool is indexed the same way. */
+/*PRIVILEGED_DATA */static IndexListItem_t xTimerListItems[tmrPOOL_LIST_END_SLOTS + configTIMER_POOL_SIZE];
+/*PRIVILEGED_DATA */static Timer_t xTimerPool[configTIMER_POOL_SIZE];
+/*PRIVILEGED_DATA */static TimerMetadata_t xTimerMetadataPool[configTIMER_POOL_SIZE];
+
+/* Slots that have never been used are handed out in order, slots of deleted
+timers are chained through their ulNext member. */
+static ListIndex_t ulNextUnusedTimerSlot = tmrPOOL_LIST_END_SLOTS;
+static ListIndex_t ulFreeTimerSlots = listINDEX_NONE;
+static std::mutex xTimerPoolMutex;
+
+typedef ListIndex_t TimerList_t;
+
+#define tmrTIMER_SLOT(pxTimer) ((ListIndex_t)((pxTimer) - xTimerPool) + tmrPOOL_LIST_END_SLOTS)
+#define tmrTIMER_IN_SLOT(ulSlot)                                                                  \
+    ((Timer_t *)listINDEX_GET_OWNER(xTimerPool, sizeof(Timer_t), (ulSlot) - tmrPOOL_LIST_END_SLOTS))
+
+#define tmrGET_METADATA(pxTimer) (&(xTimerMetadataPool[(pxTimer) - xTimerPool]))
+#define tmrLIST_INITIALISE(pxList) vIndexListInitialise(xTimerListItems, *(pxList))
+#define tmrLIST_IS_EMPTY(pxList) listINDEX_LIST_IS_EMPTY(xTimerListItems, *(pxList))
+#define tmrLIST_LENGTH(pxList) ((UBaseType_t)listINDEX_CURRENT_LIST_LENGTH(xTimerListItems, *(pxList)))
+#define tmrGET_ITEM_VALUE_OF_HEAD_ENTRY(pxList)                                                  \
+    listINDEX_GET_ITEM_VALUE_OF_HEAD_ENTRY(xTimerListItems, *(pxList))
+#define tmrGET_OWNER_OF_HEAD_ENTRY(pxList)                                                       \
+    tmrTIMER_IN_SLOT(listINDEX_GET_HEAD_ENTRY(xTimerListItems, *(pxList)))
+#define tmrINITIALISE_TIMER_ITEM(pxTimer)                                                        \
+    vIndexListInitialiseItem(xTimerListItems, tmrTIMER_SLOT(pxTimer))
+#define tmrSET_TIMER_ITEM_VALUE(pxTimer, xValue)                                                 \
+    listINDEX_SET_LIST_ITEM_VALUE(xTimerListItems, tmrTIMER_SLOT(pxTimer), (xValue))
+#define tmrINSERT_TIMER(pxList, pxTimer)                                                         \
+    uxIndexListInsert(xTimerListItems, *(pxList), tmrTIMER_SLOT(pxTimer))
+#define tmrINSERT_TIMER_AT_END(pxList, pxTimer)                                                  \
+    vIndexListInsertEnd(xTimerListItems, *(pxList), tmrTIMER_SLOT(pxTimer))
+#define tmrGET_ITEM_VALUE_OF_TAIL_ENTRY(pxList)                                                  \
+    listINDEX_GET_ITEM_VALUE_OF_TAIL_ENTRY(xTimerListItems, *(pxList))
+#define tmrREMOVE_TIMER(pxTimer) (void)uxIndexListRemove(xTimerListItems, tmrTIMER_SLOT(pxTimer))
+#define tmrTIMER_IS_IN_A_LIST(pxTimer)                                                           \
+    (listINDEX_LIST_ITEM_CONTAINER(xTimerListItems, tmrTIMER_SLOT(pxTimer)) != listINDEX_NONE)
+#define tmrTIMER_IS_IN_LIST(pxList, pxTimer)                                                     \
+    listINDEX_IS_CONTAINED_WITHIN(xTimerListItems, *(pxList), tmrTIMER_SLOT(pxTimer))
+#define tmrGET_TIMER_ITEM_VALUE(pxTimer)                                                         \
+    listINDEX_GET_LIST_ITEM_VALUE(xTimerListItems, tmrTIMER_SLOT(pxTimer))
+#define tmrGET_NEXT_TIMER(pxList, pxTimer)                                                       \
+    ((xTimerListItems[tmrTIMER_SLOT(pxTimer)].ulNext != *(pxList))                               \
+         ? tmrTIMER_IN_SLOT(xTimerListItems[tmrTIMER_SLOT(pxTimer)].ulNext)                      \
+         : NULL)
+
+#else
+
+/* A list of timers sorted by expiry time, kept as List_t keeps its items, but
+linking the timers themselves so no pvOwner is needed.  As with xListEnd in
+List_t the end marker holds portMAX_DELAY, so the walk in prvTimerListInsert()
+needs no end test.  Only its links and value are used. */
+typedef struct tmrTimerList {
+    UBaseType_t uxNumberOfItems;
+    Timer_t     xListEnd;
+} TimerList_t;
+
+#define tmrGET_METADATA(pxTimer) ((pxTimer)->pxMetadata)
+#define tmrLIST_INITIALISE(pxList) prvTimerListInitialise(pxList)
+#define tmrLIST_IS_EMPTY(pxList) (((pxList)->uxNumberOfItems == (UBaseType_t)0U) ? pdTRUE : pdFALSE)
+#define tmrLIST_LENGTH(pxList) ((pxList)->uxNumberOfItems)
+#define tmrGET_ITEM_VALUE_OF_HEAD_ENTRY(pxList) ((pxList)->xListEnd.pxNext->xItemValue)
+#define tmrGET_OWNER_OF_HEAD_ENTRY(pxList) ((pxList)->xListEnd.pxNext)
+#define tmrINITIALISE_TIMER_ITEM(pxTimer) ((pxTimer)->pxContainer = NULL)
+#define tmrSET_TIMER_ITEM_VALUE(pxTimer, xValue) ((pxTimer)->xItemValue = (xValue))
+#define tmrINSERT_TIMER(pxList, pxTimer) prvTimerListInsert((pxList), (pxTimer))
+#define tmrINSERT_TIMER_AT_END(pxList, pxTimer) prvTimerListLink((pxList), &((pxList)->xListEnd), (pxTimer))
+#define tmrGET_ITEM_VALUE_OF_TAIL_ENTRY(pxList) ((pxList)->xListEnd.pxPrevious->xItemValue)
+#define tmrREMOVE_TIMER(pxTimer) prvTimerListRemove(pxTimer)
+#define tmrTIMER_IS_IN_A_LIST(pxTimer) ((pxTimer)->pxContainer != NULL)
+#define tmrTIMER_IS_IN_LIST(pxList, pxTimer) (((pxTimer)->pxContainer == (pxList)) ? pdTRUE : pdFALSE)
+#define tmrGET_TIMER_ITEM_VALUE(pxTimer) ((pxTimer)->xItemValue)
+#define tmrGET_NEXT_TIMER(pxList, pxTimer)                                                       \
+    (((pxTimer)->pxNext != &((pxList)->xListEnd)) ? (pxTimer)->pxNext : NULL)
+
+static void prvTimerListInitialise(TimerList_t *const pxList) {
+    pxList->uxNumberOfItems       = (UBaseType_t)0U;
+    pxList->xListEnd.xItemValue   = portMAX_DELAY;
+    pxList->xListEnd.pxNext       = &(pxList->xListEnd);
+    pxList->xListEnd.pxPrevious   = &(pxList->xListEnd);
+    pxList->xListEnd.pxContainer  = NULL;
+}
+
+/* Link pxTimer in before pxPosition. */
+static void prvTimerListLink(TimerList_t *const pxList, Timer_t *const pxPosition, Timer_t *const pxTimer) {
+    pxTimer->pxNext                = pxPosition;
+    pxTimer->pxPrevious            = pxPosition->pxPrevious;
+    pxPosition->pxPrevious->pxNext = pxTimer;
+    pxPosition->pxPrevious         = pxTimer;
+    pxTimer->pxContainer           = pxList;
+
+    (pxList->uxNumberOfItems)++;
+}
+
+/* As uxListInsert(), returns the number of timers passed. */
+static UBaseType_t prvTimerListInsert(TimerList_t *const pxList, Timer_t *const pxTimer) {
+    const TickType_t xValueOfInsertion = pxTimer->xItemValue;
+    Timer_t *pxIterator;
+    UBaseType_t uxItemsPassed = (UBaseType_t)0U;
+
+    /* Timers with equal values go after those already in the list, with the
+    end marker value handled separately so the walk is sure to end. */
+    if (xValueOfInsertion == portMAX_DELAY) {
+        pxIterator = &(pxList->xListEnd);
+    } else {
+        for (pxIterator = pxList->xListEnd.pxNext; pxIterator->xItemValue <= xValueOfInsertion;
+             pxIterator = pxIterator->pxNext) {
+            uxItemsPassed++;
+        }
+    }
+
+    prvTimerListLink(pxList, pxIterator, pxTimer);
+
+    return uxItemsPassed;
+}
+
+static void prvTimerListRemove(Timer_t *const pxTimer) {
+    TimerList_t *const pxList = pxTimer->pxContainer;
+
+    pxTimer->pxNext->pxPrevious = pxTimer->pxPrevious;
+    pxTimer->pxPrevious->pxNext = pxTimer->pxNext;
+    pxTimer->pxContainer        = NULL;
+
+    (pxList->uxNumberOfItems)--;
+}
+
+#endif /* configUSE_TIMER_POOL */
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1) || (configUSE_TIMER_SNAPSHOT == 1)
+
+/* For timers linked in expiry order, as by xTimerCreateStaticTable() and a
+snapshot restore.  Each normally goes on the end of its list, which costs no
+walk and keeps timers that expire on the same tick in the order they were
+linked.  Timers already in the list can still be later. */
+static void prvAppendTimer(TimerList_t *const pxList, Timer_t *const pxTimer) {
+    if ((tmrLIST_IS_EMPTY(pxList) != pdFALSE) ||
+        (tmrGET_ITEM_VALUE_OF_TAIL_ENTRY(pxList) <= tmrGET_TIMER_ITEM_VALUE(pxTimer))) {
+        tmrINSERT_TIMER_AT_END(pxList, pxTimer);
+    } else {
+        (void)tmrINSERT_TIMER(pxList, pxTimer);
+    }
+}
+
+#endif
+
+#if (configUSE_TIMER_STATS == 1)
+
+/* The counters behind vTimerGetStats().  Only the timer service task of the
+domain writes them, so they are bumped with a relaxed load and store rather
+than a locked increment. */
+typedef struct tmrTimerDomainStats {
+    std::atomic<UBaseType_t> uxCurrentListTimers;
+    std::atomic<UBaseType_t> uxOverflowListTimers;
+    std::atomic<uint32_t>    ulCommandsProcessed[tmrSTATS_COMMAND_TYPES];
+    std::atomic<uint32_t>    ulOtherMessagesProcessed;
+    std::atomic<uint32_t>    ulExpirations;
+    std::atomic<uint32_t>    ulListSwitches;
+    std::atomic<uint32_t>    ulWakeUps;
+    std::atomic<uint32_t>    ulUsefulWakeUps;
+    std::atomic<uint64_t>    ullInserts;
+    std::atomic<uint64_t>    ullInsertSteps;
+    BaseType_t               xAwaitingWork; /*<< pdTRUE from a wake up until something is done. */
+} TimerDomainStats_t;
+
+#define tmrSTATS_ADD(xCounter, xAmount)                                                          \
+    (xCounter).store((xCounter).load(std::memory_order_relaxed) + (xAmount), std::memory_order_relaxed)
+
+/* Count a wake up as useful the first time it leads to some work. */
+#define tmrSTATS_WORK_DONE(pxDomain)                                                             \
+    if ((pxDomain)->xStats.xAwaitingWork != pdFALSE) {                                           \
+        (pxDomain)->xStats.xAwaitingWork = pdFALSE;                                              \
+        tmrSTATS_ADD((pxDomain)->xStats.ulUsefulWakeUps, 1U);                                    \
+    }
+
+#define tmrSTATS_WAKE_UP(pxDomain)                                                               \
+    {                                                                                             \
+        tmrSTATS_ADD((pxDomain)->xStats.ulWakeUps, 1U);                                          \
+        (pxDomain)->xStats.xAwaitingWork = pdTRUE;                                               \
+    }
+#define tmrSTATS_EXPIRED(pxDomain)                                                               \
+    {                                                                                             \
+        tmrSTATS_ADD((pxDomain)->xStats.ulExpirations, 1U);                                      \
+        tmrSTATS_WORK_DONE(pxDomain);                                                            \
+    }
+#define tmrSTATS_MESSAGE(pxDomain, xMessageID)                                                   \
+    {                                                                                             \
+        if (((xMessageID) >= (BaseType_t)0) && ((xMessageID) < (BaseType_t)tmrSTATS_COMMAND_TYPES)) { \
+            tmrSTATS_ADD((pxDomain)->xStats.ulCommandsProcessed[(xMessageID)], 1U);              \
+        } else {                                                                                  \
+            tmrSTATS_ADD((pxDomain)->xStats.ulOtherMessagesProcessed, 1U);                       \
+        }                                                                                         \
+        tmrSTATS_WORK_DONE(pxDomain);                                                            \
+    }
+#define tmrSTATS_LIST_SWITCH(pxDomain) tmrSTATS_ADD((pxDomain)->xStats.ulListSwitches, 1U)
+#define tmrSTATS_LIST_LENGTHS(pxDomain)                                                          \
+    {                                                                                             \
+        (pxDomain)->xStats.uxCurrentListTimers.store(tmrLIST_LENGTH((pxDomain)->pxCurrentTimerList), \
+                                                     std::memory_order_relaxed);                  \
+        (pxDomain)->xStats.uxOverflowListTimers.store(tmrLIST_LENGTH((pxDomain)->pxOverflowTimerList), \
+                                                      std::memory_order_relaxed);                 \
+    }
+#define tmrINSERT_TIMER_AND_COUNT(pxDomain, pxList, pxTimer)                                     \
+    {                                                                                             \
+        const UBaseType_t uxInsertSteps = tmrINSERT_TIMER((pxList), (pxTimer));                  \
+        tmrSTATS_ADD((pxDomain)->xStats.ullInserts, 1U);                                         \
+        tmrSTATS_ADD((pxDomain)->xStats.ullInsertSteps, uxInsertSteps);                          \
+    }
+
+#else
+
+#define tmrSTATS_WAKE_UP(pxDomain)
+#define tmrSTATS_EXPIRED(pxDomain)
+#define tmrSTATS_MESSAGE(pxDomain, xMessageID)
+#define tmrSTATS_LIST_SWITCH(pxDomain)
+#define tmrSTATS_LIST_LENGTHS(pxDomain)
+#define tmrINSERT_TIMER_AND_COUNT(pxDomain, pxList, pxTimer) (void)tmrINSERT_TIMER((pxList), (pxTimer))
+
+#endif /* configUSE_TIMER_STATS */
+
+/* A set of timers that share a tick source and a timer service task.  Each
+domain has its own active lists, command queue and task, so timers in a fine
+grained domain never wait behind the timers of a coarse one, and a coarse
+domain is not woken at the tick rate of a fine one.  Domain 0 runs on the
+kernel tick and holds every timer that is not created with
+xTimerCreateInDomain(). */
+typedef struct tmrTimerDomain {
+    /* The lists in which active timers are stored.  Timers are referenced in
+    expire time order, with the nearest expiry time at the front of the list.
+    Only the timer service task of the domain is allowed to access these
+    lists. */
+    TimerList_t  xActiveTimerList1;
+    TimerList_t  xActiveTimerList2;
+    TimerList_t *pxCurrentTimerList;
+    TimerList_t *pxOverflowTimerList;
+    TickType_t   xLastTime; /*<< The tick count when prvSampleTimeNow() last ran. */
+
+    TickSource_t *pxTickSource; /*<< The kernel tick for domain 0, otherwise xTickSource. */
+    TickSource_t  xTickSource;
+    uint32_t      ulTickRateHz; /*<< 0 if the ticks come from xTimerDomainIncrementTick(). */
+    const char   *pcDomainName;
+
+#if (configUSE_HIGH_RES_TIMERS == 1)
+    /* The active high resolution timers, nearest expiry time first, and the
+    expiry time of the first of them for when the timer service task
+    blocks. */
+    HighResTimer_t *pxHighResTimerList;
+    uint64_t        ullNextHighResExpiryTime;
+#endif
+
+#if (configUSE_TIMER_BATCH_CALLBACKS == 1)
+    PendingBatch_t xPendingBatches[configTIMER_BATCH_CALLBACKS];
+#endif
+
+    /* A queue that is used to send commands to the timer service task. */
+    QueueHandle_t   xTimerQueue;
+    UBaseType_t     uxQueueLength;
+    TaskHandle_t    xTimerTaskHandle;
+    std::thread::id xTimerTaskId;
+    TaskHandle_t    xTickTaskHandle; /*<< The thread generating xTickSource, if any. */
+
+#if (configUSE_TIMER_STATS == 1)
+    TimerDomainStats_t xStats;
+#endif
 
-/* A queue that is used to send commands to the timer service task. */
-static QueueHandle_t xTimerQueue = NULL;
-static TaskHandle_t xTimerTaskHandle = NULL;
+#if (configUSE_TIMER_CALLBACK_ACCOUNTING == 1)
+    uint64_t ullLastOverrunReport; /*<< When the last callback overrun was reported, or 0. */
+    uint32_t ulUnreportedOverruns; /*<< Overruns since then that were only counted. */
+#endif
+} TimerDomain_t;
+
+/*PRIVILEGED_DATA */static TimerDomain_t xTimerDomains[configTIMER_MAX_DOMAINS];
+static UBaseType_t uxTimerDomainsCreated = 1U; /*<< Domain 0 always exists. */
+static std::mutex xTimerDomainMutex;
 
-static DaemonTaskMessage_t xMessage;
+#define tmrDEFAULT_DOMAIN (&(xTimerDomains[0]))
 
 /*
  * Initialise the infrastructure used by the timer service task if it has not
  * been initialised already.
  */
-static void prvCheckForValidListAndQueue(void) /*PRIVILEGED_FUNCTION*/;
+static void prvCheckForValidListAndQueue(TimerDomain_t *const pxDomain) /*PRIVILEGED_FUNCTION*/;
 
 /*
  * An active timer has reached its expire time.  Reload the timer if it is an
  * auto reload timer, then call its callback.
  */
-static void prvProcessExpiredTimer(const TickType_t xNextExpireTime, const TickType_t xTimeNow)/* PRIVILEGED_FUNCTION*/;
+static void prvProcessExpiredTimer(TimerDomain_t *const pxDomain, Timer_t *const pxTimer, const TickType_t xNextExpireTime, const TickType_t xTimeNow)/* PRIVILEGED_FUNCTION*/;
+
+#if (configUSE_TIMER_PRIORITIES == 1)
+/*
+ * Expire every timer in the current list that is due at xTimeNow, highest
+ * priority class first, stopping early if configTIMER_SWEEP_BUDGET_US is
+ * used up.
+ */
+static void prvProcessExpiredTimersByPriority(TimerDomain_t *const pxDomain, const TickType_t xTimeNow);
+#endif
 
 /*
- * The tick count has overflowed.  Switch the timer lists after ensuring the
- * current timer list does not still reference some timers.
+ * The tick count has overflowed, and is now xTimeNow.  Switch the timer lists
+ * after ensuring the current timer list does not still reference some timers.
  */
-static void prvSwitchTimerLists(void) /*PRIVILEGED_FUNCTION*/;
+static void prvSwitchTimerLists(TimerDomain_t *const pxDomain, const TickType_t xTimeNow) /*PRIVILEGED_FUNCTION*/;
 
 /*
  * Obtain the current tick count, setting *pxTimerListsWereSwitched to pdTRUE
  * if a tick count overflow occurred since prvSampleTimeNow() was last called.
  */
-static TickType_t prvSampleTimeNow(BaseType_t *const pxTimerListsWereSwitched);
+static TickType_t prvSampleTimeNow(TimerDomain_t *const pxDomain, BaseType_t *const pxTimerListsWereSwitched);
 
 /*
  * If the timer list contains any active timers then return the expire time of
@@ -119,37 +615,182 @@ static TickType_t prvSampleTimeNow(BaseType_t *const pxTimerListsWereSwitched);
  * timer list does not contain any timers then return 0 and set *pxListWasEmpty
  * to pdTRUE.
  */
-static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty );
+static TickType_t prvGetNextExpireTime( TimerDomain_t * const pxDomain, BaseType_t * const pxListWasEmpty );
 
 /*
  * If a timer has expired, process it.  Otherwise, block the timer service task
  * until either a timer does expire or a command is received.
  */
-static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseType_t xListWasEmpty );
+static void prvProcessTimerOrBlockTask( TimerDomain_t * const pxDomain, const TickType_t xNextExpireTime, BaseType_t xListWasEmpty );
 
 /*
  * Called by the timer service task to interpret and process a command it
  * received on the timer queue.
  */
-static void prvProcessReceivedCommands( void );
+static void prvProcessReceivedCommands( TimerDomain_t * const pxDomain );
+
+#if (configUSE_TIMER_POOL == 0)
+/*
+ * Block until the timer service task of pxDomain has processed every command
+ * sent to it before the call, by sending a tmrCOMMAND_FENCE message.  Returns
+ * pdFAIL if the task is not running.  Must not be called by the task itself.
+ */
+static BaseType_t prvWaitForTimerTask(TimerDomain_t *const pxDomain);
+#endif
+
+/*
+ * Release the task waiting in prvWaitForTimerTask() on pxFence.
+ */
+static void prvPassFence(TimerFence_t *const pxFence);
+
+/*
+ * Insert the timer into either xActiveTimerList1, or xActiveTimerList2, of its
+ * domain depending on if the expire time causes a timer counter overflow.
+ */
+static BaseType_t prvInsertTimerInActiveList(TimerDomain_t* const pxDomain, Timer_t* const pxTimer, const TickType_t xNextExpiryTime, const TickType_t xTimeNow, const TickType_t xCommandTime) /*PRIVILEGED_FUNCTION*/;
+
+/*
+ * An auto-reload timer that expired at xExpiredTime is being reloaded at
+ * xTimeNow.  Returns the time its next period should be measured from, which
+ * is xExpiredTime unless the catch-up policy of the timer skips the periods
+ * that have already passed.
+ */
+static TickType_t prvCatchUpMissedPeriods(Timer_t *const pxTimer, const TickType_t xExpiredTime,
+                                          const TickType_t xTimeNow);
+
+/*
+ * Call the callback of an expired timer, or queue the timer for the batch form
+ * of the callback if one is registered.
+ */
+static void prvCallTimerCallback(TimerDomain_t *const pxDomain, Timer_t *const pxTimer);
+
+/*
+ * Call the callback of pxTimer, measuring it when
+ * configUSE_TIMER_CALLBACK_ACCOUNTING is 1.
+ */
+static void prvInvokeTimerCallback(TimerDomain_t *const pxDomain, Timer_t *const pxTimer);
+
+#if (configUSE_TIMER_CALLBACK_ACCOUNTING == 1)
+/*
+ * Add one call of the callback of pxTimer to its counters, and report it if it
+ * overran its budget.
+ */
+static void prvAccountTimerCallback(TimerDomain_t *const pxDomain, Timer_t *const pxTimer,
+                                    const uint64_t ullWallTime, const uint64_t ullCpuTime);
+#endif
+
+#if (configUSE_TIMER_BATCH_CALLBACKS == 1)
+/*
+ * Hand every timer queued by prvCallTimerCallback() to its batch callback.
+ */
+static void prvFlushBatchCallbacks(TimerDomain_t *const pxDomain);
+#endif
+
+#if (configUSE_HIGH_RES_TIMERS == 1)
+/*
+ * Call the callbacks of the high resolution timers that have expired,
+ * reloading the auto-reload ones, and return when the next one expires.
+ */
+static uint64_t prvProcessExpiredHighResTimers(TimerDomain_t *const pxDomain);
+
+/*
+ * Carry out a tmrCOMMAND_HIGH_RES_* command.
+ */
+static void prvProcessHighResCommand(TimerDomain_t *const pxDomain,
+                                     const DaemonTaskMessage_t *const pxMessage);
+
+static void prvInsertHighResTimer(TimerDomain_t *const pxDomain, HighResTimer_t *const pxTimer);
+static void prvRemoveHighResTimer(TimerDomain_t *const pxDomain, HighResTimer_t *const pxTimer);
+#endif
+
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+/*
+ * Add ullValue to a histogram of priority class uxClass.
+ */
+static void prvRecordInHistogram(const UBaseType_t uxHistogram, const UBaseType_t uxClass,
+                                 const uint64_t ullValue);
+
+/*
+ * Record how late the callback of a timer that fell due at tick xExpiredTime
+ * is being called, with the tick count now xTimeNow.
+ */
+static void prvRecordExpiryLateness(const TimerDomain_t *const pxDomain, const Timer_t *const pxTimer,
+                                    const TickType_t xExpiredTime, const TickType_t xTimeNow);
+#endif
+
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+/*
+ * Wake the timer service task of the default domain to run the pended
+ * function calls, unless a wake up is already on its way.
+ */
+static void prvSignalPendedFunctionCalls(void);
 
 /*
- * Insert the timer into either xActiveTimerList1, or xActiveTimerList2,
- * depending on if the expire time causes a timer counter overflow.
+ * Run up to configTIMER_PEND_BATCH_LENGTH pended function calls.
  */
-static BaseType_t prvInsertTimerInActiveList(Timer_t* const pxTimer, const TickType_t xNextExpiryTime, const TickType_t xTimeNow, const TickType_t xCommandTime) /*PRIVILEGED_FUNCTION*/;
+static void prvExecutePendedFunctionCalls(void);
+#endif
 
 static pthread_t thread_timers_manage;
 static void TimersManageTask(void* args);
+
+/*
+ * Generates the ticks of a domain created with a non-zero ulTickRateHz.
+ */
+static void prvTimerDomainTickTask(void *args);
 //volatile bool running;
 
-static void prvInitialiseNewTimer(const char *const pcTimerName,
+static void prvInitialiseNewTimer(TimerDomain_t *const pxDomain, const char *const pcTimerName,
                                   const TickType_t  xTimerPeriodInTicks,
                                   const UBaseType_t uxAutoReload, void *const pvTimerID,
-                                  TimerCallbackFunction_t pxCallbackFunction, Timer_t *pxNewTimer)
+                                  TimerCallbackFunction_t pxCallbackFunction, Timer_t *pxNewTimer,
+                                  TimerMetadata_t *pxNewMetadata)
     /*PRIVILEGED_FUNCTION*/; /*lint !e971 Unqualified char types are allowed for strings and single
                             characters only. */
 
+/*
+ * The part of prvInitialiseNewTimer() that is repeated for every timer, for
+ * callers that have already called prvCheckForValidListAndQueue().
+ */
+static void prvInitialiseTimerMembers(TimerDomain_t *const pxDomain, const char *const pcTimerName,
+                                      const TickType_t  xTimerPeriodInTicks,
+                                      const UBaseType_t uxAutoReload, void *const pvTimerID,
+                                      TimerCallbackFunction_t pxCallbackFunction,
+                                      Timer_t *pxNewTimer, TimerMetadata_t *pxNewMetadata)
+    /*PRIVILEGED_FUNCTION*/;
+
+#if ((configUSE_TIMER_POOL == 0) && (configSUPPORT_DYNAMIC_ALLOCATION == 1))
+/*
+ * Allocate the hot and cold parts of a timer, with xContextSize bytes of
+ * context storage after the hot part.
+ */
+static Timer_t *prvAllocateTimer(const size_t xContextSize, TimerMetadata_t **ppxNewMetadata);
+
+/*
+ * Free a timer allocated by prvAllocateTimer(), destroying its context first.
+ */
+static void prvFreeTimer(Timer_t *const pxTimer);
+#endif
+
+#if (configUSE_TIMER_POOL == 1)
+/*
+ * Take a timer from the pool, returning NULL if every slot is in use.
+ */
+static Timer_t *prvAllocateTimerFromPool(void);
+
+/*
+ * Return the slot of a deleted timer to the pool.
+ */
+static void prvReturnTimerToPool(Timer_t *const pxTimer);
+
+/*
+ * As prvAllocateTimerFromPool() and prvReturnTimerToPool(), for callers that
+ * already hold xTimerPoolMutex.
+ */
+static Timer_t *prvTakeTimerFromPool(void);
+static void prvPutTimerInPool(Timer_t *const pxTimer);
+#endif /* configUSE_TIMER_POOL */
+
 
 BaseType_t CreateTimerManageTask(void) {
 
@@ -157,16 +798,241 @@ BaseType_t CreateTimerManageTask(void) {
     //	return true;
     //}
  //or
-    prvCheckForValidListAndQueue();
-
-    if (xTimerQueue != NULL) {
-       std::thread  *timer_thread = new std::thread(TimersManageTask, nullptr);
-        //xNextTaskUnblockTime = portMAX_DELAY;
+#if (configTIMER_LOCK_MEMORY == 1)
+    /* Before the threads start, so their stacks are locked as they grow. */
+    if (xPortLockMemory() == pdFAIL) {
+        vPortRecordConfigureFailure(portCONFIGURE_LOCK_MEMORY);
     }
+#endif
+
+    prvCheckForValidListAndQueue(tmrDEFAULT_DOMAIN);
+    (void)xTimerDomainStart(tmrDEFAULT_DOMAIN);
     
     return true;
 }
 
+TimerDomainHandle_t xTimerDomainCreate(const TimerDomainParameters_t *const pxParameters) {
+    std::lock_guard<std::mutex> xLock(xTimerDomainMutex);
+    TimerDomain_t *pxDomain = NULL;
+
+    configASSERT(pxParameters);
+
+    if (uxTimerDomainsCreated < (UBaseType_t)configTIMER_MAX_DOMAINS) {
+        pxDomain = &(xTimerDomains[uxTimerDomainsCreated]);
+
+        pxDomain->pcDomainName  = pxParameters->pcDomainName;
+        pxDomain->ulTickRateHz  = pxParameters->ulTickRateHz;
+        pxDomain->uxQueueLength = (pxParameters->uxQueueLength != (UBaseType_t)0U)
+                                      ? pxParameters->uxQueueLength
+                                      : (UBaseType_t)configTIMER_QUEUE_LENGTH;
+        pxDomain->xTickSource.xTickCount       = (TickType_t)0U;
+        pxDomain->xTickSource.xNextUnblockTime = portMAX_DELAY;
+        pxDomain->xTickSource.pvWakeQueue.store(NULL);
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+        pxDomain->xTickSource.ullLastTickTime.store(0U, std::memory_order_relaxed);
+#endif
+        pxDomain->pxTickSource                 = &(pxDomain->xTickSource);
+
+        prvCheckForValidListAndQueue(pxDomain);
+
+        if (pxDomain->xTimerQueue != NULL) {
+            uxTimerDomainsCreated++;
+        } else {
+            pxDomain = NULL;
+        }
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return pxDomain;
+}
+
+BaseType_t xTimerDomainStart(TimerDomainHandle_t xDomain) {
+    TimerDomain_t *const pxDomain = (TimerDomain_t *)xDomain;
+
+    configASSERT(xDomain);
+
+    if ((pxDomain->xTimerQueue == NULL) || (pxDomain->xTimerTaskHandle != NULL)) {
+        return pdFAIL;
+    }
+
+    std::thread  *timer_thread = new std::thread(TimersManageTask, pxDomain);
+    pxDomain->xTimerTaskHandle = (TaskHandle_t)timer_thread;
+
+    /* With virtual time the ticks come from xTimerDomainAdvanceTime(). */
+    if ((pxDomain->pxTickSource == &(pxDomain->xTickSource)) && (pxDomain->ulTickRateHz != 0U) &&
+        (configUSE_VIRTUAL_TIME == 0)) {
+        std::thread *tick_thread  = new std::thread(prvTimerDomainTickTask, pxDomain);
+        pxDomain->xTickTaskHandle = (TaskHandle_t)tick_thread;
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return pdPASS;
+}
+
+TimerDomainHandle_t xTimerGetDefaultDomain(void) {
+    prvCheckForValidListAndQueue(tmrDEFAULT_DOMAIN);
+    return tmrDEFAULT_DOMAIN;
+}
+
+TickType_t xTimerDomainGetTickCount(TimerDomainHandle_t xDomain) {
+    configASSERT(xDomain);
+    return xTickSourceGetCount(((TimerDomain_t *)xDomain)->pxTickSource);
+}
+
+BaseType_t xTimerDomainIncrementTick(TimerDomainHandle_t xDomain) {
+    TimerDomain_t *const pxDomain = (TimerDomain_t *)xDomain;
+
+    /* Only for domains that do not have a tick of their own. */
+    configASSERT(xDomain);
+    configASSERT(pxDomain->pxTickSource == &(pxDomain->xTickSource));
+    configASSERT(pxDomain->ulTickRateHz == 0U);
+
+    return xTickSourceIncrement(&(pxDomain->xTickSource));
+}
+
+#if (configUSE_VIRTUAL_TIME == 1)
+
+void vTimerDomainWaitUntilIdle(TimerDomainHandle_t xDomain) {
+    TimerDomain_t *const pxDomain = (xDomain != NULL) ? (TimerDomain_t *)xDomain : tmrDEFAULT_DOMAIN;
+    TickType_t xWakeTick;
+
+    configASSERT(pxDomain->xTimerTaskHandle != NULL);
+    (void)xQueueWaitUntilTickSourceIdle(pxDomain->pxTickSource, &xWakeTick);
+}
+
+/*
+ * Move the tick count of pxTickSource to xTickCount, which must not be past
+ * the tick a blocked timer service task waits for.  The last tick is a real
+ * increment so it wakes the task if it is due.
+ */
+static void prvJumpTickSource(TickSource_t *const pxTickSource, const TickType_t xTickCount) {
+    pxTickSource->xTickCount = xTickCount - (TickType_t)1U;
+    (void)xTickSourceIncrement(pxTickSource);
+}
+
+TickType_t xTimerDomainAdvanceTime(TimerDomainHandle_t xDomain, const TickType_t xTicks) {
+    TimerDomain_t *const pxDomain = (xDomain != NULL) ? (TimerDomain_t *)xDomain : tmrDEFAULT_DOMAIN;
+    TickSource_t *const pxTickSource = pxDomain->pxTickSource;
+    const TickType_t xTarget = xTickSourceGetCount(pxTickSource) + xTicks;
+    TickType_t xTimeNow, xWakeTick;
+
+    configASSERT(pxDomain->xTimerTaskHandle != NULL);
+
+    for (;;) {
+        const BaseType_t xWaitingForTick = xQueueWaitUntilTickSourceIdle(pxTickSource, &xWakeTick);
+
+        xTimeNow = xTickSourceGetCount(pxTickSource);
+        if (xTimeNow == xTarget) {
+            break;
+        }
+
+        /* Distances from now, so the tick count wrapping is handled. */
+        if ((xWaitingForTick != pdFALSE) &&
+            ((TickType_t)(xWakeTick - xTimeNow) <= (TickType_t)(xTarget - xTimeNow))) {
+            prvJumpTickSource(pxTickSource, xWakeTick);
+        } else {
+            prvJumpTickSource(pxTickSource, xTarget);
+        }
+    }
+
+    return xTarget;
+}
+
+BaseType_t xTimerDomainAdvanceToNextWake(TimerDomainHandle_t xDomain) {
+    TimerDomain_t *const pxDomain = (xDomain != NULL) ? (TimerDomain_t *)xDomain : tmrDEFAULT_DOMAIN;
+    TickType_t xWakeTick;
+
+    configASSERT(pxDomain->xTimerTaskHandle != NULL);
+
+    if (xQueueWaitUntilTickSourceIdle(pxDomain->pxTickSource, &xWakeTick) == pdFALSE) {
+        return pdFAIL;
+    }
+
+    prvJumpTickSource(pxDomain->pxTickSource, xWakeTick);
+    (void)xQueueWaitUntilTickSourceIdle(pxDomain->pxTickSource, &xWakeTick);
+
+    return pdPASS;
+}
+
+BaseType_t xTimerDomainGetNextWake(TimerDomainHandle_t xDomain, TickType_t *const pxWakeTick) {
+    TimerDomain_t *const pxDomain = (xDomain != NULL) ? (TimerDomain_t *)xDomain : tmrDEFAULT_DOMAIN;
+
+    configASSERT(pxDomain->xTimerTaskHandle != NULL);
+    configASSERT(pxWakeTick);
+
+    return xQueueWaitUntilTickSourceIdle(pxDomain->pxTickSource, pxWakeTick);
+}
+
+#endif /* configUSE_VIRTUAL_TIME */
+
+TimerDomainHandle_t xTimerGetDomain(const TimerHandle_t xTimer) {
+    configASSERT(xTimer);
+    return tmrGET_METADATA((Timer_t *)xTimer)->pxDomain;
+}
+
+TickType_t xTimerGetDomainTickCount(const TimerHandle_t xTimer) {
+    configASSERT(xTimer);
+    return xTickSourceGetCount(tmrGET_METADATA((Timer_t *)xTimer)->pxDomain->pxTickSource);
+}
+
+#if (configUSE_TIMER_STATS == 1)
+
+void vTimerGetStats(TimerDomainHandle_t xDomain, TimerStats_t *const pxStats) {
+    TimerDomain_t *const pxDomain = (xDomain != NULL) ? (TimerDomain_t *)xDomain : tmrDEFAULT_DOMAIN;
+    const TimerDomainStats_t *const pxCounters = &(pxDomain->xStats);
+    UBaseType_t uxCommand;
+
+    configASSERT(pxStats);
+
+    pxStats->uxCurrentListTimers  = pxCounters->uxCurrentListTimers.load(std::memory_order_relaxed);
+    pxStats->uxOverflowListTimers = pxCounters->uxOverflowListTimers.load(std::memory_order_relaxed);
+
+    if (pxDomain->xTimerQueue != NULL) {
+        pxStats->uxQueueDepth         = uxQueueMessagesWaiting(pxDomain->xTimerQueue);
+        pxStats->uxQueueHighWaterMark = uxQueueGetHighWaterMark(pxDomain->xTimerQueue);
+    } else {
+        pxStats->uxQueueDepth         = (UBaseType_t)0U;
+        pxStats->uxQueueHighWaterMark = (UBaseType_t)0U;
+    }
+
+    for (uxCommand = 0U; uxCommand < tmrSTATS_COMMAND_TYPES; uxCommand++) {
+        pxStats->ulCommandsProcessed[uxCommand] =
+            pxCounters->ulCommandsProcessed[uxCommand].load(std::memory_order_relaxed);
+    }
+
+    pxStats->ulOtherMessagesProcessed = pxCounters->ulOtherMessagesProcessed.load(std::memory_order_relaxed);
+    pxStats->ulExpirations            = pxCounters->ulExpirations.load(std::memory_order_relaxed);
+    pxStats->ulListSwitches           = pxCounters->ulListSwitches.load(std::memory_order_relaxed);
+    pxStats->ulWakeUps                = pxCounters->ulWakeUps.load(std::memory_order_relaxed);
+    pxStats->ulUsefulWakeUps          = pxCounters->ulUsefulWakeUps.load(std::memory_order_relaxed);
+    pxStats->ullInserts               = pxCounters->ullInserts.load(std::memory_order_relaxed);
+    pxStats->ullInsertSteps           = pxCounters->ullInsertSteps.load(std::memory_order_relaxed);
+}
+
+#endif /* configUSE_TIMER_STATS */
+
+static void prvTimerDomainTickTask(void *args) {
+    TimerDomain_t *const pxDomain = (TimerDomain_t *)args;
+    const std::chrono::nanoseconds xTickPeriod(1000000000ULL / pxDomain->ulTickRateHz);
+    std::chrono::steady_clock::time_point xNextTick;
+
+    if (xPortConfigureThread((uint64_t)configTICK_THREAD_AFFINITY, (int32_t)configTICK_THREAD_REALTIME_PRIORITY,
+                             (size_t)configTIMER_THREAD_STACK_PREFAULT) == pdFAIL) {
+        vPortRecordConfigureFailure(portCONFIGURE_TICK_THREAD);
+    }
+    xNextTick = std::chrono::steady_clock::now();
+
+    for (;;) {
+        /* Each tick is timed from the previous one rather than from when the
+        thread woke, so the domain tick does not drift. */
+        xNextTick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(xTickPeriod);
+        std::this_thread::sleep_until(xNextTick);
+        (void)xTickSourceIncrement(&(pxDomain->xTickSource));
+    }
+}
+
 #if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 
 TimerHandle_t xTimerCreate(const char* const pcTimerName,
@@ -174,22 +1040,41 @@ TimerHandle_t xTimerCreate(const char* const pcTimerName,
     const UBaseType_t uxAutoReload,
     void* const pvTimerID,
     TimerCallbackFunction_t pxCallbackFunction) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+{
+    return xTimerCreateInDomain(tmrDEFAULT_DOMAIN, pcTimerName, xTimerPeriodInTicks, uxAutoReload,
+                                pvTimerID, pxCallbackFunction);
+}
+
+TimerHandle_t xTimerCreateInDomain(TimerDomainHandle_t xDomain,
+    const char* const pcTimerName,
+    const TickType_t xTimerPeriodInTicks,
+    const UBaseType_t uxAutoReload,
+    void* const pvTimerID,
+    TimerCallbackFunction_t pxCallbackFunction) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 {
     Timer_t* pxNewTimer;
+    TimerMetadata_t* pxNewMetadata;
+
+    configASSERT(xDomain);
 
+#if (configUSE_TIMER_POOL == 1)
+    pxNewTimer = prvAllocateTimerFromPool();
+    pxNewMetadata = (pxNewTimer != NULL) ? tmrGET_METADATA(pxNewTimer) : NULL;
+#else
     //pxNewTimer = (Timer_t*)pvPortMalloc(sizeof(Timer_t));
-    pxNewTimer = new Timer_t[sizeof(Timer_t)];
+    pxNewTimer = prvAllocateTimer(0U, &pxNewMetadata);
+#endif /* configUSE_TIMER_POOL */
 
     if (pxNewTimer != NULL)
     {
-        prvInitialiseNewTimer(pcTimerName, xTimerPeriodInTicks, uxAutoReload, pvTimerID, pxCallbackFunction, pxNewTimer);
+        prvInitialiseNewTimer((TimerDomain_t*)xDomain, pcTimerName, xTimerPeriodInTicks, uxAutoReload, pvTimerID, pxCallbackFunction, pxNewTimer, pxNewMetadata);
 
 #if( configSUPPORT_STATIC_ALLOCATION == 1 )
         {
             /* Timers can be created statically or dynamically, so note this
             timer was created dynamically in case the timer is later
             deleted. */
-            pxNewTimer->ucStaticallyAllocated = pdFALSE;
+            pxNewMetadata->ucStaticallyAllocated = pdFALSE;
         }
 #endif /* configSUPPORT_STATIC_ALLOCATION */
     }
@@ -197,17 +1082,152 @@ TimerHandle_t xTimerCreate(const char* const pcTimerName,
     return pxNewTimer;
 }
 
-#endif /* configSUPPORT_STATIC_ALLOCATION */
-
-#if( configSUPPORT_STATIC_ALLOCATION == 1 )
-TimerHandle_t
-xTimerCreateStatic(const char *const pcTimerName, const TickType_t xTimerPeriodInTicks,
-                   const UBaseType_t uxAutoReload, void *const pvTimerID,
-                   TimerCallbackFunction_t pxCallbackFunction,
-                   StaticTimer_t *pxTimerBuffer) /*lint !e971 Unqualified char types are allowed for
-                                                    strings and single characters only. */
-{
+BaseType_t xTimerCreateArray(const UBaseType_t uxNumberOfTimers,
+                             const char *const *const ppcTimerNames,
+                             const TickType_t *const pxTimerPeriodsInTicks,
+                             const UBaseType_t *const puxAutoReloads,
+                             void *const *const ppvTimerIDs,
+                             const TimerCallbackFunction_t *const pxCallbackFunctions,
+                             TimerHandle_t *const pxCreatedTimers) {
     Timer_t *pxNewTimer;
+    TimerMetadata_t *pxNewMetadata;
+    UBaseType_t ux;
+#if (configUSE_TIMER_POOL == 0)
+    TimerArray_t *pxArray;
+    Timer_t *pxFirstTimer;
+    TimerMetadata_t *pxFirstMetadata;
+#endif
+
+    configASSERT(pxTimerPeriodsInTicks);
+    configASSERT(pxCallbackFunctions);
+    configASSERT(pxCreatedTimers);
+
+    if (uxNumberOfTimers == (UBaseType_t)0U) {
+        return pdPASS;
+    }
+
+#if (configUSE_TIMER_POOL == 1)
+    {
+        /* The pool is already contiguous, so take all the slots under one
+        lock, giving them all back if there are not enough. */
+        std::lock_guard<std::mutex> xLock(xTimerPoolMutex);
+
+        for (ux = 0; ux < uxNumberOfTimers; ux++) {
+            pxCreatedTimers[ux] = prvTakeTimerFromPool();
+
+            if (pxCreatedTimers[ux] == NULL) {
+                while (ux > (UBaseType_t)0U) {
+                    ux--;
+                    prvPutTimerInPool((Timer_t *)pxCreatedTimers[ux]);
+                }
+                return pdFAIL;
+            }
+        }
+    }
+#else
+    /* One allocation holds the header, then every hot part, then every cold
+    part, so the hot parts sit next to each other as they do in the pool. */
+    pxArray = (TimerArray_t *)::operator new(tmrARRAY_METADATA_OFFSET(uxNumberOfTimers) +
+                                                 (uxNumberOfTimers * sizeof(TimerMetadata_t)),
+                                             std::nothrow);
+    if (pxArray == NULL) {
+        return pdFAIL;
+    }
+
+    /* The block is raw memory, so every part is constructed in place before
+    use, the metadata holding atomics when configUSE_TIMER_CALLBACK_ACCOUNTING
+    is 1. */
+    pxArray = new (pxArray) TimerArray_t;
+    pxArray->uxTimersNotDeleted = uxNumberOfTimers;
+    pxFirstTimer    = (Timer_t *)((uint8_t *)pxArray + tmrARRAY_HEADER_SIZE);
+    pxFirstMetadata = (TimerMetadata_t *)((uint8_t *)pxArray + tmrARRAY_METADATA_OFFSET(uxNumberOfTimers));
+    for (ux = 0; ux < uxNumberOfTimers; ux++) {
+        (void)new (&(pxFirstMetadata[ux])) TimerMetadata_t;
+        pxCreatedTimers[ux] = (TimerHandle_t) new (&(pxFirstTimer[ux])) Timer_t;
+    }
+#endif /* configUSE_TIMER_POOL */
+
+    /* Done once for the whole array rather than once per timer. */
+    prvCheckForValidListAndQueue(tmrDEFAULT_DOMAIN);
+
+    for (ux = 0; ux < uxNumberOfTimers; ux++) {
+        configASSERT((pxTimerPeriodsInTicks[ux] > 0));
+
+        pxNewTimer = (Timer_t *)pxCreatedTimers[ux];
+#if (configUSE_TIMER_POOL == 1)
+        pxNewMetadata = tmrGET_METADATA(pxNewTimer);
+#else
+        pxNewMetadata = &(pxFirstMetadata[ux]);
+#endif
+        prvInitialiseTimerMembers(tmrDEFAULT_DOMAIN,
+                                  (ppcTimerNames != NULL) ? ppcTimerNames[ux] : NULL,
+                                  pxTimerPeriodsInTicks[ux],
+                                  (puxAutoReloads != NULL) ? puxAutoReloads[ux] : pdFALSE,
+                                  (ppvTimerIDs != NULL) ? ppvTimerIDs[ux] : NULL,
+                                  pxCallbackFunctions[ux], pxNewTimer, pxNewMetadata);
+#if (configUSE_TIMER_POOL == 0)
+        pxNewMetadata->pxArray = pxArray;
+#endif
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+        pxNewMetadata->ucStaticallyAllocated = pdFALSE;
+#endif
+    }
+
+    return pdPASS;
+}
+
+#if (configUSE_TIMER_POOL == 0)
+
+TimerHandle_t xTimerCreateWithContext(const char *const pcTimerName,
+                                      const TickType_t xTimerPeriodInTicks,
+                                      const UBaseType_t uxAutoReload,
+                                      TimerCallbackFunction_t pxCallbackFunction,
+                                      const size_t xContextSize, void **const ppvContext,
+                                      TimerContextDestructor_t pxContextDestructor) {
+    Timer_t *pxNewTimer;
+    TimerMetadata_t *pxNewMetadata;
+
+    configASSERT(ppvContext);
+
+    pxNewTimer = prvAllocateTimer(xContextSize, &pxNewMetadata);
+
+    if (pxNewTimer != NULL) {
+        prvInitialiseNewTimer(tmrDEFAULT_DOMAIN, pcTimerName, xTimerPeriodInTicks, uxAutoReload,
+                              NULL, pxCallbackFunction, pxNewTimer, pxNewMetadata);
+        pxNewMetadata->pxContextDestructor = pxContextDestructor;
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+        pxNewMetadata->ucStaticallyAllocated = pdFALSE;
+#endif
+        *ppvContext = pvTimerGetContext(pxNewTimer);
+    } else {
+        *ppvContext = NULL;
+    }
+
+    return pxNewTimer;
+}
+
+void *pvTimerGetContext(const TimerHandle_t xTimer) {
+    configASSERT(xTimer);
+
+    /* Only valid for timers created by xTimerCreateWithContext(). */
+    return (void *)((uint8_t *)xTimer + tmrCONTEXT_OFFSET);
+}
+
+#endif /* configUSE_TIMER_POOL */
+
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+TimerHandle_t
+xTimerCreateStatic(const char *const pcTimerName, const TickType_t xTimerPeriodInTicks,
+                   const UBaseType_t uxAutoReload, void *const pvTimerID,
+                   TimerCallbackFunction_t pxCallbackFunction,
+                   StaticTimer_t *pxTimerBuffer) /*lint !e971 Unqualified char types are allowed for
+                                                    strings and single characters only. */
+{
+    StaticTimerStorage_t *pxStorage;
+    Timer_t *pxNewTimer = NULL;
 
 #if (configASSERT_DEFINED == 1)
     {
@@ -215,39 +1235,112 @@ xTimerCreateStatic(const char *const pcTimerName, const TickType_t xTimerPeriodI
         variable of type StaticTimer_t equals the size of the real timer
         structures. */
         volatile size_t xSize = sizeof(StaticTimer_t);
-        configASSERT(xSize == sizeof(Timer_t));
+        configASSERT(xSize == sizeof(StaticTimerStorage_t));
     }
 #endif /* configASSERT_DEFINED */
 
     /* A pointer to a StaticTimer_t structure MUST be provided, use it. */
     configASSERT(pxTimerBuffer);
-    pxNewTimer = (Timer_t *)
+    pxStorage = (StaticTimerStorage_t *)
         pxTimerBuffer; /*lint !e740 Unusual cast is ok as the structures are designed to have the
                           same alignment, and the size is checked by an assert. */
 
-    if (pxNewTimer != NULL) {
-        prvInitialiseNewTimer(pcTimerName, xTimerPeriodInTicks, uxAutoReload, pvTimerID,
-                              pxCallbackFunction, pxNewTimer);
+    if (pxStorage != NULL) {
+        /* The metadata holds atomics when configUSE_TIMER_CALLBACK_ACCOUNTING
+        is 1, so the buffer is constructed as a timer before use. */
+        pxStorage  = new (pxStorage) StaticTimerStorage_t;
+        pxNewTimer = &(pxStorage->xTimer);
+        prvInitialiseNewTimer(tmrDEFAULT_DOMAIN, pcTimerName, xTimerPeriodInTicks, uxAutoReload,
+                              pvTimerID, pxCallbackFunction, pxNewTimer, &(pxStorage->xMetadata));
 
 #if (configSUPPORT_DYNAMIC_ALLOCATION == 1)
         {
             /* Timers can be created statically or dynamically so note this
             timer was created statically in case it is later deleted. */
-            pxNewTimer->ucStaticallyAllocated = pdTRUE;
+            pxStorage->xMetadata.ucStaticallyAllocated = pdTRUE;
         }
 #endif /* configSUPPORT_DYNAMIC_ALLOCATION */
     }
 
     return pxNewTimer;
 }
+
+BaseType_t xTimerCreateStaticTable(const TimerDefinition_t *const pxDefinitions,
+                                   const UBaseType_t              uxNumberOfTimers,
+                                   const UBaseType_t *const       puxStartOrder,
+                                   const UBaseType_t              uxNumberToStart,
+                                   StaticTimer_t *const           pxTimerBuffers,
+                                   TimerHandle_t *const           pxCreatedTimers) {
+    StaticTimerStorage_t *const pxStorage = (StaticTimerStorage_t *)pxTimerBuffers;
+    TimerDomain_t *const        pxDomain  = tmrDEFAULT_DOMAIN;
+    const TimerDefinition_t *   pxDefinition;
+    Timer_t *                   pxTimer;
+    TickType_t                  xTimeNow;
+    TickType_t                  xExpiryTime;
+    UBaseType_t                 ux;
+
+    configASSERT(pxDefinitions);
+    configASSERT(pxTimerBuffers);
+    configASSERT(sizeof(StaticTimer_t) == sizeof(StaticTimerStorage_t));
+
+    /* The active lists are written directly rather than through the timer
+    queue, which is only safe before the timer service task exists. */
+    configASSERT(pxDomain->xTimerTaskHandle == NULL);
+    if (pxDomain->xTimerTaskHandle != NULL) {
+        return pdFAIL;
+    }
+
+    /* Done once for the whole table rather than once per timer. */
+    prvCheckForValidListAndQueue(pxDomain);
+
+    for (ux = 0; ux < uxNumberOfTimers; ux++) {
+        pxDefinition = &(pxDefinitions[ux]);
+        configASSERT((pxDefinition->xTimerPeriodInTicks > 0));
+
+        (void)new (&(pxStorage[ux])) StaticTimerStorage_t;
+
+        prvInitialiseTimerMembers(pxDomain, pxDefinition->pcTimerName, pxDefinition->xTimerPeriodInTicks,
+                                  pxDefinition->uxAutoReload, pxDefinition->pvTimerID,
+                                  pxDefinition->pxCallbackFunction, &(pxStorage[ux].xTimer),
+                                  &(pxStorage[ux].xMetadata));
+#if (configSUPPORT_DYNAMIC_ALLOCATION == 1)
+        pxStorage[ux].xMetadata.ucStaticallyAllocated = pdTRUE;
+#endif
+
+        if (pxCreatedTimers != NULL) {
+            pxCreatedTimers[ux] = (TimerHandle_t) & (pxStorage[ux].xTimer);
+        }
+    }
+
+    /* puxStartOrder lists the timers to start in ascending period order (see
+    xMakeTimerTable() in timer_table.h), so each goes on the end of its list.
+    Linking the whole table costs no walk, timers of equal period expire in
+    the order of the table, and no start commands are queued. */
+    xTimeNow = xTickSourceGetCount(pxDomain->pxTickSource);
+    for (ux = 0; ux < uxNumberToStart; ux++) {
+        configASSERT(puxStartOrder[ux] < uxNumberOfTimers);
+        pxTimer     = &(pxStorage[puxStartOrder[ux]].xTimer);
+        xExpiryTime = xTimeNow + pxTimer->xTimerPeriodInTicks;
+        tmrSET_TIMER_ITEM_VALUE(pxTimer, xExpiryTime);
+        /* As prvInsertTimerInActiveList(), an expiry time that has overflowed
+        goes in the overflow list. */
+        prvAppendTimer((xExpiryTime > xTimeNow) ? pxDomain->pxCurrentTimerList
+                                                : pxDomain->pxOverflowTimerList,
+                       pxTimer);
+    }
+
+    return pdPASS;
+}
 #endif
 
 static void
-prvInitialiseNewTimer(const char *const pcTimerName, const TickType_t xTimerPeriodInTicks,
+prvInitialiseNewTimer(TimerDomain_t *const pxDomain, const char *const pcTimerName, const TickType_t xTimerPeriodInTicks,
                       const UBaseType_t uxAutoReload, void *const pvTimerID,
                       TimerCallbackFunction_t pxCallbackFunction,
-                      Timer_t *pxNewTimer) /*lint !e971 Unqualified char types are allowed for
-                                              strings and single characters only. */
+                      Timer_t *pxNewTimer,
+                      TimerMetadata_t *pxNewMetadata) /*lint !e971 Unqualified char types are
+                                                         allowed for strings and single characters
+                                                         only. */
 {
     /* 0 is not a valid value for xTimerPeriodInTicks. */
     configASSERT((xTimerPeriodInTicks > 0));
@@ -255,42 +1348,73 @@ prvInitialiseNewTimer(const char *const pcTimerName, const TickType_t xTimerPeri
     if (pxNewTimer != NULL) {
         /* Ensure the infrastructure used by the timer service task has been
         created/initialised. */
-        prvCheckForValidListAndQueue();
+        prvCheckForValidListAndQueue(pxDomain);
 
-        /* Initialise the timer structure members using the function
-        parameters. */
-        pxNewTimer->pcTimerName         = pcTimerName;
-        pxNewTimer->xTimerPeriodInTicks = xTimerPeriodInTicks;
-        pxNewTimer->uxAutoReload        = uxAutoReload;
-        pxNewTimer->pvTimerID           = pvTimerID;
-        pxNewTimer->pxCallbackFunction  = pxCallbackFunction;
-        vListInitialiseItem(&(pxNewTimer->xTimerListItem));
-        traceTIMER_CREATE(pxNewTimer);
+        prvInitialiseTimerMembers(pxDomain, pcTimerName, xTimerPeriodInTicks, uxAutoReload,
+                                  pvTimerID, pxCallbackFunction, pxNewTimer, pxNewMetadata);
     }
 }
 
-static void prvProcessExpiredTimer(const TickType_t xNextExpireTime, const TickType_t xTimeNow)
+static void prvInitialiseTimerMembers(TimerDomain_t *const pxDomain, const char *const pcTimerName,
+                                      const TickType_t  xTimerPeriodInTicks,
+                                      const UBaseType_t uxAutoReload, void *const pvTimerID,
+                                      TimerCallbackFunction_t pxCallbackFunction,
+                                      Timer_t *pxNewTimer, TimerMetadata_t *pxNewMetadata) {
+    /* Initialise the timer structure members using the function
+    parameters. */
+    pxNewMetadata->pcTimerName      = pcTimerName;
+    pxNewMetadata->pvTimerID        = pvTimerID;
+    pxNewMetadata->pxDomain         = pxDomain;
+    pxNewTimer->xTimerPeriodInTicks = xTimerPeriodInTicks;
+    pxNewTimer->ucAutoReload        = (uint8_t)uxAutoReload;
+    pxNewTimer->ucCatchUpPolicy     = (uint8_t)tmrCATCH_UP_FIRE_ALL;
+    pxNewTimer->ucPriority          = (uint8_t)tmrPRIORITY_LOWEST;
+    pxNewTimer->usMissedPeriods     = 0U;
+    pxNewMetadata->pxCallbackFunction = pxCallbackFunction;
+#if (configUSE_TIMER_POOL == 0)
+    pxNewTimer->pxMetadata          = pxNewMetadata;
+    pxNewMetadata->pxContextDestructor = NULL;
+    pxNewMetadata->pxArray             = NULL;
+#endif
+#if (configUSE_TIMER_CALLBACK_ACCOUNTING == 1)
+    pxNewMetadata->xAccount.ullBudget.store((uint64_t)configTIMER_DEFAULT_CALLBACK_BUDGET_US * 1000U,
+                                            std::memory_order_relaxed);
+    pxNewMetadata->xAccount.ullCalls.store(0U, std::memory_order_relaxed);
+    pxNewMetadata->xAccount.ullWallTime.store(0U, std::memory_order_relaxed);
+    pxNewMetadata->xAccount.ullCpuTime.store(0U, std::memory_order_relaxed);
+    pxNewMetadata->xAccount.ullMaxWallTime.store(0U, std::memory_order_relaxed);
+    pxNewMetadata->xAccount.ullOverruns.store(0U, std::memory_order_relaxed);
+#endif
+    tmrINITIALISE_TIMER_ITEM(pxNewTimer);
+    traceTIMER_CREATE(pxNewTimer);
+    tmrPROBE_TIMER_CREATE(pxNewTimer, pxNewTimer->xTimerPeriodInTicks);
+    tmrCAPTURE_CREATE_TIMER(pxNewTimer);
+}
+
+static void prvProcessExpiredTimer(TimerDomain_t *const pxDomain, Timer_t *const pxTimer, const TickType_t xNextExpireTime, const TickType_t xTimeNow)
 {
     BaseType_t xResult;
-    Timer_t* const pxTimer = (Timer_t*)listGET_OWNER_OF_HEAD_ENTRY(pxCurrentTimerList);
 
-    /* Remove the timer from the list of active timers.  A check has already
-    been performed to ensure the list is not empty. */
-    (void)uxListRemove(&(pxTimer->xTimerListItem));
+    /* Remove the timer from the list of active timers. */
+    tmrREMOVE_TIMER(pxTimer);
     traceTIMER_EXPIRED(pxTimer);
+    tmrPROBE_TIMER_EXPIRED(pxTimer, xNextExpireTime, xTimeNow - xNextExpireTime);
+    tmrSTATS_EXPIRED(pxDomain);
 
     /* If the timer is an auto reload timer then calculate the next
     expiry time and re-insert the timer in the list of active timers. */
-    if (pxTimer->uxAutoReload == (UBaseType_t)pdTRUE)
+    if (pxTimer->ucAutoReload == (uint8_t)pdTRUE)
     {
         /* The timer is inserted into a list using a time relative to anything
         other than the current time.  It will therefore be inserted into the
         correct list relative to the time this task thinks it is now. */
-        if (prvInsertTimerInActiveList(pxTimer, (xNextExpireTime + pxTimer->xTimerPeriodInTicks), xTimeNow, xNextExpireTime) != pdFALSE)
+        const TickType_t xReloadTime = prvCatchUpMissedPeriods(pxTimer, xNextExpireTime, xTimeNow);
+
+        if (prvInsertTimerInActiveList(pxDomain, pxTimer, (xReloadTime + pxTimer->xTimerPeriodInTicks), xTimeNow, xReloadTime) != pdFALSE)
         {
             /* The timer expired before it was added to the active timer
             list.  Reload it now.  */
-            xResult = xTimerGenericCommand(pxTimer, tmrCOMMAND_START_DONT_TRACE, xNextExpireTime, NULL, tmrNO_DELAY);
+            xResult = xTimerGenericCommand(pxTimer, tmrCOMMAND_START_DONT_TRACE, xReloadTime, NULL, tmrNO_DELAY);
             configASSERT(xResult);
             (void)xResult;
         }
@@ -304,35 +1428,373 @@ static void prvProcessExpiredTimer(const TickType_t xNextExpireTime, const TickT
         mtCOVERAGE_TEST_MARKER();
     }
 
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+    prvRecordExpiryLateness(pxDomain, pxTimer, xNextExpireTime, xTimeNow);
+#endif
+
     /* Call the timer callback. */
-    pxTimer->pxCallbackFunction((TimerHandle_t)pxTimer);
+    prvCallTimerCallback(pxDomain, pxTimer);
+}
+
+static TickType_t prvCatchUpMissedPeriods(Timer_t *const pxTimer, const TickType_t xExpiredTime,
+                                          const TickType_t xTimeNow) {
+    const TickType_t xElapsed = (TickType_t)(xTimeNow - xExpiredTime);
+    TickType_t xMissedPeriods;
+
+    if ((pxTimer->ucCatchUpPolicy == (uint8_t)tmrCATCH_UP_FIRE_ALL) ||
+        (xElapsed < pxTimer->xTimerPeriodInTicks)) {
+        /* Either every period is to be fired, or the timer is not behind. */
+        pxTimer->usMissedPeriods = 0U;
+        return xExpiredTime;
+    }
+
+    /* Fire once now and measure the next period from the last period
+    boundary that has passed, so the timer stays in phase. */
+    xMissedPeriods = xElapsed / pxTimer->xTimerPeriodInTicks;
+
+    if (pxTimer->ucCatchUpPolicy == (uint8_t)tmrCATCH_UP_SKIP_AND_COUNT) {
+        pxTimer->usMissedPeriods =
+            (xMissedPeriods > (TickType_t)UINT16_MAX) ? UINT16_MAX : (uint16_t)xMissedPeriods;
+    } else {
+        pxTimer->usMissedPeriods = 0U;
+    }
+
+    return xExpiredTime + (xMissedPeriods * pxTimer->xTimerPeriodInTicks);
+}
+
+void vTimerSetCatchUpPolicy(TimerHandle_t xTimer, const UBaseType_t uxCatchUpPolicy) {
+    Timer_t *const pxTimer = (Timer_t *)xTimer;
+
+    configASSERT(xTimer);
+    configASSERT(uxCatchUpPolicy <= tmrCATCH_UP_SKIP_AND_COUNT);
+
+    /* Read by the timer service task when the timer is reloaded. */
+    pxTimer->ucCatchUpPolicy = (uint8_t)uxCatchUpPolicy;
+}
+
+UBaseType_t uxTimerGetMissedPeriods(const TimerHandle_t xTimer) {
+    const Timer_t *const pxTimer = (const Timer_t *)xTimer;
+
+    configASSERT(xTimer);
+    return (UBaseType_t)pxTimer->usMissedPeriods;
+}
+
+#if (configUSE_TIMER_PRIORITIES == 1)
+
+void vTimerSetPriority(TimerHandle_t xTimer, const UBaseType_t uxPriority) {
+    Timer_t *const pxTimer = (Timer_t *)xTimer;
+
+    configASSERT(xTimer);
+    configASSERT(uxPriority <= tmrPRIORITY_HIGHEST);
+
+    /* Only read by the timer service task when it sweeps the due timers, so
+    the class can change while the timer is active. */
+    pxTimer->ucPriority = (uint8_t)uxPriority;
+}
+
+UBaseType_t uxTimerGetPriority(const TimerHandle_t xTimer) {
+    const Timer_t *const pxTimer = (const Timer_t *)xTimer;
+
+    configASSERT(xTimer);
+    return (UBaseType_t)pxTimer->ucPriority;
+}
+
+static void prvProcessExpiredTimersByPriority(TimerDomain_t *const pxDomain, const TickType_t xTimeNow) {
+    TimerList_t *const pxList = pxDomain->pxCurrentTimerList;
+    Timer_t *pxTimer;
+    Timer_t *pxNextTimer;
+    uint32_t ulClassesDue = 0UL;
+    UBaseType_t uxPriority = tmrPRIORITY_HIGHEST;
+    BaseType_t xFirstClass = pdTRUE;
+#if (configTIMER_SWEEP_BUDGET_US > 0)
+    const std::chrono::steady_clock::time_point xSweepDeadline =
+        std::chrono::steady_clock::now() + std::chrono::microseconds(configTIMER_SWEEP_BUDGET_US);
+#endif
+
+    /* Find the classes of the due timers, which form the front of the list,
+    so only those classes are swept. */
+    pxTimer = (tmrLIST_IS_EMPTY(pxList) == pdFALSE) ? tmrGET_OWNER_OF_HEAD_ENTRY(pxList) : NULL;
+    while ((pxTimer != NULL) && (tmrGET_TIMER_ITEM_VALUE(pxTimer) <= xTimeNow)) {
+        ulClassesDue |= (1UL << pxTimer->ucPriority);
+        pxTimer = tmrGET_NEXT_TIMER(pxList, pxTimer);
+    }
+
+    while (ulClassesDue != 0UL) {
+        while ((ulClassesDue & (1UL << uxPriority)) == 0UL) {
+            uxPriority--;
+        }
+        ulClassesDue &= ~(1UL << uxPriority);
+
+        pxTimer = (tmrLIST_IS_EMPTY(pxList) == pdFALSE) ? tmrGET_OWNER_OF_HEAD_ENTRY(pxList) : NULL;
+        while ((pxTimer != NULL) && (tmrGET_TIMER_ITEM_VALUE(pxTimer) <= xTimeNow)) {
+            pxNextTimer = tmrGET_NEXT_TIMER(pxList, pxTimer);
+
+            if (pxTimer->ucPriority == (uint8_t)uxPriority) {
+#if (configTIMER_SWEEP_BUDGET_US > 0)
+                if ((xFirstClass == pdFALSE) && (std::chrono::steady_clock::now() >= xSweepDeadline)) {
+                    /* The rest stay due, so are expired on the next pass of
+                    the timer service task once the queue has been
+                    emptied. */
+#if (configUSE_TIMER_BATCH_CALLBACKS == 1)
+                    prvFlushBatchCallbacks(pxDomain);
+#endif
+                    return;
+                }
+#endif
+                /* A reloaded timer is never inserted with an expiry time
+                that has passed, so it lands behind the due timers. */
+                prvProcessExpiredTimer(pxDomain, pxTimer, tmrGET_TIMER_ITEM_VALUE(pxTimer), xTimeNow);
+
+                if ((pxNextTimer != NULL) && (tmrTIMER_IS_IN_LIST(pxList, pxNextTimer) == pdFALSE)) {
+                    /* The callback moved the next timer, for example by
+                    stopping a LightweightTimer_t, so start again from the front. */
+                    pxNextTimer = (tmrLIST_IS_EMPTY(pxList) == pdFALSE) ? tmrGET_OWNER_OF_HEAD_ENTRY(pxList) : NULL;
+                } else {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+
+            pxTimer = pxNextTimer;
+        }
+
+#if (configUSE_TIMER_BATCH_CALLBACKS == 1)
+        /* Batches are handed over class by class to keep the order. */
+        prvFlushBatchCallbacks(pxDomain);
+#endif
+        xFirstClass = pdFALSE;
+    }
+
+    (void)xFirstClass;
+}
+
+#endif /* configUSE_TIMER_PRIORITIES */
+
+static void prvCallTimerCallback(TimerDomain_t *const pxDomain, Timer_t *const pxTimer) {
+#if (configUSE_TIMER_BATCH_CALLBACKS == 1)
+    {
+        const UBaseType_t uxRegistered = uxBatchCallbacksRegistered.load(std::memory_order_acquire);
+        const TimerCallbackFunction_t pxCallbackFunction = tmrGET_METADATA(pxTimer)->pxCallbackFunction;
+        PendingBatch_t *pxPending;
+        UBaseType_t ux;
+
+        for (ux = 0; ux < uxRegistered; ux++) {
+            if (xBatchCallbacks[ux].pxCallbackFunction == pxCallbackFunction) {
+                pxPending = &(pxDomain->xPendingBatches[ux]);
+                pxPending->xTimers[pxPending->xPendingTimers++] = (TimerHandle_t)pxTimer;
+
+                if (pxPending->xPendingTimers == (size_t)configTIMER_BATCH_LENGTH) {
+                    traceTIMER_CALLBACK_ENTER(pxPending->xTimers[0]);
+                    tmrPROBE_CALLBACK_ENTRY(pxPending->xTimers[0]);
+                    xBatchCallbacks[ux].pxBatchCallbackFunction(pxPending->xTimers,
+                                                                pxPending->xPendingTimers);
+                    tmrPROBE_CALLBACK_RETURN(pxPending->xTimers[0]);
+                    traceTIMER_CALLBACK_EXIT(pxPending->xTimers[0]);
+                    pxPending->xPendingTimers = 0U;
+                }
+
+                return;
+            }
+        }
+    }
+#endif /* configUSE_TIMER_BATCH_CALLBACKS */
+
+    prvInvokeTimerCallback(pxDomain, pxTimer);
+}
+
+static void prvInvokeTimerCallback(TimerDomain_t *const pxDomain, Timer_t *const pxTimer) {
+#if (configUSE_TIMER_CALLBACK_ACCOUNTING == 1)
+    const uint64_t ullCpuTimeStart  = ullPortGetThreadCpuTime();
+    const uint64_t ullWallTimeStart = ullTimerGetMonotonicTime();
+#else
+    (void)pxDomain;
+#endif
+
+    traceTIMER_CALLBACK_ENTER(pxTimer);
+    tmrPROBE_CALLBACK_ENTRY(pxTimer);
+    tmrGET_METADATA(pxTimer)->pxCallbackFunction((TimerHandle_t)pxTimer);
+    tmrPROBE_CALLBACK_RETURN(pxTimer);
+    traceTIMER_CALLBACK_EXIT(pxTimer);
+
+#if (configUSE_TIMER_CALLBACK_ACCOUNTING == 1)
+    prvAccountTimerCallback(pxDomain, pxTimer, ullTimerGetMonotonicTime() - ullWallTimeStart,
+                            ullPortGetThreadCpuTime() - ullCpuTimeStart);
+#endif
+}
+
+#if (configUSE_TIMER_CALLBACK_ACCOUNTING == 1)
+
+#define tmrACCOUNT_ADD(xCounter, xAmount)                                                        \
+    (xCounter).store((xCounter).load(std::memory_order_relaxed) + (xAmount), std::memory_order_relaxed)
+
+static void prvAccountTimerCallback(TimerDomain_t *const pxDomain, Timer_t *const pxTimer,
+                                    const uint64_t ullWallTime, const uint64_t ullCpuTime) {
+    TimerMetadata_t *const pxMetadata = tmrGET_METADATA(pxTimer);
+    TimerCallbackAccount_t *const pxAccount = &(pxMetadata->xAccount);
+    const uint64_t ullBudget = pxAccount->ullBudget.load(std::memory_order_relaxed);
+    uint64_t ullNow;
+
+    tmrACCOUNT_ADD(pxAccount->ullCalls, 1U);
+    tmrACCOUNT_ADD(pxAccount->ullWallTime, ullWallTime);
+    tmrACCOUNT_ADD(pxAccount->ullCpuTime, ullCpuTime);
+
+    if (ullWallTime > pxAccount->ullMaxWallTime.load(std::memory_order_relaxed)) {
+        pxAccount->ullMaxWallTime.store(ullWallTime, std::memory_order_relaxed);
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    if ((ullBudget != 0U) && (ullWallTime > ullBudget)) {
+        tmrACCOUNT_ADD(pxAccount->ullOverruns, 1U);
+
+        /* Reporting is slow, and a callback that overruns once tends to keep
+        doing so, so report at most once per interval and count the rest. */
+        ullNow = ullTimerGetMonotonicTime();
+
+        if ((pxDomain->ullLastOverrunReport == 0U) ||
+            ((ullNow - pxDomain->ullLastOverrunReport) >=
+             ((uint64_t)configTIMER_OVERRUN_REPORT_INTERVAL_MS * 1000000U))) {
+            configTIMER_REPORT_OVERRUN((pxMetadata->pcTimerName != NULL) ? pxMetadata->pcTimerName : "(unnamed)",
+                                       ullWallTime, ullCpuTime, ullBudget, pxDomain->ulUnreportedOverruns);
+            pxDomain->ullLastOverrunReport = ullNow;
+            pxDomain->ulUnreportedOverruns = 0U;
+        } else {
+            pxDomain->ulUnreportedOverruns++;
+        }
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+void vTimerSetCallbackBudget(TimerHandle_t xTimer, const uint32_t ulBudgetUs) {
+    configASSERT(xTimer);
+    tmrGET_METADATA((Timer_t *)xTimer)->xAccount.ullBudget.store((uint64_t)ulBudgetUs * 1000U,
+                                                                 std::memory_order_relaxed);
+}
+
+void vTimerGetCallbackStats(TimerHandle_t xTimer, TimerCallbackStats_t *const pxStats) {
+    const TimerCallbackAccount_t *pxAccount;
+
+    configASSERT(xTimer);
+    configASSERT(pxStats);
+
+    pxAccount               = &(tmrGET_METADATA((Timer_t *)xTimer)->xAccount);
+    pxStats->ullCalls       = pxAccount->ullCalls.load(std::memory_order_relaxed);
+    pxStats->ullWallTime    = pxAccount->ullWallTime.load(std::memory_order_relaxed);
+    pxStats->ullCpuTime     = pxAccount->ullCpuTime.load(std::memory_order_relaxed);
+    pxStats->ullMaxWallTime = pxAccount->ullMaxWallTime.load(std::memory_order_relaxed);
+    pxStats->ullOverruns    = pxAccount->ullOverruns.load(std::memory_order_relaxed);
+}
+
+#endif /* configUSE_TIMER_CALLBACK_ACCOUNTING */
+
+#if (configUSE_TIMER_BATCH_CALLBACKS == 1)
+
+static void prvFlushBatchCallbacks(TimerDomain_t *const pxDomain) {
+    const UBaseType_t uxRegistered = uxBatchCallbacksRegistered.load(std::memory_order_acquire);
+    PendingBatch_t *pxPending;
+    UBaseType_t ux;
+
+    for (ux = 0; ux < uxRegistered; ux++) {
+        pxPending = &(pxDomain->xPendingBatches[ux]);
+
+        if (pxPending->xPendingTimers > 0U) {
+            traceTIMER_CALLBACK_ENTER(pxPending->xTimers[0]);
+            tmrPROBE_CALLBACK_ENTRY(pxPending->xTimers[0]);
+            xBatchCallbacks[ux].pxBatchCallbackFunction(pxPending->xTimers,
+                                                        pxPending->xPendingTimers);
+            tmrPROBE_CALLBACK_RETURN(pxPending->xTimers[0]);
+            traceTIMER_CALLBACK_EXIT(pxPending->xTimers[0]);
+            pxPending->xPendingTimers = 0U;
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+}
+
+BaseType_t xTimerRegisterBatchCallback(TimerCallbackFunction_t pxCallbackFunction,
+                                       TimerBatchCallbackFunction_t pxBatchCallbackFunction) {
+    std::lock_guard<std::mutex> xLock(xBatchCallbackMutex);
+    const UBaseType_t uxRegistered = uxBatchCallbacksRegistered.load(std::memory_order_relaxed);
+    UBaseType_t ux;
+
+    configASSERT(pxCallbackFunction);
+    configASSERT(pxBatchCallbackFunction);
+
+    for (ux = 0; ux < uxRegistered; ux++) {
+        if (xBatchCallbacks[ux].pxCallbackFunction == pxCallbackFunction) {
+            /* Already registered, the batch form cannot be changed as the
+            timer service task may be using it. */
+            return (xBatchCallbacks[ux].pxBatchCallbackFunction == pxBatchCallbackFunction) ? pdPASS
+                                                                                          : pdFAIL;
+        }
+    }
+
+    if (uxRegistered >= (UBaseType_t)configTIMER_BATCH_CALLBACKS) {
+        return pdFAIL;
+    }
+
+    xBatchCallbacks[uxRegistered].pxCallbackFunction      = pxCallbackFunction;
+    xBatchCallbacks[uxRegistered].pxBatchCallbackFunction = pxBatchCallbackFunction;
+    uxBatchCallbacksRegistered.store(uxRegistered + 1U, std::memory_order_release);
+
+    return pdPASS;
 }
 
+#endif /* configUSE_TIMER_BATCH_CALLBACKS */
+
 void TimersManageTask(void *args) {
+	TimerDomain_t * const pxDomain = ( TimerDomain_t * ) args;
 	TickType_t xNextExpireTime;
 	BaseType_t xListWasEmpty;
 
+	pxDomain->xTimerTaskId = std::this_thread::get_id();
+	if (xPortConfigureThread((uint64_t)configTIMER_TASK_AFFINITY, (int32_t)configTIMER_TASK_REALTIME_PRIORITY,
+		(size_t)configTIMER_THREAD_STACK_PREFAULT) == pdFAIL) {
+		vPortRecordConfigureFailure(portCONFIGURE_TIMER_TASK);
+	}
+
+#if (configUSE_TIMER_TRACE == 1)
+	if (pxDomain->pcDomainName != NULL) {
+		vTimerTraceSetThreadName(pxDomain->pcDomainName);
+	}
+#endif
+
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+	/* Calls pended before the queue existed sent no message. */
+	if (pxDomain == tmrDEFAULT_DOMAIN) {
+		prvExecutePendedFunctionCalls();
+	}
+#endif
+
 	while(1) {
 		/* Query the timers list to see if it contains any timers, and if so,
 		obtain the time at which the next timer will expire. */
-		xNextExpireTime = prvGetNextExpireTime( &xListWasEmpty );
+		xNextExpireTime = prvGetNextExpireTime( pxDomain, &xListWasEmpty );
 
 		/* If a timer has expired, process it.  Otherwise, block this task
 		until either a timer does expire, or a command is received. */
-		prvProcessTimerOrBlockTask( xNextExpireTime, xListWasEmpty );
+#if (configUSE_HIGH_RES_TIMERS == 1)
+		/* High resolution timers are not tied to the tick, so are checked
+		every time round. */
+		pxDomain->ullNextHighResExpiryTime = prvProcessExpiredHighResTimers(pxDomain);
+#endif
+
+		prvProcessTimerOrBlockTask( pxDomain, xNextExpireTime, xListWasEmpty );
 
 		/* Empty the command queue. */
-		prvProcessReceivedCommands();
+		prvProcessReceivedCommands( pxDomain );
+
+		tmrSTATS_LIST_LENGTHS(pxDomain);
 	}
 }
 
-static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty ) {
+static TickType_t prvGetNextExpireTime( TimerDomain_t * const pxDomain, BaseType_t * const pxListWasEmpty ) {
     TickType_t xNextExpireTime;
 	/* Timers are listed in expiry time order, with the head of the list referencing the task that will expire first.
 	*/
-	*pxListWasEmpty = listLIST_IS_EMPTY( pxCurrentTimerList );
+	*pxListWasEmpty = tmrLIST_IS_EMPTY( pxDomain->pxCurrentTimerList );
 	if( *pxListWasEmpty == false ) {
-		xNextExpireTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxCurrentTimerList );
+		xNextExpireTime = tmrGET_ITEM_VALUE_OF_HEAD_ENTRY( pxDomain->pxCurrentTimerList );
 	} else {
 		/* Ensure the task unblocks when the tick count rolls over. */
 		xNextExpireTime = ( TickType_t ) 0U;
@@ -341,30 +1803,28 @@ static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty ) {
 	return xNextExpireTime;
 }
 
-static TickType_t prvSampleTimeNow( BaseType_t * const pxTimerListsWereSwitched ) {
+static TickType_t prvSampleTimeNow( TimerDomain_t * const pxDomain, BaseType_t * const pxTimerListsWereSwitched ) {
 TickType_t xTimeNow;
-/* PRIVILEGED_DATA*/ static TickType_t xLastTime = ( TickType_t ) 0U; /*lint !e956 Variable is only accessible to one task. */
 
-	xTimeNow = xTaskGetTickCount();
+	xTimeNow = xTickSourceGetCount( pxDomain->pxTickSource );
 
-	if( xTimeNow < xLastTime ) {
-		prvSwitchTimerLists();
+	if( xTimeNow < pxDomain->xLastTime ) {
+		prvSwitchTimerLists(pxDomain, xTimeNow);
 		*pxTimerListsWereSwitched = true;
 	} else {
 		*pxTimerListsWereSwitched = false;
 	}
 
-	xLastTime = xTimeNow;
+	pxDomain->xLastTime = xTimeNow;
 
 	return xTimeNow;
 }
 
-static BaseType_t prvInsertTimerInActiveList(Timer_t* const pxTimer, const TickType_t xNextExpiryTime, const TickType_t xTimeNow, const TickType_t xCommandTime)
+static BaseType_t prvInsertTimerInActiveList(TimerDomain_t* const pxDomain, Timer_t* const pxTimer, const TickType_t xNextExpiryTime, const TickType_t xTimeNow, const TickType_t xCommandTime)
 {
     BaseType_t xProcessTimerNow = pdFALSE;
 
-    listSET_LIST_ITEM_VALUE(&(pxTimer->xTimerListItem), xNextExpiryTime);
-    listSET_LIST_ITEM_OWNER(&(pxTimer->xTimerListItem), pxTimer);
+    tmrSET_TIMER_ITEM_VALUE(pxTimer, xNextExpiryTime);
 
     if (xNextExpiryTime <= xTimeNow)
     {
@@ -378,7 +1838,7 @@ static BaseType_t prvInsertTimerInActiveList(Timer_t* const pxTimer, const TickT
         }
         else
         {
-            vListInsert(pxOverflowTimerList, &(pxTimer->xTimerListItem));
+            tmrINSERT_TIMER_AND_COUNT(pxDomain, pxDomain->pxOverflowTimerList, pxTimer);
         }
     }
     else
@@ -392,14 +1852,14 @@ static BaseType_t prvInsertTimerInActiveList(Timer_t* const pxTimer, const TickT
         }
         else
         {
-            vListInsert(pxCurrentTimerList, &(pxTimer->xTimerListItem));
+            tmrINSERT_TIMER_AND_COUNT(pxDomain, pxDomain->pxCurrentTimerList, pxTimer);
         }
     }
 
     return xProcessTimerNow;
 }
 
-static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseType_t xListWasEmpty ) {
+static void prvProcessTimerOrBlockTask( TimerDomain_t * const pxDomain, const TickType_t xNextExpireTime, BaseType_t xListWasEmpty ) {
     TickType_t xTimeNow;
     BaseType_t xTimerListsWereSwitched;
     
@@ -410,14 +1870,36 @@ static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseTy
         then don't process this timer as any timers that remained in the list
         when the lists were switched will have been processed within the
         prvSampleTimeNow() function. */
-        xTimeNow = prvSampleTimeNow(&xTimerListsWereSwitched);
+        xTimeNow = prvSampleTimeNow(pxDomain, &xTimerListsWereSwitched);
         if (xTimerListsWereSwitched == pdFALSE)
         {
             /* The tick count has not overflowed, has the timer expired? */
             if ((xListWasEmpty == pdFALSE) && (xNextExpireTime <= xTimeNow))
             {
                 //(void)xTaskResumeAll();
-                prvProcessExpiredTimer(xNextExpireTime, xTimeNow);
+#if (configUSE_TIMER_PRIORITIES == 1)
+                prvProcessExpiredTimersByPriority(pxDomain, xTimeNow);
+#else
+                prvProcessExpiredTimer(pxDomain, tmrGET_OWNER_OF_HEAD_ENTRY(pxDomain->pxCurrentTimerList),
+                                       xNextExpireTime, xTimeNow);
+
+#if (configUSE_TIMER_BATCH_CALLBACKS == 1)
+                {
+                    /* Expire everything that is due in this sweep so timers
+                    sharing a batch callback are handed over together.
+                    Reloaded timers cannot come round again as they are never
+                    inserted with an expiry time in the past. */
+                    while ((tmrLIST_IS_EMPTY(pxDomain->pxCurrentTimerList) == pdFALSE) &&
+                           (tmrGET_ITEM_VALUE_OF_HEAD_ENTRY(pxDomain->pxCurrentTimerList) <= xTimeNow)) {
+                        prvProcessExpiredTimer(pxDomain, tmrGET_OWNER_OF_HEAD_ENTRY(pxDomain->pxCurrentTimerList),
+                                               tmrGET_ITEM_VALUE_OF_HEAD_ENTRY(pxDomain->pxCurrentTimerList),
+                                               xTimeNow);
+                    }
+
+                    prvFlushBatchCallbacks(pxDomain);
+                }
+#endif /* configUSE_TIMER_BATCH_CALLBACKS */
+#endif /* configUSE_TIMER_PRIORITIES */
             }
             else
             {
@@ -431,10 +1913,24 @@ static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseTy
                 {
                     /* The current timer list is empty - is the overflow list
                     also empty? */
-                    xListWasEmpty = listLIST_IS_EMPTY(pxOverflowTimerList);
+                    xListWasEmpty = tmrLIST_IS_EMPTY(pxDomain->pxOverflowTimerList);
                 }
 
-                //vQueueWaitForMessageRestricted(xTimerQueue, (xNextExpireTime - xTimeNow), xListWasEmpty);
+                /* The block time is counted on the tick of the domain.
+                Also wake for the next high resolution expiry, so no tick is
+                needed to run those timers on time. */
+                traceTIMER_TASK_BLOCK(xListWasEmpty != pdFALSE ? portMAX_DELAY : (xNextExpireTime - xTimeNow));
+#if (configUSE_HIGH_RES_TIMERS == 1)
+                vQueueWaitForMessageUntil(pxDomain->xTimerQueue, pxDomain->pxTickSource,
+                                          xTimeNow, xNextExpireTime, xListWasEmpty,
+                                          pxDomain->ullNextHighResExpiryTime);
+#else
+                vQueueWaitForMessageUntil(pxDomain->xTimerQueue, pxDomain->pxTickSource,
+                                          xTimeNow, xNextExpireTime, xListWasEmpty,
+                                          queueNO_DEADLINE);
+#endif
+                traceTIMER_TASK_WAKE();
+                tmrSTATS_WAKE_UP(pxDomain);
 
                 //if (xTaskResumeAll() == pdFALSE)
                 //{
@@ -457,169 +1953,611 @@ static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseTy
     }
 
 }
-static void prvProcessReceivedCommands( void ) {
+static void prvProcessReceivedCommands( TimerDomain_t * const pxDomain ) {
+    DaemonTaskMessage_t xMessage;
     Timer_t* pxTimer;
     BaseType_t xTimerListsWereSwitched, xResult;
     TickType_t xTimeNow;
-    /* Commands that are positive are timer commands rather than pended
-function calls. */
-    if (xMessage.xMessageID >= (BaseType_t)0)
+
+    while (xQueueReceive(pxDomain->xTimerQueue, &xMessage, tmrNO_DELAY) != pdFAIL) /*lint !e603 xMessage does not have to be initialised as it is passed out, not in, and it is not used unless xQueueReceive() returns pdTRUE. */
     {
-        /* The messages uses the xTimerParameters member to work on a
-        software timer. */
-        pxTimer = xMessage.u.xTimerParameters.pxTimer;
+        tmrSTATS_MESSAGE(pxDomain, xMessage.xMessageID);
+
+#if (configUSE_HIGH_RES_TIMERS == 1)
+        if (xMessage.xMessageID >= tmrFIRST_HIGH_RES_COMMAND)
+        {
+            prvProcessHighResCommand(pxDomain, &xMessage);
+            continue;
+        }
+#endif
 
-        if (listIS_CONTAINED_WITHIN(NULL, &(pxTimer->xTimerListItem)) == pdFALSE)
+        if (xMessage.xMessageID == tmrCOMMAND_FENCE)
+        {
+            prvPassFence(xMessage.u.pxFence);
+            continue;
+        }
+        else if (xMessage.xMessageID == tmrCOMMAND_CANCELLED)
         {
-            /* The timer is in a list, remove it. */
-            (void)uxListRemove(&(pxTimer->xTimerListItem));
+            /* Sent for a timer that has since been deleted, see
+            prvCancelQueuedCommand(). */
+            continue;
         }
         else
         {
             mtCOVERAGE_TEST_MARKER();
         }
 
-        traceTIMER_COMMAND_RECEIVED(pxTimer, xMessage.xMessageID, xMessage.u.xTimerParameters.xMessageValue);
-
-        /* In this case the xTimerListsWereSwitched parameter is not used, but
-        it must be present in the function call.  prvSampleTimeNow() must be
-        called after the message is received from xTimerQueue so there is no
-        possibility of a higher priority task adding a message to the message
-        queue with a time that is ahead of the timer daemon task (because it
-        pre-empted the timer daemon task after the xTimeNow value was set). */
-        xTimeNow = prvSampleTimeNow(&xTimerListsWereSwitched);
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+        if (xMessage.xMessageID < (BaseType_t)0)
+        {
+            /* Only sent to wake this task, the pended function calls are
+            run once the queue is empty. */
+            continue;
+        }
+#endif
 
-        switch (xMessage.xMessageID)
+        /* Commands that are positive are timer commands rather than pended
+    function calls. */
+        if (xMessage.xMessageID >= (BaseType_t)0)
         {
-        case tmrCOMMAND_START:
-        case tmrCOMMAND_START_FROM_ISR:
-        case tmrCOMMAND_RESET:
-        case tmrCOMMAND_RESET_FROM_ISR:
-        case tmrCOMMAND_START_DONT_TRACE:
-            /* Start or restart a timer. */
-            if (prvInsertTimerInActiveList(pxTimer, xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks, xTimeNow, xMessage.u.xTimerParameters.xMessageValue) != pdFALSE)
+            /* The messages uses the xTimerParameters member to work on a
+            software timer. */
+            pxTimer = xMessage.u.xTimerParameters.pxTimer;
+
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+            prvRecordInHistogram(tmrHISTOGRAM_COMMAND_LATENCY, (UBaseType_t)pxTimer->ucPriority,
+                                 ullTimerGetMonotonicTime() - xMessage.ullSendTime);
+#endif
+
+            if (tmrTIMER_IS_IN_A_LIST(pxTimer))
+            {
+                /* The timer is in a list, remove it. */
+                tmrREMOVE_TIMER(pxTimer);
+            }
+            else
             {
-                /* The timer expired before it was added to the active
-                timer list.  Process it now. */
-                pxTimer->pxCallbackFunction((TimerHandle_t)pxTimer);
-                traceTIMER_EXPIRED(pxTimer);
+                mtCOVERAGE_TEST_MARKER();
+            }
 
-                if (pxTimer->uxAutoReload == (UBaseType_t)pdTRUE)
+            traceTIMER_COMMAND_RECEIVED(pxTimer, xMessage.xMessageID, xMessage.u.xTimerParameters.xMessageValue);
+            tmrPROBE_COMMAND_RECEIVED(pxTimer, xMessage.xMessageID, xMessage.u.xTimerParameters.xMessageValue);
+
+            /* In this case the xTimerListsWereSwitched parameter is not used, but
+            it must be present in the function call.  prvSampleTimeNow() must be
+            called after the message is received from xTimerQueue so there is no
+            possibility of a higher priority task adding a message to the message
+            queue with a time that is ahead of the timer daemon task (because it
+            pre-empted the timer daemon task after the xTimeNow value was set). */
+            xTimeNow = prvSampleTimeNow(pxDomain, &xTimerListsWereSwitched);
+
+            switch (xMessage.xMessageID)
+            {
+            case tmrCOMMAND_START:
+            case tmrCOMMAND_START_FROM_ISR:
+            case tmrCOMMAND_RESET:
+            case tmrCOMMAND_RESET_FROM_ISR:
+            case tmrCOMMAND_START_DONT_TRACE:
+                /* Start or restart a timer. */
+                if (prvInsertTimerInActiveList(pxDomain, pxTimer, xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks, xTimeNow, xMessage.u.xTimerParameters.xMessageValue) != pdFALSE)
                 {
-                    xResult = xTimerGenericCommand(pxTimer, tmrCOMMAND_START_DONT_TRACE, xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks, NULL, tmrNO_DELAY);
-                    configASSERT(xResult);
-                    (void)xResult;
-                    memset(&xMessage, 0, sizeof(xMessage));
+                    /* The timer expired before it was added to the active
+                    timer list.  Process it now. */
+                    TickType_t xReloadTime = xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks;
+
+                    if (pxTimer->ucAutoReload == (uint8_t)pdTRUE)
+                    {
+                        xReloadTime = prvCatchUpMissedPeriods(pxTimer, xReloadTime, xTimeNow);
+                    }
+
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+                    prvRecordExpiryLateness(pxDomain, pxTimer,
+                                            xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks,
+                                            xTimeNow);
+#endif
+                    prvInvokeTimerCallback(pxDomain, pxTimer);
+                    traceTIMER_EXPIRED(pxTimer);
+                    tmrPROBE_TIMER_EXPIRED(pxTimer,
+                                           xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks,
+                                           xTimeNow - (xMessage.u.xTimerParameters.xMessageValue +
+                                                       pxTimer->xTimerPeriodInTicks));
+                    tmrSTATS_EXPIRED(pxDomain);
+
+                    if (pxTimer->ucAutoReload == (uint8_t)pdTRUE)
+                    {
+                        xResult = xTimerGenericCommand(pxTimer, tmrCOMMAND_START_DONT_TRACE, xReloadTime, NULL, tmrNO_DELAY);
+                        configASSERT(xResult);
+                        (void)xResult;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
                 }
                 else
                 {
                     mtCOVERAGE_TEST_MARKER();
                 }
-            }
-            else
+            
+                break;
+
+            case tmrCOMMAND_STOP:
+            case tmrCOMMAND_STOP_FROM_ISR:
+                /* The timer has already been removed from the active list.
+                There is nothing to do here. */
+                break;
+
+            case tmrCOMMAND_CHANGE_PERIOD:
+            case tmrCOMMAND_CHANGE_PERIOD_FROM_ISR:
+                pxTimer->xTimerPeriodInTicks = xMessage.u.xTimerParameters.xMessageValue;
+                configASSERT((pxTimer->xTimerPeriodInTicks > 0));
+
+                /* The new period does not really have a reference, and can
+                be longer or shorter than the old one.  The command time is
+                therefore set to the current time, and as the period cannot
+                be zero the next expiry time can only be in the future,
+                meaning (unlike for the xTimerStart() case above) there is
+                no fail case that needs to be handled here. */
+                (void)prvInsertTimerInActiveList(pxDomain, pxTimer, (xTimeNow + pxTimer->xTimerPeriodInTicks), xTimeNow, xTimeNow);
+                break;
+
+            case tmrCOMMAND_DELETE:
+                /* The timer has already been removed from the active list,
+                just free up the memory if the memory was dynamically
+                allocated. */
+#if( configUSE_TIMER_POOL == 1 )
             {
-                mtCOVERAGE_TEST_MARKER();
+                /* The timer came from the pool - give its slot back. */
+                prvReturnTimerToPool(pxTimer);
             }
-            
-            break;
-
-        case tmrCOMMAND_STOP:
-        case tmrCOMMAND_STOP_FROM_ISR:
-            /* The timer has already been removed from the active list.
-            There is nothing to do here. */
-            break;
-
-        case tmrCOMMAND_CHANGE_PERIOD:
-        case tmrCOMMAND_CHANGE_PERIOD_FROM_ISR:
-            pxTimer->xTimerPeriodInTicks = xMessage.u.xTimerParameters.xMessageValue;
-            configASSERT((pxTimer->xTimerPeriodInTicks > 0));
-
-            /* The new period does not really have a reference, and can
-            be longer or shorter than the old one.  The command time is
-            therefore set to the current time, and as the period cannot
-            be zero the next expiry time can only be in the future,
-            meaning (unlike for the xTimerStart() case above) there is
-            no fail case that needs to be handled here. */
-            (void)prvInsertTimerInActiveList(pxTimer, (xTimeNow + pxTimer->xTimerPeriodInTicks), xTimeNow, xTimeNow);
-            break;
-
-        case tmrCOMMAND_DELETE:
-            /* The timer has already been removed from the active list,
-            just free up the memory if the memory was dynamically
-            allocated. */
-#if( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 0 ) )
-        {
-            /* The timer can only have been allocated dynamically -
-            free it again. */
-            //vPortFree(pxTimer);
-            delete[] pxTimer;
-        }
-#elif( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) )
-        {
-            /* The timer could have been allocated statically or
-            dynamically, so check before attempting to free the
-            memory. */
-            if (pxTimer->ucStaticallyAllocated == (uint8_t)pdFALSE)
+#elif( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 0 ) )
             {
-                vPortFree(pxTimer);
+                /* The timer can only have been allocated dynamically -
+                free it again. */
+                //vPortFree(pxTimer);
+                prvFreeTimer(pxTimer);
             }
-            else
+#elif( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) )
             {
-                mtCOVERAGE_TEST_MARKER();
+                /* The timer could have been allocated statically or
+                dynamically, so check before attempting to free the
+                memory. */
+                if (tmrGET_METADATA(pxTimer)->ucStaticallyAllocated == (uint8_t)pdFALSE)
+                {
+                    prvFreeTimer(pxTimer);
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
             }
-        }
 #endif /* configSUPPORT_DYNAMIC_ALLOCATION */
-        break;
-
-        default:
-            /* Don't expect to get here. */
             break;
+
+            default:
+                /* Don't expect to get here. */
+                break;
+            }
         }
     }
 
-}
-
-BaseType_t xTimerGenericCommand(TimerHandle_t xTimer, const BaseType_t xCommandID,
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+    if (pxDomain == tmrDEFAULT_DOMAIN)
+    {
+        prvExecutePendedFunctionCalls();
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+#endif
+}
+
+BaseType_t xTimerGenericCommand(TimerHandle_t xTimer, const BaseType_t xCommandID,
                                 const TickType_t  xOptionalValue,
                                 BaseType_t *const pxHigherPriorityTaskWoken,
                                 const TickType_t  xTicksToWait) {
     BaseType_t          xReturn = pdFAIL;
+    DaemonTaskMessage_t xMessage;
+    TimerDomain_t *     pxDomain;
+#if (configUSE_TIMER_CAPTURE == 1)
+    TickType_t          xCapturePeriod;
+    UBaseType_t         uxCaptureAutoReload;
+    TickType_t          xCaptureTickCount;
+#endif
 
     configASSERT(xTimer);
 
-    /* Send a message to the timer service task to perform a particular action
-    on a particular timer definition. */
-    if (xTimerQueue != NULL) {
+    /* Send a message to the timer service task of the domain of the timer
+    to perform a particular action on a particular timer definition. */
+    pxDomain = tmrGET_METADATA((Timer_t *)xTimer)->pxDomain;
+    if (pxDomain->xTimerQueue != NULL) {
+#if (configUSE_TIMER_CAPTURE == 1)
+        /* Once a delete is sent the timer service task can free the timer, so
+        what the capture needs of it is read first. */
+        xCapturePeriod      = ((Timer_t *)xTimer)->xTimerPeriodInTicks;
+        uxCaptureAutoReload = (UBaseType_t)((Timer_t *)xTimer)->ucAutoReload;
+        xCaptureTickCount   = xTickSourceGetCount(pxDomain->pxTickSource);
+#endif
+
+
         /* Send a command to the timer service task to start the xTimer timer. */
         xMessage.xMessageID                       = xCommandID;
         xMessage.u.xTimerParameters.xMessageValue = xOptionalValue;
         xMessage.u.xTimerParameters.pxTimer       = (Timer_t *)xTimer;
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+        xMessage.ullSendTime = ullTimerGetMonotonicTime();
+#endif
+
+        if (xCommandID < tmrFIRST_FROM_ISR_COMMAND) {
+            /* Blocking is pointless until the timer service task is running
+            to empty the queue. */
+            if (pxDomain->xTimerTaskHandle != NULL) {
+                xReturn = xQueueSendToBack(pxDomain->xTimerQueue, &xMessage, xTicksToWait);
+            } else {
+                xReturn = xQueueSendToBack(pxDomain->xTimerQueue, &xMessage, tmrNO_DELAY);
+            }
+        } else {
+            xReturn = xQueueSendToBackFromISR(pxDomain->xTimerQueue, &xMessage, pxHigherPriorityTaskWoken);
+        }
 
-        //if (xCommandID < tmrFIRST_FROM_ISR_COMMAND) {
-        //    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
-        //        xReturn = xQueueSendToBack(xTimerQueue, &xMessage, xTicksToWait);
-        //    } else {
-        //        xReturn = xQueueSendToBack(xTimerQueue, &xMessage, tmrNO_DELAY);
-        //    }
-        //} else {
-        //    xReturn = xQueueSendToBackFromISR(xTimerQueue, &xMessage, pxHigherPriorityTaskWoken);
-        //}
-
-        //traceTIMER_COMMAND_SEND(xTimer, xCommandID, xOptionalValue, xReturn);
+        traceTIMER_COMMAND_SEND(xTimer, xCommandID, xOptionalValue, xReturn);
+        tmrPROBE_COMMAND_SEND(xTimer, xCommandID, xOptionalValue, xReturn);
+        tmrCAPTURE_COMMAND(xTimer, xCapturePeriod, uxCaptureAutoReload, xCaptureTickCount, xCommandID, xOptionalValue,
+                           xTicksToWait, xReturn);
     } else {
         mtCOVERAGE_TEST_MARKER();
     }
-    xReturn = pdPASS;
+
     return xReturn;
 }
 
-void Start() {
-  
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+
+static BaseType_t prvPushPendedFunctionCall(PendedFunction_t xFunctionToPend, void *pvParameter1,
+                                            uint32_t ulParameter2) {
+    size_t xPosition = xNextPendedCallToWrite.load(std::memory_order_relaxed);
+    PendedCallSlot_t *pxSlot;
+    size_t xSlotIndex;
+    intptr_t xDifference;
+
+    for (;;) {
+        xSlotIndex  = xPosition & (configTIMER_PEND_QUEUE_LENGTH - 1U);
+        pxSlot      = &(xPendedCalls[xSlotIndex]);
+        xDifference = (intptr_t)((pxSlot->xSequence.load(std::memory_order_acquire) + xSlotIndex) - xPosition);
+
+        if (xDifference == 0) {
+            /* The slot is free, claim it. */
+            if (xNextPendedCallToWrite.compare_exchange_weak(xPosition, xPosition + 1U,
+                                                             std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (xDifference < 0) {
+            /* The slot still holds the call from the previous lap. */
+            return pdFAIL;
+        } else {
+            /* Another task claimed the slot first. */
+            xPosition = xNextPendedCallToWrite.load(std::memory_order_relaxed);
+        }
+    }
+
+    pxSlot->xCall.pxCallbackFunction = xFunctionToPend;
+    pxSlot->xCall.pvParameter1       = pvParameter1;
+    pxSlot->xCall.ulParameter2       = ulParameter2;
+    pxSlot->xSequence.store((xPosition + 1U) - xSlotIndex, std::memory_order_release);
+
+    return pdPASS;
+}
+
+static BaseType_t prvPopPendedFunctionCall(CallbackParameters_t *const pxCall) {
+    const size_t xSlotIndex = xNextPendedCallToRead & (configTIMER_PEND_QUEUE_LENGTH - 1U);
+    PendedCallSlot_t *const pxSlot = &(xPendedCalls[xSlotIndex]);
+
+    if ((pxSlot->xSequence.load(std::memory_order_acquire) + xSlotIndex) != (xNextPendedCallToRead + 1U)) {
+        /* Empty, or the call is still being written. */
+        return pdFAIL;
+    }
+
+    *pxCall = pxSlot->xCall;
+    pxSlot->xSequence.store((xNextPendedCallToRead + configTIMER_PEND_QUEUE_LENGTH) - xSlotIndex,
+                            std::memory_order_release);
+    xNextPendedCallToRead++;
+
+    return pdPASS;
 }
 
-static void prvSwitchTimerLists(void) {
+static void prvSignalPendedFunctionCalls(void) {
+    DaemonTaskMessage_t xMessage;
+    BaseType_t xHigherPriorityTaskWoken;
+
+    if (xPendedCallsSignalled.exchange(true) == false) {
+        xMessage.xMessageID = tmrCOMMAND_EXECUTE_CALLBACK_FROM_ISR;
+
+        if ((tmrDEFAULT_DOMAIN->xTimerQueue == NULL) ||
+            (xQueueSendToBackFromISR(tmrDEFAULT_DOMAIN->xTimerQueue, &xMessage,
+                                     &xHigherPriorityTaskWoken) == pdFAIL)) {
+            /* Either the timer service task does not exist yet and will run
+            the calls when it starts, or its queue is full so it is not going
+            to block.  Let the next call try again. */
+            xPendedCallsSignalled.store(false);
+        }
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+static void prvExecutePendedFunctionCalls(void) {
+    CallbackParameters_t xCall;
+    UBaseType_t uxExecuted;
+
+    /* Cleared first, so a call pended from here on sends a new message. */
+    xPendedCallsSignalled.store(false);
+
+    for (uxExecuted = 0U; uxExecuted < (UBaseType_t)configTIMER_PEND_BATCH_LENGTH; uxExecuted++) {
+        if (prvPopPendedFunctionCall(&xCall) == pdFAIL) {
+            break;
+        }
+
+        xCall.pxCallbackFunction(xCall.pvParameter1, xCall.ulParameter2);
+    }
+
+    if (uxExecuted == (UBaseType_t)configTIMER_PEND_BATCH_LENGTH) {
+        /* Give the timers a turn, but do not block while calls remain. */
+        prvSignalPendedFunctionCalls();
+    }
+
+    if ((uxExecuted > 0U) && (uxPendedCallWaiters.load() != 0U)) {
+        { std::lock_guard<std::mutex> xLock(xPendedCallSpaceMutex); }
+        xPendedCallSpace.notify_all();
+    }
+}
+
+BaseType_t xTimerPendFunctionCallFromISR(PendedFunction_t xFunctionToPend, void *pvParameter1,
+                                         uint32_t ulParameter2,
+                                         BaseType_t *pxHigherPriorityTaskWoken) {
+    BaseType_t xReturn;
+
+    configASSERT(xFunctionToPend);
+
+    xReturn = prvPushPendedFunctionCall(xFunctionToPend, pvParameter1, ulParameter2);
+
+    if (xReturn != pdFAIL) {
+        prvSignalPendedFunctionCalls();
+    } else {
+        uxPendedCallsRejected++;
+    }
+
+    if (pxHigherPriorityTaskWoken != NULL) {
+        /* No task is ever unblocked directly in the simulator. */
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+
+    return xReturn;
+}
+
+BaseType_t xTimerPendFunctionCall(PendedFunction_t xFunctionToPend, void *pvParameter1,
+                                  uint32_t ulParameter2, TickType_t xTicksToWait) {
+    const TickType_t xStartTick = xTaskGetTickCount();
+    BaseType_t xReturn;
+
+    configASSERT(xFunctionToPend);
+
+    xReturn = prvPushPendedFunctionCall(xFunctionToPend, pvParameter1, ulParameter2);
+
+    /* The timer service task would wait for itself. */
+    if ((xReturn == pdFAIL) && (xTicksToWait > (TickType_t)0U) &&
+        (std::this_thread::get_id() != tmrDEFAULT_DOMAIN->xTimerTaskId)) {
+        std::unique_lock<std::mutex> xLock(xPendedCallSpaceMutex);
+
+        uxPendedCallWaiters++;
+
+        /* Woken when the timer service task has made space, and once a tick
+        to count the time waited. */
+        while (((xReturn = prvPushPendedFunctionCall(xFunctionToPend, pvParameter1, ulParameter2)) == pdFAIL) &&
+               ((TickType_t)(xTaskGetTickCount() - xStartTick) < xTicksToWait)) {
+            (void)xPendedCallSpace.wait_for(xLock, std::chrono::microseconds(1000000U / configTICK_RATE_HZ));
+        }
+
+        uxPendedCallWaiters--;
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    if (xReturn != pdFAIL) {
+        prvSignalPendedFunctionCalls();
+    } else {
+        uxPendedCallsRejected++;
+    }
+
+    return xReturn;
+}
+
+UBaseType_t uxTimerGetPendedFunctionCallsRejected(void) {
+    return uxPendedCallsRejected.load(std::memory_order_relaxed);
+}
+
+#endif /* INCLUDE_xTimerPendFunctionCall */
+
+void *pvTimerGetTimerID(const TimerHandle_t xTimer) {
+    Timer_t *const pxTimer = (Timer_t *)xTimer;
+
+    configASSERT(xTimer);
+    return tmrGET_METADATA(pxTimer)->pvTimerID;
+}
+
+void vTimerSetTimerID(TimerHandle_t xTimer, void *pvNewID) {
+    Timer_t *const pxTimer = (Timer_t *)xTimer;
+
+    configASSERT(xTimer);
+    tmrGET_METADATA(pxTimer)->pvTimerID = pvNewID;
+}
+
+static void prvPassFence(TimerFence_t *const pxFence) {
+    /* Notified under the lock, so the waiting task cannot return and take the
+    fence off its stack before this has finished with it. */
+    std::lock_guard<std::mutex> xLock(pxFence->xMutex);
+
+    pxFence->xHasPassed = pdTRUE;
+    pxFence->xPassed.notify_all();
+}
+
+#if (configUSE_TIMER_POOL == 0)
+
+static BaseType_t prvWaitForTimerTask(TimerDomain_t *const pxDomain) {
+    TimerFence_t        xFence;
+    DaemonTaskMessage_t xMessage;
+
+    configASSERT(std::this_thread::get_id() != pxDomain->xTimerTaskId);
+
+    if (pxDomain->xTimerTaskHandle == NULL) {
+        return pdFAIL;
+    }
+
+    xFence.xHasPassed   = pdFALSE;
+    xMessage.xMessageID = tmrCOMMAND_FENCE;
+    xMessage.u.pxFence  = &xFence;
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+    xMessage.ullSendTime = ullTimerGetMonotonicTime();
+#endif
+
+    if (xQueueSendToBack(pxDomain->xTimerQueue, &xMessage, portMAX_DELAY) == pdFAIL) {
+        return pdFAIL;
+    }
+
+    std::unique_lock<std::mutex> xLock(xFence.xMutex);
+    xFence.xPassed.wait(xLock, [&xFence] { return xFence.xHasPassed != pdFALSE; });
+
+    return pdPASS;
+}
+
+static BaseType_t prvIsTimerTask(TimerDomain_t *const pxDomain) {
+    return (pxDomain->xTimerTaskHandle != NULL) && (std::this_thread::get_id() == pxDomain->xTimerTaskId);
+}
+
+static void prvCancelQueuedCommand(void *pvItem, void *pvContext) {
+    DaemonTaskMessage_t *const pxMessage = (DaemonTaskMessage_t *)pvItem;
+
+    if ((pxMessage->xMessageID >= (BaseType_t)0) && (pxMessage->xMessageID < tmrFIRST_HIGH_RES_COMMAND) &&
+        (pxMessage->u.xTimerParameters.pxTimer == (Timer_t *)pvContext)) {
+        pxMessage->xMessageID = tmrCOMMAND_CANCELLED;
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+static void prvLightweightTimerCallback(TimerHandle_t xTimer) {
+    /* The Timer_t is the first member of the LightweightTimer_t, see Init(). */
+    LightweightTimer_t *const pxTimer = (LightweightTimer_t *)xTimer;
+
+    if (pxTimer->callback != NULL) {
+        pxTimer->callback(pxTimer);
+    }
+}
+
+static BaseType_t prvArmLightweightTimer(LightweightTimer_t *const pxLightweightTimer) {
+    Timer_t *const pxTimer = (Timer_t *)pxLightweightTimer;
+    TimerDomain_t *const pxDomain = tmrGET_METADATA(pxTimer)->pxDomain;
+    BaseType_t     xReturn = pdPASS;
+    TickType_t     xTimeNow;
+
+    configASSERT(pxLightweightTimer->tick_count > 0);
+
+    if (prvIsTimerTask(pxDomain) != pdFALSE) {
+        /* Only the timer service task touches the active lists, so the timer
+        can be linked in directly. */
+        if (tmrTIMER_IS_IN_A_LIST(pxTimer)) {
+            tmrREMOVE_TIMER(pxTimer);
+        }
+
+        /* The time of the sweep or command being processed.  Sampling the
+        tick count again could switch the lists under the sweep that called
+        back into here. */
+        pxTimer->xTimerPeriodInTicks = pxLightweightTimer->tick_count;
+        xTimeNow = pxDomain->xLastTime;
+        (void)prvInsertTimerInActiveList(pxDomain, pxTimer, xTimeNow + pxTimer->xTimerPeriodInTicks, xTimeNow,
+                                         xTimeNow);
+    } else {
+        /* The period is only read by the timer service task when it
+        processes the command, which is sent after the write. */
+        pxTimer->xTimerPeriodInTicks = pxLightweightTimer->tick_count;
+        xReturn = xTimerGenericCommand(pxTimer, tmrCOMMAND_START,
+                                       xTickSourceGetCount(pxDomain->pxTickSource), NULL, tmrNO_DELAY);
+    }
+
+    return xReturn;
+}
+
+void Init(LightweightTimer_t *timer, uint32_t tick_count, ExpireCallBack callback) {
+    StaticTimerStorage_t *const pxStorage = new (&(timer->timer)) StaticTimerStorage_t;
+
+    configASSERT(sizeof(StaticTimer_t) == sizeof(StaticTimerStorage_t));
+
+    timer->tick_count = tick_count;
+    timer->callback   = callback;
+
+    prvCheckForValidListAndQueue(tmrDEFAULT_DOMAIN);
+    prvInitialiseTimerMembers(tmrDEFAULT_DOMAIN, NULL, (tick_count > 0) ? tick_count : 1, pdFALSE, NULL,
+                              prvLightweightTimerCallback, &(pxStorage->xTimer),
+                              &(pxStorage->xMetadata));
+#if ((configSUPPORT_STATIC_ALLOCATION == 1) && (configSUPPORT_DYNAMIC_ALLOCATION == 1))
+    pxStorage->xMetadata.ucStaticallyAllocated = pdTRUE;
+#endif
+}
+
+BaseType_t Start(LightweightTimer_t *timer) {
+    return prvArmLightweightTimer(timer);
+}
+
+BaseType_t Reset(LightweightTimer_t *timer) {
+    return prvArmLightweightTimer(timer);
+}
+
+BaseType_t Stop(LightweightTimer_t *timer) {
+    Timer_t *const pxTimer = (Timer_t *)timer;
+    BaseType_t     xReturn = pdPASS;
+
+    if (prvIsTimerTask(tmrGET_METADATA(pxTimer)->pxDomain) != pdFALSE) {
+        if (tmrTIMER_IS_IN_A_LIST(pxTimer)) {
+            tmrREMOVE_TIMER(pxTimer);
+        }
+    } else {
+        xReturn = xTimerGenericCommand(pxTimer, tmrCOMMAND_STOP, 0U, NULL, tmrNO_DELAY);
+    }
+
+    return xReturn;
+}
+
+BaseType_t Delete(LightweightTimer_t *timer) {
+    Timer_t *const pxTimer = (Timer_t *)timer;
+    TimerDomain_t *const pxDomain = tmrGET_METADATA(pxTimer)->pxDomain;
+
+    /* The memory belongs to the owner of the timer, so deleting it is
+    stopping it - tmrCOMMAND_DELETE would try to free it. */
+    if (prvIsTimerTask(pxDomain) != pdFALSE) {
+        (void)Stop(timer);
+
+        /* Commands sent for the timer by other tasks that this task has not
+        received yet would otherwise run on the memory once it is reused. */
+        vQueueForEachWaitingItem(pxDomain->xTimerQueue, prvCancelQueuedCommand, (void *)pxTimer);
+        return pdPASS;
+    }
+
+    /* The stop must not be lost to a full queue, and the owner may free the
+    timer once this returns, so no command still queued may refer to it. */
+    if (pxDomain->xTimerTaskHandle == NULL) {
+        return pdFAIL;
+    }
+    if (xTimerGenericCommand(pxTimer, tmrCOMMAND_STOP, 0U, NULL, portMAX_DELAY) == pdFAIL) {
+        return pdFAIL;
+    }
+
+    return prvWaitForTimerTask(pxDomain);
+}
+
+#endif /* configUSE_TIMER_POOL */
+
+static void prvSwitchTimerLists(TimerDomain_t *const pxDomain, const TickType_t xTimeNow) {
     TickType_t xNextExpireTime, xReloadTime;
-    List_t *   pxTemp;
+    TimerList_t *pxTemp;
     Timer_t *  pxTimer;
     BaseType_t xResult;
 
@@ -627,34 +2565,45 @@ static void prvSwitchTimerLists(void) {
     If there are any timers still referenced from the current timer list
     then they must have expired and should be processed before the lists
     are switched. */
-    while (listLIST_IS_EMPTY(pxCurrentTimerList) == pdFALSE) {
-        xNextExpireTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY(pxCurrentTimerList);
+    while (tmrLIST_IS_EMPTY(pxDomain->pxCurrentTimerList) == pdFALSE) {
+        xNextExpireTime = tmrGET_ITEM_VALUE_OF_HEAD_ENTRY(pxDomain->pxCurrentTimerList);
 
         /* Remove the timer from the list. */
-        pxTimer = (Timer_t *)listGET_OWNER_OF_HEAD_ENTRY(pxCurrentTimerList);
-        (void)uxListRemove(&(pxTimer->xTimerListItem));
+        pxTimer = tmrGET_OWNER_OF_HEAD_ENTRY(pxDomain->pxCurrentTimerList);
+        tmrREMOVE_TIMER(pxTimer);
         traceTIMER_EXPIRED(pxTimer);
+        tmrPROBE_TIMER_EXPIRED(pxTimer, xNextExpireTime, xTimeNow - xNextExpireTime);
+        tmrSTATS_EXPIRED(pxDomain);
+
+        /* The catch-up policy of the timer moves the reload time past the
+        periods it skips, which xTimeNow puts after the overflow, so a skipping
+        timer fires once here however far behind it is.  Worked out before the
+        callback, which may read uxTimerGetMissedPeriods(). */
+        if (pxTimer->ucAutoReload == (uint8_t)pdTRUE) {
+            xReloadTime = prvCatchUpMissedPeriods(pxTimer, xNextExpireTime, xTimeNow);
+        } else {
+            xReloadTime = xNextExpireTime;
+        }
 
         /* Execute its callback, then send a command to restart the timer if
         it is an auto-reload timer.  It cannot be restarted here as the lists
         have not yet been switched. */
-        pxTimer->pxCallbackFunction((TimerHandle_t)pxTimer);
+        prvCallTimerCallback(pxDomain, pxTimer);
 
-        if (pxTimer->uxAutoReload == (UBaseType_t)pdTRUE) {
+        if (pxTimer->ucAutoReload == (uint8_t)pdTRUE) {
             /* Calculate the reload value, and if the reload value results in
             the timer going into the same timer list then it has already expired
             and the timer should be re-inserted into the current list so it is
             processed again within this loop.  Otherwise a command should be sent
             to restart the timer to ensure it is only inserted into a list after
             the lists have been swapped. */
-            xReloadTime = (xNextExpireTime + pxTimer->xTimerPeriodInTicks);
-            if (xReloadTime > xNextExpireTime) {
-                listSET_LIST_ITEM_VALUE(&(pxTimer->xTimerListItem), xReloadTime);
-                listSET_LIST_ITEM_OWNER(&(pxTimer->xTimerListItem), pxTimer);
-                vListInsert(pxCurrentTimerList, &(pxTimer->xTimerListItem));
+            if ((xReloadTime >= xNextExpireTime) &&
+                ((TickType_t)(xReloadTime + pxTimer->xTimerPeriodInTicks) > xReloadTime)) {
+                tmrSET_TIMER_ITEM_VALUE(pxTimer, xReloadTime + pxTimer->xTimerPeriodInTicks);
+                tmrINSERT_TIMER_AND_COUNT(pxDomain, pxDomain->pxCurrentTimerList, pxTimer);
             } else {
                 xResult = xTimerGenericCommand(pxTimer, tmrCOMMAND_START_DONT_TRACE,
-                                               xNextExpireTime, NULL, tmrNO_DELAY);
+                                               xReloadTime, NULL, tmrNO_DELAY);
                 configASSERT(xResult);
                 (void)xResult;
             }
@@ -663,22 +2612,43 @@ static void prvSwitchTimerLists(void) {
         }
     }
 
-    pxTemp              = pxCurrentTimerList;
-    pxCurrentTimerList  = pxOverflowTimerList;
-    pxOverflowTimerList = pxTemp;
+#if (configUSE_TIMER_BATCH_CALLBACKS == 1)
+    prvFlushBatchCallbacks(pxDomain);
+#endif
+
+    pxTemp              = pxDomain->pxCurrentTimerList;
+    pxDomain->pxCurrentTimerList  = pxDomain->pxOverflowTimerList;
+    pxDomain->pxOverflowTimerList = pxTemp;
+    tmrSTATS_LIST_SWITCH(pxDomain);
 }
 
-static void prvCheckForValidListAndQueue(void) {
+static void prvCheckForValidListAndQueue(TimerDomain_t *const pxDomain) {
     /* Check that the list from which active timers are referenced, and the
     queue used to communicate with the timer service, have been
     initialised. */
     //taskENTER_CRITICAL();
     {
-        if (xTimerQueue == NULL) {
-            vListInitialise(&xActiveTimerList1);
-            vListInitialise(&xActiveTimerList2);
-            pxCurrentTimerList  = &xActiveTimerList1;
-            pxOverflowTimerList = &xActiveTimerList2;
+        if (pxDomain->xTimerQueue == NULL) {
+            if (pxDomain == tmrDEFAULT_DOMAIN) {
+                /* The default domain runs on the kernel tick.  Other domains
+                are set up by xTimerDomainCreate(). */
+                pxDomain->pcDomainName  = "Tmr Svc";
+                pxDomain->ulTickRateHz  = (uint32_t)configTICK_RATE_HZ;
+                pxDomain->uxQueueLength = (UBaseType_t)configTIMER_QUEUE_LENGTH;
+                pxDomain->pxTickSource  = pxTaskGetTickSource();
+            }
+#if (configUSE_HIGH_RES_TIMERS == 1)
+            pxDomain->pxHighResTimerList       = NULL;
+            pxDomain->ullNextHighResExpiryTime = queueNO_DEADLINE;
+#endif
+#if (configUSE_TIMER_POOL == 1)
+            pxDomain->xActiveTimerList1 = (ListIndex_t)(2U * (pxDomain - xTimerDomains));
+            pxDomain->xActiveTimerList2 = (ListIndex_t)((2U * (pxDomain - xTimerDomains)) + 1U);
+#endif
+            tmrLIST_INITIALISE(&pxDomain->xActiveTimerList1);
+            tmrLIST_INITIALISE(&pxDomain->xActiveTimerList2);
+            pxDomain->pxCurrentTimerList  = &pxDomain->xActiveTimerList1;
+            pxDomain->pxOverflowTimerList = &pxDomain->xActiveTimerList2;
 
 //#if (configSUPPORT_STATIC_ALLOCATION == 1)
             //{
@@ -688,21 +2658,25 @@ static void prvCheckForValidListAndQueue(void) {
             //    static uint8_t       ucStaticTimerQueueStorage[configTIMER_QUEUE_LENGTH *
             //                                             sizeof(DaemonTaskMessage_t)];
 
-            //    xTimerQueue = xQueueCreateStatic(
+            //    pxDomain->xTimerQueue = xQueueCreateStatic(
             //        (UBaseType_t)configTIMER_QUEUE_LENGTH, sizeof(DaemonTaskMessage_t),
             //        &(ucStaticTimerQueueStorage[0]), &xStaticTimerQueue);
             //}
 //#else
             {
-                xTimerQueue = xQueueCreate((UBaseType_t)configTIMER_QUEUE_LENGTH,
-                                           sizeof(DaemonTaskMessage_t));
+                pxDomain->xTimerQueue = xQueueCreate(pxDomain->uxQueueLength,
+                                                     sizeof(DaemonTaskMessage_t));
             }
 //#endif
 
+            /* The timer service task of the domain waits on the queue, so the
+            tick source wakes it through the queue. */
+            pxDomain->pxTickSource->pvWakeQueue.store((void *)pxDomain->xTimerQueue);
+
 #if (configQUEUE_REGISTRY_SIZE > 0)
             {
-                if (xTimerQueue != NULL) {
-                    vQueueAddToRegistry(xTimerQueue, "TmrQ");
+                if (pxDomain->xTimerQueue != NULL) {
+                    vQueueAddToRegistry(pxDomain->xTimerQueue, pxDomain->pcDomainName);
                 } else {
                     mtCOVERAGE_TEST_MARKER();
                 }
@@ -714,3 +2688,743 @@ static void prvCheckForValidListAndQueue(void) {
     }
     //taskEXIT_CRITICAL();
 }
+
+#if (configUSE_TIMER_POOL == 1)
+
+static Timer_t *prvAllocateTimerFromPool(void) {
+    std::lock_guard<std::mutex> xLock(xTimerPoolMutex);
+
+    return prvTakeTimerFromPool();
+}
+
+static Timer_t *prvTakeTimerFromPool(void) {
+    ListIndex_t ulSlot = listINDEX_NONE;
+
+    if (ulFreeTimerSlots != listINDEX_NONE) {
+        ulSlot           = ulFreeTimerSlots;
+        ulFreeTimerSlots = xTimerListItems[ulSlot].ulNext;
+    } else if (ulNextUnusedTimerSlot < (tmrPOOL_LIST_END_SLOTS + configTIMER_POOL_SIZE)) {
+        ulSlot = ulNextUnusedTimerSlot++;
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return (ulSlot != listINDEX_NONE) ? tmrTIMER_IN_SLOT(ulSlot) : NULL;
+}
+
+static void prvReturnTimerToPool(Timer_t *const pxTimer) {
+    std::lock_guard<std::mutex> xLock(xTimerPoolMutex);
+
+    prvPutTimerInPool(pxTimer);
+}
+
+static void prvPutTimerInPool(Timer_t *const pxTimer) {
+    const ListIndex_t ulSlot = tmrTIMER_SLOT(pxTimer);
+
+    /* The timer has already been removed from the active list, so its list
+    item is free to hold the link to the next free slot. */
+    xTimerListItems[ulSlot].ulNext = ulFreeTimerSlots;
+    ulFreeTimerSlots               = ulSlot;
+}
+
+#endif /* configUSE_TIMER_POOL */
+
+#if (configUSE_TIMER_SNAPSHOT == 1)
+
+#if (INCLUDE_xTimerPendFunctionCall == 0)
+    #error configUSE_TIMER_SNAPSHOT needs INCLUDE_xTimerPendFunctionCall to save from other tasks
+#endif
+
+#define tmrSNAPSHOT_MAGIC ((uint32_t)0x544D5253UL) /* "SRMT" */
+#define tmrSNAPSHOT_VERSION ((uint16_t)1U)
+
+/* The header of a snapshot file.  ulMagic is written after the records, so a
+snapshot cut short by a crash is never restored. */
+typedef struct tmrSnapshotHeader {
+    uint32_t ulMagic;
+    uint16_t usVersion;
+    uint16_t usRecordSize; /*<< Rejects snapshots from builds with a different TickType_t. */
+    uint32_t ulTickRateHz;
+    uint32_t ulNumberOfRecords;
+} TimerSnapshotHeader_t;
+
+/* One active timer.  The records are in expiry order. */
+typedef struct tmrSnapshotRecord {
+    uint64_t   ullTimerID;
+    TickType_t xTicksToExpiry;
+    TickType_t xTimerPeriodInTicks;
+    uint16_t   usCallbackIndex;
+    uint8_t    ucAutoReload;
+    uint8_t    ucCatchUpPolicyAndPriority; /*<< The policy in the low four bits. */
+    char       cTimerName[configMAX_TIMER_NAME_LEN];
+} TimerSnapshotRecord_t;
+
+/* A save handed to the timer service task by xTimerSnapshotSave(). */
+typedef struct tmrSnapshotSaveRequest {
+    const TimerSnapshotParameters_t *pxParameters;
+    BaseType_t xResult;
+    BaseType_t xComplete;
+    std::mutex xMutex;
+    std::condition_variable xCompleted;
+} SnapshotSaveRequest_t;
+
+static UBaseType_t prvFindSnapshotCallback(const TimerSnapshotParameters_t *const pxParameters,
+                                           const TimerCallbackFunction_t pxCallbackFunction) {
+    UBaseType_t ux;
+
+    for (ux = 0; ux < pxParameters->uxNumberOfCallbacks; ux++) {
+        if (pxParameters->pxCallbacks[ux] == pxCallbackFunction) {
+            break;
+        }
+    }
+
+    /* uxNumberOfCallbacks if it is not in the table. */
+    return ux;
+}
+
+/* Calls pxFunction for each timer in the active lists of the domain, soonest
+expiry first, with the ticks left until it expires. */
+template <typename Function_t>
+static void prvForEachActiveTimer(TimerDomain_t *const pxDomain, const TickType_t xTimeNow, Function_t pxFunction) {
+    TimerList_t *const pxLists[2] = {pxDomain->pxCurrentTimerList, pxDomain->pxOverflowTimerList};
+    Timer_t *pxTimer;
+    TickType_t xExpiryTime;
+
+    for (TimerList_t *const pxList : pxLists) {
+        pxTimer = (tmrLIST_IS_EMPTY(pxList) == pdFALSE) ? tmrGET_OWNER_OF_HEAD_ENTRY(pxList) : NULL;
+
+        while (pxTimer != NULL) {
+            xExpiryTime = tmrGET_TIMER_ITEM_VALUE(pxTimer);
+
+            /* A timer in the current list that is already due has not been
+            processed yet, so expires straight away. */
+            if ((pxList == pxDomain->pxCurrentTimerList) && (xExpiryTime <= xTimeNow)) {
+                pxFunction(pxTimer, (TickType_t)0U);
+            } else {
+                pxFunction(pxTimer, (TickType_t)(xExpiryTime - xTimeNow));
+            }
+
+            pxTimer = tmrGET_NEXT_TIMER(pxList, pxTimer);
+        }
+    }
+}
+
+static BaseType_t prvSaveSnapshot(const TimerSnapshotParameters_t *const pxParameters) {
+    TimerDomain_t *const pxDomain = tmrDEFAULT_DOMAIN;
+    const TickType_t xTimeNow = xTickSourceGetCount(pxDomain->pxTickSource);
+    TimerSnapshotHeader_t *pxHeader;
+    TimerSnapshotRecord_t *pxRecord;
+    uint32_t ulNumberOfRecords = 0U;
+    size_t xSize;
+
+    prvForEachActiveTimer(pxDomain, xTimeNow, [pxParameters, &ulNumberOfRecords](Timer_t *pxTimer, TickType_t) {
+        if (prvFindSnapshotCallback(pxParameters, tmrGET_METADATA(pxTimer)->pxCallbackFunction) < pxParameters->uxNumberOfCallbacks) {
+            ulNumberOfRecords++;
+        }
+    });
+
+    xSize = sizeof(TimerSnapshotHeader_t) + ((size_t)ulNumberOfRecords * sizeof(TimerSnapshotRecord_t));
+    pxHeader = (TimerSnapshotHeader_t *)pvPortMapFile(pxParameters->pcFileName, xSize, NULL);
+    if (pxHeader == NULL) {
+        return pdFAIL;
+    }
+
+    pxRecord = (TimerSnapshotRecord_t *)(pxHeader + 1);
+    prvForEachActiveTimer(pxDomain, xTimeNow, [pxParameters, &pxRecord](Timer_t *pxTimer, TickType_t xTicksToExpiry) {
+        const UBaseType_t uxCallbackIndex = prvFindSnapshotCallback(pxParameters, tmrGET_METADATA(pxTimer)->pxCallbackFunction);
+        const char *const pcTimerName = tmrGET_METADATA(pxTimer)->pcTimerName;
+
+        if (uxCallbackIndex < pxParameters->uxNumberOfCallbacks) {
+            pxRecord->ullTimerID                 = (uint64_t)(uintptr_t)tmrGET_METADATA(pxTimer)->pvTimerID;
+            pxRecord->xTicksToExpiry             = xTicksToExpiry;
+            pxRecord->xTimerPeriodInTicks        = pxTimer->xTimerPeriodInTicks;
+            pxRecord->usCallbackIndex            = (uint16_t)uxCallbackIndex;
+            pxRecord->ucAutoReload               = pxTimer->ucAutoReload;
+            pxRecord->ucCatchUpPolicyAndPriority = (uint8_t)(pxTimer->ucCatchUpPolicy | (pxTimer->ucPriority << 4));
+            memset(pxRecord->cTimerName, 0, sizeof(pxRecord->cTimerName));
+            if (pcTimerName != NULL) {
+                strncpy(pxRecord->cTimerName, pcTimerName, sizeof(pxRecord->cTimerName) - 1U);
+            }
+            pxRecord++;
+        }
+    });
+
+    pxHeader->usVersion         = tmrSNAPSHOT_VERSION;
+    pxHeader->usRecordSize      = (uint16_t)sizeof(TimerSnapshotRecord_t);
+    pxHeader->ulTickRateHz      = pxDomain->ulTickRateHz;
+    pxHeader->ulNumberOfRecords = ulNumberOfRecords;
+    std::atomic_thread_fence(std::memory_order_release);
+    pxHeader->ulMagic = tmrSNAPSHOT_MAGIC;
+
+    vPortUnmapFile(pxHeader, xSize);
+    return pdPASS;
+}
+
+static void prvSaveSnapshotOnTimerTask(void *pvRequest, uint32_t ulUnused) {
+    SnapshotSaveRequest_t *const pxRequest = (SnapshotSaveRequest_t *)pvRequest;
+    const BaseType_t xResult = prvSaveSnapshot(pxRequest->pxParameters);
+
+    (void)ulUnused;
+
+    {
+        std::lock_guard<std::mutex> xLock(pxRequest->xMutex);
+        pxRequest->xResult   = xResult;
+        pxRequest->xComplete = pdTRUE;
+    }
+    pxRequest->xCompleted.notify_all();
+}
+
+BaseType_t xTimerSnapshotSave(const TimerSnapshotParameters_t *const pxParameters) {
+    TimerDomain_t *const pxDomain = tmrDEFAULT_DOMAIN;
+    SnapshotSaveRequest_t xRequest;
+
+    configASSERT(pxParameters);
+
+    if ((pxDomain->xTimerTaskHandle == NULL) || (std::this_thread::get_id() == pxDomain->xTimerTaskId)) {
+        /* Nothing else is changing the lists. */
+        prvCheckForValidListAndQueue(pxDomain);
+        return prvSaveSnapshot(pxParameters);
+    }
+
+    xRequest.pxParameters = pxParameters;
+    xRequest.xResult      = pdFAIL;
+    xRequest.xComplete    = pdFALSE;
+
+    if (xTimerPendFunctionCall(prvSaveSnapshotOnTimerTask, &xRequest, 0U, portMAX_DELAY) == pdFAIL) {
+        return pdFAIL;
+    }
+
+    std::unique_lock<std::mutex> xLock(xRequest.xMutex);
+    xRequest.xCompleted.wait(xLock, [&xRequest] { return xRequest.xComplete != pdFALSE; });
+
+    return xRequest.xResult;
+}
+
+BaseType_t xTimerSnapshotRestore(const TimerSnapshotParameters_t *const pxParameters,
+                                 UBaseType_t *const puxRestored) {
+    TimerDomain_t *const pxDomain = tmrDEFAULT_DOMAIN;
+    const TimerSnapshotHeader_t *pxHeader;
+    const TimerSnapshotRecord_t *pxRecords;
+    const TimerSnapshotRecord_t *pxRecord;
+    TimerHandle_t xTimer;
+    Timer_t *pxTimer;
+    char *pcNames;
+    TickType_t xTimeNow;
+    TickType_t xPeriod;
+    TickType_t xTicksToExpiry;
+    TickType_t xExpiryTime;
+    UBaseType_t uxRestored = 0U;
+    uint32_t ulRecord;
+    size_t xSize = 0U;
+    BaseType_t xReturn = pdPASS;
+
+    configASSERT(pxParameters);
+
+    if (puxRestored != NULL) {
+        *puxRestored = 0U;
+    }
+
+    /* The active lists are written directly, as by xTimerCreateStaticTable(). */
+    configASSERT(pxDomain->xTimerTaskHandle == NULL);
+    if (pxDomain->xTimerTaskHandle != NULL) {
+        return pdFAIL;
+    }
+
+    pxHeader = (const TimerSnapshotHeader_t *)pvPortMapFile(pxParameters->pcFileName, 0U, &xSize);
+    if (pxHeader == NULL) {
+        return pdFAIL;
+    }
+
+    if ((xSize < sizeof(TimerSnapshotHeader_t)) || (pxHeader->ulMagic != tmrSNAPSHOT_MAGIC) ||
+        (pxHeader->usVersion != tmrSNAPSHOT_VERSION) ||
+        (pxHeader->usRecordSize != (uint16_t)sizeof(TimerSnapshotRecord_t)) ||
+        (pxHeader->ulTickRateHz == 0U) ||
+        (((xSize - sizeof(TimerSnapshotHeader_t)) / sizeof(TimerSnapshotRecord_t)) < pxHeader->ulNumberOfRecords)) {
+        vPortUnmapFile((void *)pxHeader, xSize);
+        return pdFAIL;
+    }
+
+    pxRecords = (const TimerSnapshotRecord_t *)(pxHeader + 1);
+
+    /* The names are copied out of the mapping, which is not kept, into one
+    block that lives as long as the process, like the string literals timers
+    are normally named with. */
+    pcNames = new (std::nothrow) char[(size_t)pxHeader->ulNumberOfRecords * configMAX_TIMER_NAME_LEN];
+    if ((pcNames == NULL) && (pxHeader->ulNumberOfRecords > 0U)) {
+        vPortUnmapFile((void *)pxHeader, xSize);
+        return pdFAIL;
+    }
+
+    prvCheckForValidListAndQueue(pxDomain);
+    xTimeNow = xTickSourceGetCount(pxDomain->pxTickSource);
+
+    for (ulRecord = 0U; ulRecord < pxHeader->ulNumberOfRecords; ulRecord++) {
+        pxRecord = &(pxRecords[ulRecord]);
+
+        if (pxRecord->usCallbackIndex >= pxParameters->uxNumberOfCallbacks) {
+            continue;
+        }
+
+        xPeriod        = pxRecord->xTimerPeriodInTicks;
+        xTicksToExpiry = pxRecord->xTicksToExpiry;
+        if (pxHeader->ulTickRateHz != pxDomain->ulTickRateHz) {
+            xPeriod = (TickType_t)(((uint64_t)xPeriod * pxDomain->ulTickRateHz) / pxHeader->ulTickRateHz);
+            xTicksToExpiry =
+                (TickType_t)(((uint64_t)xTicksToExpiry * pxDomain->ulTickRateHz) / pxHeader->ulTickRateHz);
+        }
+
+        if (xPeriod == (TickType_t)0U) {
+            xPeriod = (TickType_t)1U;
+        }
+
+        /* An expiry time of now would be taken as a full period late. */
+        if (xTicksToExpiry == (TickType_t)0U) {
+            xTicksToExpiry = (TickType_t)1U;
+        }
+
+        memcpy(&(pcNames[ulRecord * configMAX_TIMER_NAME_LEN]), pxRecord->cTimerName,
+               configMAX_TIMER_NAME_LEN);
+        pcNames[((ulRecord + 1U) * configMAX_TIMER_NAME_LEN) - 1U] = '\0';
+
+        xTimer = xTimerCreate(&(pcNames[ulRecord * configMAX_TIMER_NAME_LEN]), xPeriod,
+                              pxRecord->ucAutoReload, (void *)(uintptr_t)pxRecord->ullTimerID,
+                              pxParameters->pxCallbacks[pxRecord->usCallbackIndex]);
+        if (xTimer == NULL) {
+            xReturn = pdFAIL;
+            break;
+        }
+
+        pxTimer                  = (Timer_t *)xTimer;
+        pxTimer->ucCatchUpPolicy = (uint8_t)(pxRecord->ucCatchUpPolicyAndPriority & 0x0FU);
+        pxTimer->ucPriority      = (uint8_t)(pxRecord->ucCatchUpPolicyAndPriority >> 4);
+
+        xExpiryTime = xTimeNow + xTicksToExpiry;
+        tmrSET_TIMER_ITEM_VALUE(pxTimer, xExpiryTime);
+        /* The records are in expiry order, so timers that expire on the
+        same tick stay in the order they were in. */
+        prvAppendTimer((xExpiryTime > xTimeNow) ? pxDomain->pxCurrentTimerList
+                                                : pxDomain->pxOverflowTimerList,
+                       pxTimer);
+        uxRestored++;
+
+        if (pxParameters->pxRestoredTimer != NULL) {
+            pxParameters->pxRestoredTimer(xTimer);
+        }
+    }
+
+    vPortUnmapFile((void *)pxHeader, xSize);
+
+    if (puxRestored != NULL) {
+        *puxRestored = uxRestored;
+    }
+
+    return xReturn;
+}
+
+#endif /* configUSE_TIMER_SNAPSHOT */
+
+uint64_t ullTimerGetMonotonicTime(void) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+
+static UBaseType_t prvHistogramBucket(const uint64_t ullValue) {
+    UBaseType_t uxExponent = 0U;
+    UBaseType_t uxShift;
+
+    if (ullValue < (uint64_t)tmrHISTOGRAM_SUB_BUCKETS) {
+        return (UBaseType_t)ullValue;
+    }
+
+    /* Find the highest set bit. */
+    for (uxShift = 32U; uxShift != 0U; uxShift >>= 1) {
+        if ((ullValue >> (uxExponent + uxShift)) != 0U) {
+            uxExponent += uxShift;
+        }
+    }
+
+    return ((uxExponent - tmrHISTOGRAM_SUB_BUCKET_BITS + 1U) << tmrHISTOGRAM_SUB_BUCKET_BITS) +
+           (UBaseType_t)((ullValue >> (uxExponent - tmrHISTOGRAM_SUB_BUCKET_BITS)) &
+                         (tmrHISTOGRAM_SUB_BUCKETS - 1U));
+}
+
+uint64_t ullTimerGetHistogramBucketValue(const UBaseType_t uxBucket) {
+    configASSERT(uxBucket < tmrHISTOGRAM_BUCKETS);
+
+    if (uxBucket < (UBaseType_t)tmrHISTOGRAM_SUB_BUCKETS) {
+        return (uint64_t)uxBucket;
+    }
+
+    return (uint64_t)(tmrHISTOGRAM_SUB_BUCKETS + (uxBucket & (tmrHISTOGRAM_SUB_BUCKETS - 1U)))
+           << ((uxBucket >> tmrHISTOGRAM_SUB_BUCKET_BITS) - 1U);
+}
+
+static void prvRecordInHistogram(const UBaseType_t uxHistogram, const UBaseType_t uxClass,
+                                 const uint64_t ullValue) {
+    xHistograms[uxHistogram][uxClass].ulCounts[prvHistogramBucket(ullValue)].fetch_add(
+        1U, std::memory_order_relaxed);
+}
+
+static void prvRecordExpiryLateness(const TimerDomain_t *const pxDomain, const Timer_t *const pxTimer,
+                                    const TickType_t xExpiredTime, const TickType_t xTimeNow) {
+    const uint64_t ullLastTickTime = pxDomain->pxTickSource->ullLastTickTime.load(std::memory_order_relaxed);
+    uint64_t ullLateness = 0U;
+
+    if (ullLastTickTime != 0U) {
+        ullLateness = ullTimerGetMonotonicTime() - ullLastTickTime;
+
+        if (pxDomain->ulTickRateHz != 0U) {
+            /* Add the whole ticks that passed after the timer fell due. */
+            ullLateness += ((uint64_t)(TickType_t)(xTimeNow - xExpiredTime) * 1000000000ULL) /
+                           pxDomain->ulTickRateHz;
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    } else {
+        /* Not ticked yet, so a timer with a period of 0 ticks. */
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    prvRecordInHistogram(tmrHISTOGRAM_EXPIRY_LATENESS, (UBaseType_t)pxTimer->ucPriority, ullLateness);
+}
+
+/*
+ * Sum bucket uxBucket of a histogram over the classes selected by uxClass.
+ */
+static uint64_t prvGetHistogramBucketCount(const UBaseType_t uxHistogram, const UBaseType_t uxClass,
+                                           const UBaseType_t uxBucket) {
+    uint64_t ullCount = 0U;
+    UBaseType_t ux;
+
+    if (uxClass == tmrHISTOGRAM_ALL_CLASSES) {
+        for (ux = 0U; ux < tmrHISTOGRAM_CLASSES; ux++) {
+            ullCount += xHistograms[uxHistogram][ux].ulCounts[uxBucket].load(std::memory_order_relaxed);
+        }
+    } else {
+        ullCount = xHistograms[uxHistogram][uxClass].ulCounts[uxBucket].load(std::memory_order_relaxed);
+    }
+
+    return ullCount;
+}
+
+uint64_t ullTimerGetHistogramCount(const UBaseType_t uxHistogram, const UBaseType_t uxClass) {
+    uint64_t ullCount = 0U;
+    UBaseType_t uxBucket;
+
+    configASSERT(uxHistogram < tmrHISTOGRAMS);
+    configASSERT((uxClass < tmrHISTOGRAM_CLASSES) || (uxClass == tmrHISTOGRAM_ALL_CLASSES));
+
+    for (uxBucket = 0U; uxBucket < tmrHISTOGRAM_BUCKETS; uxBucket++) {
+        ullCount += prvGetHistogramBucketCount(uxHistogram, uxClass, uxBucket);
+    }
+
+    return ullCount;
+}
+
+uint64_t ullTimerGetHistogramPercentile(const UBaseType_t uxHistogram, const UBaseType_t uxClass,
+                                        const uint32_t ulPartsPerMillion) {
+    uint64_t ullCounts[tmrHISTOGRAM_BUCKETS];
+    uint64_t ullTotal = 0U;
+    uint64_t ullRank;
+    uint64_t ullSeen = 0U;
+    UBaseType_t uxBucket;
+
+    configASSERT(uxHistogram < tmrHISTOGRAMS);
+    configASSERT((uxClass < tmrHISTOGRAM_CLASSES) || (uxClass == tmrHISTOGRAM_ALL_CLASSES));
+    configASSERT(ulPartsPerMillion <= 1000000UL);
+
+    /* Take one copy so the rank and the walk agree while values are still
+    being recorded. */
+    for (uxBucket = 0U; uxBucket < tmrHISTOGRAM_BUCKETS; uxBucket++) {
+        ullCounts[uxBucket] = prvGetHistogramBucketCount(uxHistogram, uxClass, uxBucket);
+        ullTotal += ullCounts[uxBucket];
+    }
+
+    if (ullTotal == 0U) {
+        return 0U;
+    }
+
+    /* The rank of the value wanted, counting from 1. */
+    ullRank = ((ullTotal * ulPartsPerMillion) + 999999U) / 1000000U;
+    if (ullRank == 0U) {
+        ullRank = 1U;
+    }
+
+    for (uxBucket = 0U; uxBucket < (tmrHISTOGRAM_BUCKETS - 1U); uxBucket++) {
+        ullSeen += ullCounts[uxBucket];
+        if (ullSeen >= ullRank) {
+            break;
+        }
+    }
+
+    return (uxBucket < (tmrHISTOGRAM_BUCKETS - 1U)) ? (ullTimerGetHistogramBucketValue(uxBucket + 1U) - 1U)
+                                                      : UINT64_MAX;
+}
+
+UBaseType_t uxTimerGetHistogramBuckets(const UBaseType_t uxHistogram, const UBaseType_t uxClass,
+                                       uint32_t *const pulCounts) {
+    UBaseType_t uxUsed = 0U;
+    UBaseType_t uxBucket;
+    uint64_t ullCount;
+
+    configASSERT(uxHistogram < tmrHISTOGRAMS);
+    configASSERT((uxClass < tmrHISTOGRAM_CLASSES) || (uxClass == tmrHISTOGRAM_ALL_CLASSES));
+    configASSERT(pulCounts);
+
+    for (uxBucket = 0U; uxBucket < tmrHISTOGRAM_BUCKETS; uxBucket++) {
+        ullCount = prvGetHistogramBucketCount(uxHistogram, uxClass, uxBucket);
+        pulCounts[uxBucket] = (ullCount > UINT32_MAX) ? UINT32_MAX : (uint32_t)ullCount;
+
+        if (ullCount != 0U) {
+            uxUsed = uxBucket + 1U;
+        }
+    }
+
+    return uxUsed;
+}
+
+void vTimerResetHistograms(void) {
+    UBaseType_t uxHistogram, uxClass, uxBucket;
+
+    for (uxHistogram = 0U; uxHistogram < tmrHISTOGRAMS; uxHistogram++) {
+        for (uxClass = 0U; uxClass < tmrHISTOGRAM_CLASSES; uxClass++) {
+            for (uxBucket = 0U; uxBucket < tmrHISTOGRAM_BUCKETS; uxBucket++) {
+                xHistograms[uxHistogram][uxClass].ulCounts[uxBucket].store(0U, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+#endif /* configUSE_TIMER_HISTOGRAMS */
+
+#if (configUSE_HIGH_RES_TIMERS == 1)
+
+HighResTimerHandle_t xHighResTimerCreate(const char *const pcTimerName, const uint64_t ullPeriod,
+                                         const UBaseType_t uxAutoReload, void *const pvTimerID,
+                                         HighResTimerCallbackFunction_t pxCallbackFunction) {
+    HighResTimer_t *pxNewTimer;
+
+    /* 0 is not a valid period. */
+    configASSERT(ullPeriod > 0U);
+
+    pxNewTimer = new (std::nothrow) HighResTimer_t;
+
+    if (pxNewTimer != NULL) {
+        prvCheckForValidListAndQueue(tmrDEFAULT_DOMAIN);
+
+        pxNewTimer->ullExpiryTime      = 0U;
+        pxNewTimer->ullPeriod          = ullPeriod;
+        pxNewTimer->pxNext             = NULL;
+        pxNewTimer->pxPrevious         = NULL;
+        pxNewTimer->pxCallbackFunction = pxCallbackFunction;
+        pxNewTimer->ucAutoReload       = (uint8_t)uxAutoReload;
+        pxNewTimer->ucIsActive         = (uint8_t)pdFALSE;
+        pxNewTimer->pcTimerName        = pcTimerName;
+        pxNewTimer->pvTimerID          = pvTimerID;
+    }
+
+    return pxNewTimer;
+}
+
+BaseType_t xHighResTimerGenericCommand(HighResTimerHandle_t xTimer, const BaseType_t xCommandID,
+                                       const uint64_t ullOptionalValue,
+                                       const TickType_t xTicksToWait) {
+    BaseType_t xReturn = pdFAIL;
+    DaemonTaskMessage_t xMessage;
+    TimerDomain_t *const pxDomain = tmrDEFAULT_DOMAIN;
+
+    configASSERT(xTimer);
+    configASSERT(xCommandID >= tmrFIRST_HIGH_RES_COMMAND);
+
+    if (pxDomain->xTimerQueue != NULL) {
+        xMessage.xMessageID                              = xCommandID;
+        xMessage.u.xHighResTimerParameters.ullMessageValue = ullOptionalValue;
+        xMessage.u.xHighResTimerParameters.pxTimer         = (HighResTimer_t *)xTimer;
+
+        xReturn = xQueueSendToBack(pxDomain->xTimerQueue, &xMessage,
+                                   (pxDomain->xTimerTaskHandle != NULL) ? xTicksToWait : tmrNO_DELAY);
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return xReturn;
+}
+
+void *pvHighResTimerGetTimerID(const HighResTimerHandle_t xTimer) {
+    configASSERT(xTimer);
+    return ((HighResTimer_t *)xTimer)->pvTimerID;
+}
+
+static void prvInsertHighResTimer(TimerDomain_t *const pxDomain, HighResTimer_t *const pxTimer) {
+    HighResTimer_t *pxPrevious = NULL;
+    HighResTimer_t *pxNext     = pxDomain->pxHighResTimerList;
+
+    /* Timers with the same expiry time stay in the order they were
+    inserted. */
+    while ((pxNext != NULL) && (pxNext->ullExpiryTime <= pxTimer->ullExpiryTime)) {
+        pxPrevious = pxNext;
+        pxNext     = pxNext->pxNext;
+    }
+
+    pxTimer->pxPrevious = pxPrevious;
+    pxTimer->pxNext     = pxNext;
+    if (pxNext != NULL) {
+        pxNext->pxPrevious = pxTimer;
+    }
+    if (pxPrevious != NULL) {
+        pxPrevious->pxNext = pxTimer;
+    } else {
+        pxDomain->pxHighResTimerList = pxTimer;
+    }
+    pxTimer->ucIsActive = (uint8_t)pdTRUE;
+}
+
+static void prvRemoveHighResTimer(TimerDomain_t *const pxDomain, HighResTimer_t *const pxTimer) {
+    if (pxTimer->ucIsActive == (uint8_t)pdFALSE) {
+        return;
+    }
+
+    if (pxTimer->pxNext != NULL) {
+        pxTimer->pxNext->pxPrevious = pxTimer->pxPrevious;
+    }
+    if (pxTimer->pxPrevious != NULL) {
+        pxTimer->pxPrevious->pxNext = pxTimer->pxNext;
+    } else {
+        pxDomain->pxHighResTimerList = pxTimer->pxNext;
+    }
+    pxTimer->pxNext     = NULL;
+    pxTimer->pxPrevious = NULL;
+    pxTimer->ucIsActive = (uint8_t)pdFALSE;
+}
+
+static uint64_t prvProcessExpiredHighResTimers(TimerDomain_t *const pxDomain) {
+    HighResTimer_t *pxTimer;
+    uint64_t ullTimeNow = ullTimerGetMonotonicTime();
+
+    while ((pxDomain->pxHighResTimerList != NULL) && (pxDomain->pxHighResTimerList->ullExpiryTime <= ullTimeNow)) {
+        pxTimer = pxDomain->pxHighResTimerList;
+        prvRemoveHighResTimer(pxDomain, pxTimer);
+
+        if (pxTimer->ucAutoReload == (uint8_t)pdTRUE) {
+            /* Stay in phase with the original start time.  Periods that
+            have already passed are skipped rather than fired in a burst. */
+            pxTimer->ullExpiryTime += pxTimer->ullPeriod;
+            if (pxTimer->ullExpiryTime <= ullTimeNow) {
+                pxTimer->ullExpiryTime +=
+                    (((ullTimeNow - pxTimer->ullExpiryTime) / pxTimer->ullPeriod) + 1U) *
+                    pxTimer->ullPeriod;
+            }
+            prvInsertHighResTimer(pxDomain, pxTimer);
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        tmrSTATS_EXPIRED(pxDomain);
+        traceTIMER_CALLBACK_ENTER(pxTimer);
+        tmrPROBE_CALLBACK_ENTRY(pxTimer);
+        pxTimer->pxCallbackFunction((HighResTimerHandle_t)pxTimer);
+        tmrPROBE_CALLBACK_RETURN(pxTimer);
+        traceTIMER_CALLBACK_EXIT(pxTimer);
+
+        /* The callback took time, look again. */
+        ullTimeNow = ullTimerGetMonotonicTime();
+    }
+
+    return (pxDomain->pxHighResTimerList != NULL) ? pxDomain->pxHighResTimerList->ullExpiryTime : queueNO_DEADLINE;
+}
+
+static void prvProcessHighResCommand(TimerDomain_t *const pxDomain,
+                                     const DaemonTaskMessage_t *const pxMessage) {
+    HighResTimer_t *const pxTimer = pxMessage->u.xHighResTimerParameters.pxTimer;
+    const uint64_t ullMessageValue = pxMessage->u.xHighResTimerParameters.ullMessageValue;
+
+    prvRemoveHighResTimer(pxDomain, pxTimer);
+
+    switch (pxMessage->xMessageID) {
+    case tmrCOMMAND_HIGH_RES_START:
+        /* Measured from when the command was sent, not when it arrived.  A
+        timer that is already due expires on the next pass of the timer
+        service task. */
+        pxTimer->ullExpiryTime = ullMessageValue + pxTimer->ullPeriod;
+        prvInsertHighResTimer(pxDomain, pxTimer);
+        break;
+
+    case tmrCOMMAND_HIGH_RES_STOP:
+        /* The timer has already been removed from the active list. */
+        break;
+
+    case tmrCOMMAND_HIGH_RES_CHANGE_PERIOD:
+        configASSERT(ullMessageValue > 0U);
+        pxTimer->ullPeriod     = ullMessageValue;
+        pxTimer->ullExpiryTime = ullTimerGetMonotonicTime() + ullMessageValue;
+        prvInsertHighResTimer(pxDomain, pxTimer);
+        break;
+
+    case tmrCOMMAND_HIGH_RES_DELETE:
+        delete pxTimer;
+        break;
+
+    default:
+        /* Don't expect to get here. */
+        break;
+    }
+}
+
+#endif /* configUSE_HIGH_RES_TIMERS */
+
+#if ((configUSE_TIMER_POOL == 0) && (configSUPPORT_DYNAMIC_ALLOCATION == 1))
+
+static Timer_t *prvAllocateTimer(const size_t xContextSize, TimerMetadata_t **ppxNewMetadata) {
+    /* The hot and cold parts of the timer are allocated separately so the
+    hot parts of neighbouring timers are not interleaved with metadata.  Any
+    context shares the allocation of the hot part, so it is usually in the
+    cache line the timer ends in or the one after. */
+    void *pvBlock = ::operator new(tmrCONTEXT_OFFSET + xContextSize, std::nothrow);
+    Timer_t *pxNewTimer = NULL;
+    TimerMetadata_t *pxNewMetadata = NULL;
+
+    if (pvBlock != NULL) {
+        pxNewTimer    = new (pvBlock) Timer_t;
+        pxNewMetadata = new (std::nothrow) TimerMetadata_t;
+
+        if (pxNewMetadata == NULL) {
+            ::operator delete(pxNewTimer);
+            pxNewTimer = NULL;
+        }
+    }
+
+    *ppxNewMetadata = pxNewMetadata;
+    return pxNewTimer;
+}
+
+static void prvFreeTimer(Timer_t *const pxTimer) {
+    TimerMetadata_t *const pxMetadata = pxTimer->pxMetadata;
+    TimerArray_t *const pxArray = pxMetadata->pxArray;
+
+    if (pxArray != NULL) {
+        /* Part of a block from xTimerCreateArray(), which goes when the last
+        of its timers does. */
+        pxMetadata->~TimerMetadata_t();
+        pxArray->uxTimersNotDeleted--;
+        if (pxArray->uxTimersNotDeleted == (UBaseType_t)0U) {
+            ::operator delete(pxArray);
+        }
+        return;
+    }
+
+    /* Only called by the timer service task once the timer has left the
+    active lists, so the callback cannot be using the context. */
+    if (pxMetadata->pxContextDestructor != NULL) {
+        pxMetadata->pxContextDestructor(pvTimerGetContext(pxTimer));
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    delete pxMetadata;
+    ::operator delete(pxTimer);
+}
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
@@ -3,12 +3,15 @@
 #define __TIMER_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 /* IDs for commands that can be sent/received on the timer queue.  These are to
 be used solely through the macros that make up the public software timer API,
 as defined below.  The commands that are sent from interrupts must use the
 highest numbers as tmrFIRST_FROM_ISR_COMMAND is used to determine if the task
 or interrupt version of the queue send function should be used. */
+#define tmrCOMMAND_CANCELLED ((BaseType_t)-4)
+#define tmrCOMMAND_FENCE ((BaseType_t)-3)
 #define tmrCOMMAND_EXECUTE_CALLBACK_FROM_ISR ((BaseType_t)-2)
 #define tmrCOMMAND_EXECUTE_CALLBACK ((BaseType_t)-1)
 #define tmrCOMMAND_START_DONT_TRACE ((BaseType_t)0)
@@ -24,6 +27,24 @@ or interrupt version of the queue send function should be used. */
 #define tmrCOMMAND_STOP_FROM_ISR				( ( BaseType_t ) 8 )
 #define tmrCOMMAND_CHANGE_PERIOD_FROM_ISR		( ( BaseType_t ) 9 )
 
+/* Commands for high resolution timers, which are never sent from interrupts
+and are sent with xHighResTimerGenericCommand(). */
+#define tmrFIRST_HIGH_RES_COMMAND ((BaseType_t)16)
+#define tmrCOMMAND_HIGH_RES_START ((BaseType_t)16)
+#define tmrCOMMAND_HIGH_RES_STOP ((BaseType_t)17)
+#define tmrCOMMAND_HIGH_RES_CHANGE_PERIOD ((BaseType_t)18)
+#define tmrCOMMAND_HIGH_RES_DELETE ((BaseType_t)19)
+
+/* What an auto-reload timer does when the timer service task has fallen more
+than one period behind it, see vTimerSetCatchUpPolicy(). */
+#define tmrCATCH_UP_FIRE_ALL ((UBaseType_t)0)
+#define tmrCATCH_UP_SKIP ((UBaseType_t)1)
+#define tmrCATCH_UP_SKIP_AND_COUNT ((UBaseType_t)2)
+
+/* Priority classes, see vTimerSetPriority(). */
+#define tmrPRIORITY_LOWEST ((UBaseType_t)0)
+#define tmrPRIORITY_HIGHEST ((UBaseType_t)15)
+
 typedef void* TimerHandle_t;
 
 /*
@@ -32,13 +53,25 @@ typedef void* TimerHandle_t;
  */
 typedef void (*PendedFunction_t)(void*, uint32_t);
 
-typedef void (*ExpireCallBack)(void);
+struct xLIGHTWEIGHT_TIMER;
 
-typedef  struct timer_s {
+typedef void (*ExpireCallBack)(struct xLIGHTWEIGHT_TIMER* timer);
+
+/*
+ * A lightweight one-shot timer that is embedded directly in the object that
+ * owns it, so it needs no allocation and no handle.  The callback receives the
+ * timer itself, from which the owning object can be found.  When Start(),
+ * Stop(), Reset() and Delete() are called from the timer service task (for
+ * example from a timer callback) the timer is linked into or out of the
+ * active timer list directly, otherwise a command is sent to the timer
+ * service task.  Not available when configUSE_TIMER_POOL is 1.
+ */
+typedef  struct xLIGHTWEIGHT_TIMER {
+	StaticTimer_t timer; /* Must be first, the timer service sees a LightweightTimer_t as a Timer_t. */
 	uint32_t tick_count;
 	ExpireCallBack callback;
 
-} timer_t;
+} LightweightTimer_t;
 
 /*
  * Defines the prototype to which timer callback functions must conform.
@@ -50,24 +83,486 @@ TimerHandle_t xTimerCreate(const char* const pcTimerName,
 	const UBaseType_t uxAutoReload,
 	void* const pvTimerID,
 	TimerCallbackFunction_t pxCallbackFunction);
+
+/*
+ * Create uxNumberOfTimers timers at once, timer ux taking its parameters from
+ * element ux of each array.  ppcTimerNames, puxAutoReloads and ppvTimerIDs may
+ * be NULL, giving every timer no name, no auto reload and a NULL ID.  All the
+ * timers are allocated in one block (or taken from the pool under a single
+ * lock) and initialised in one pass, and their handles are written to
+ * pxCreatedTimers.  Either every timer is created or none is.  The timers are
+ * deleted individually with xTimerDelete(); the block is freed with the last
+ * one.
+ */
+BaseType_t xTimerCreateArray(const UBaseType_t uxNumberOfTimers,
+	const char* const* const ppcTimerNames,
+	const TickType_t* const pxTimerPeriodsInTicks,
+	const UBaseType_t* const puxAutoReloads,
+	void* const* const ppvTimerIDs,
+	const TimerCallbackFunction_t* const pxCallbackFunctions,
+	TimerHandle_t* const pxCreatedTimers);
+
+/*
+ * Defines the prototype of the function that releases the context of a timer
+ * created by xTimerCreateWithContext().
+ */
+typedef void (*TimerContextDestructor_t)(void* pvContext);
+
+#if (configUSE_TIMER_POOL == 0)
+/*
+ * As xTimerCreate(), but xContextSize bytes of storage for the use of the
+ * callback are allocated in the same block as the timer, and a pointer to them
+ * is returned through ppvContext.  The storage is aligned for any type and
+ * pvTimerGetContext() finds it again from the handle without touching the
+ * timer metadata.  When the timer is deleted the timer service task calls
+ * pxContextDestructor, if it is not NULL, on the storage before freeing it.
+ * See timer_callable.h for the C++ interface built on this.
+ */
+TimerHandle_t xTimerCreateWithContext(const char* const pcTimerName,
+	const TickType_t xTimerPeriodInTicks,
+	const UBaseType_t uxAutoReload,
+	TimerCallbackFunction_t pxCallbackFunction,
+	const size_t xContextSize,
+	void** const ppvContext,
+	TimerContextDestructor_t pxContextDestructor);
+
+void* pvTimerGetContext(const TimerHandle_t xTimer);
+#endif
+
 TimerHandle_t xTimerCreateStatic(const char* const pcTimerName, const TickType_t xTimerPeriodInTicks,
 	const UBaseType_t uxAutoReload, void* const pvTimerID,
 	TimerCallbackFunction_t pxCallbackFunction,
 	StaticTimer_t* pxTimerBuffer);
 
+/*
+ * One entry of a table of timers that are known when the application is
+ * built, see xTimerCreateStaticTable() and timer_table.h.
+ */
+typedef struct xTIMER_DEFINITION {
+	const char* pcTimerName;
+	TickType_t xTimerPeriodInTicks;
+	UBaseType_t uxAutoReload;
+	void* pvTimerID;
+	TimerCallbackFunction_t pxCallbackFunction;
+	UBaseType_t uxAutoStart; /* pdTRUE to start the timer as it is created. */
+} TimerDefinition_t;
+
+/*
+ * Create uxNumberOfTimers timers from pxDefinitions into the matching elements
+ * of pxTimerBuffers, without allocating memory or sending commands to the
+ * timer service task.  The uxNumberToStart timers indexed by puxStartOrder,
+ * which must be in ascending period order, are linked straight into the
+ * active timer list.  Must be called before CreateTimerManageTask().  The
+ * handles are written to pxCreatedTimers if it is not NULL.
+ */
+BaseType_t xTimerCreateStaticTable(const TimerDefinition_t* const pxDefinitions,
+	const UBaseType_t uxNumberOfTimers,
+	const UBaseType_t* const puxStartOrder,
+	const UBaseType_t uxNumberToStart,
+	StaticTimer_t* const pxTimerBuffers,
+	TimerHandle_t* const pxCreatedTimers);
+
+/*
+ * Defines the prototype of the batch form of a timer callback function, which
+ * is given every timer using that callback that expired in one sweep of the
+ * timer service task.
+ */
+typedef void (*TimerBatchCallbackFunction_t)(TimerHandle_t const* pxTimers, size_t xNumberOfTimers);
+
+#if (configUSE_TIMER_BATCH_CALLBACKS == 1)
+/*
+ * From now on, timers whose callback is pxCallbackFunction are not called one
+ * at a time when they expire.  Instead the timer service task collects those
+ * that expire in the same sweep, up to configTIMER_BATCH_LENGTH at a time, and
+ * passes them to pxBatchCallbackFunction in one call once the sweep is done.
+ * Fails if configTIMER_BATCH_CALLBACKS functions are already registered, or if
+ * pxCallbackFunction is already registered with a different batch function.
+ */
+BaseType_t xTimerRegisterBatchCallback(TimerCallbackFunction_t pxCallbackFunction,
+	TimerBatchCallbackFunction_t pxBatchCallbackFunction);
+#endif
+
+/*
+ * Choose how an auto-reload timer catches up after the timer service task
+ * stalls for longer than its period.  tmrCATCH_UP_FIRE_ALL, the default, calls
+ * the callback once for every missed period, in a burst.  tmrCATCH_UP_SKIP
+ * calls it once and moves on to the next period that is still in the future,
+ * keeping the timer in phase.  tmrCATCH_UP_SKIP_AND_COUNT does the same and
+ * also records how many periods were skipped, which the callback reads with
+ * uxTimerGetMissedPeriods() (saturating at 65535).  Takes effect the next
+ * time the timer is reloaded.
+ */
+void vTimerSetCatchUpPolicy(TimerHandle_t xTimer, const UBaseType_t uxCatchUpPolicy);
+UBaseType_t uxTimerGetMissedPeriods(const TimerHandle_t xTimer);
+
+#if (configUSE_TIMER_PRIORITIES == 1)
+/*
+ * Set the priority class of a timer, from tmrPRIORITY_LOWEST (the default) to
+ * tmrPRIORITY_HIGHEST.  When several timers are due in the same sweep of the
+ * timer service task the higher classes are called first.  If
+ * configTIMER_SWEEP_BUDGET_US is not 0, a sweep that has run for that long
+ * leaves the classes below the first one it called to the next pass of the
+ * timer service task, after the commands waiting on the queue.  Shares a
+ * byte with the catch-up policy, so must not be called at the same time as
+ * vTimerSetCatchUpPolicy() on the same timer.
+ */
+void vTimerSetPriority(TimerHandle_t xTimer, const UBaseType_t uxPriority);
+UBaseType_t uxTimerGetPriority(const TimerHandle_t xTimer);
+#endif
+
+/*
+ * Get and set the ID given to the timer when it was created.  The ID is kept
+ * with the timer metadata, so reading it from a callback costs a cache miss
+ * that pvTimerGetContext() avoids.
+ */
+void* pvTimerGetTimerID(const TimerHandle_t xTimer);
+void vTimerSetTimerID(TimerHandle_t xTimer, void* pvNewID);
+
 BaseType_t CreateTimerManageTask(void);
 
-#define xTimerStart( xTimer, xTicksToWait ) xTimerGenericCommand( ( xTimer ), tmrCOMMAND_START, ( xTaskGetTickCount() ), NULL, ( xTicksToWait ) )
+/*
+ * Timer domains.  Every domain has its own tick, active timer lists, command
+ * queue and timer service task, so a domain of latency critical protocol
+ * timers at 1 kHz is never held up behind thousands of housekeeping timers in
+ * a 10 Hz domain, and the 10 Hz domain only wakes at its own rate:
+ *
+ *   static const TimerDomainParameters_t xHousekeeping = { "Housekeeping", 10, 0 };
+ *   TimerDomainHandle_t xDomain = xTimerDomainCreate( &xHousekeeping );
+ *   xTimer = xTimerCreateInDomain( xDomain, "Flush", tmrMS_TO_DOMAIN_TICKS( 5000, 10 ),
+ *                                  pdTRUE, NULL, prvFlush );
+ *   xTimerDomainStart( xDomain );
+ *
+ * Periods and command times of a timer are in ticks of its domain.  Domain 0
+ * is the default domain, run on the kernel tick by CreateTimerManageTask(),
+ * and holds every timer not created with xTimerCreateInDomain().  At most
+ * configTIMER_MAX_DOMAINS domains, including domain 0, can exist.
+ */
+typedef struct tmrTimerDomain* TimerDomainHandle_t;
+
+typedef struct xTIMER_DOMAIN_PARAMETERS {
+	const char* pcDomainName;
+	uint32_t ulTickRateHz;		/*<< 0 if the ticks are given by xTimerDomainIncrementTick(). */
+	UBaseType_t uxQueueLength;	/*<< 0 for configTIMER_QUEUE_LENGTH. */
+} TimerDomainParameters_t;
+
+#define tmrMS_TO_DOMAIN_TICKS( xTimeInMs, ulTickRateHz ) \
+	( ( TickType_t ) ( ( ( uint64_t ) ( xTimeInMs ) * ( uint64_t ) ( ulTickRateHz ) ) / ( uint64_t ) 1000U ) )
+
+/* Returns NULL if configTIMER_MAX_DOMAINS domains already exist. */
+TimerDomainHandle_t xTimerDomainCreate(const TimerDomainParameters_t* const pxParameters);
+
+/* Start the timer service task of the domain, and its tick if it has one. */
+BaseType_t xTimerDomainStart(TimerDomainHandle_t xDomain);
+
+TimerDomainHandle_t xTimerGetDefaultDomain(void);
+TickType_t xTimerDomainGetTickCount(TimerDomainHandle_t xDomain);
+
+/* Advance a domain created with a ulTickRateHz of 0 by one tick. */
+BaseType_t xTimerDomainIncrementTick(TimerDomainHandle_t xDomain);
+
+#if (configUSE_VIRTUAL_TIME == 1)
+/*
+ * Virtual time, for running long scenarios in a fraction of the time they
+ * describe and getting the same result every run.  Nothing ticks on its own,
+ * so the harness drives each domain, NULL meaning the default domain:
+ *
+ *   xTimerStart( xTimer, 0 );
+ *   xTimerDomainAdvanceTime( NULL, pdMS_TO_TICKS( 3600000 ) );    ... an hour
+ *
+ * Each call first waits for the timer service task of the domain to finish
+ * what it has been sent, then moves the tick count straight to the next tick
+ * at which the task has something to do, waits for it to finish that, and so
+ * on.  The ticks in between are skipped, so the time taken depends on the
+ * number of expiries rather than the number of ticks.  Callbacks run on the
+ * timer service task one at a time as usual, and as only the harness moves
+ * time the order of expiries and commands is the same every run as long as
+ * the harness is the only thread sending commands.  High resolution timers
+ * still run on the real clock.
+ */
+
+/* Wait until the timer service task of xDomain has nothing left to do at the
+current tick count. */
+void vTimerDomainWaitUntilIdle(TimerDomainHandle_t xDomain);
+
+/* Advance xDomain by xTicks ticks, returning the new tick count. */
+TickType_t xTimerDomainAdvanceTime(TimerDomainHandle_t xDomain, const TickType_t xTicks);
+
+/*
+ * Advance xDomain to the next tick at which its timer service task has
+ * something to do, normally a timer expiring, and run it.  Returns pdFAIL
+ * without advancing if no timer is active.
+ */
+BaseType_t xTimerDomainAdvanceToNextWake(TimerDomainHandle_t xDomain);
+
+/*
+ * Wait until xDomain is idle, then return pdTRUE and the tick its timer
+ * service task waits for in *pxWakeTick, or pdFALSE if no timer is active.
+ */
+BaseType_t xTimerDomainGetNextWake(TimerDomainHandle_t xDomain, TickType_t* const pxWakeTick);
+#endif
+
+TimerHandle_t xTimerCreateInDomain(TimerDomainHandle_t xDomain,
+	const char* const pcTimerName,
+	const TickType_t xTimerPeriodInTicks,
+	const UBaseType_t uxAutoReload,
+	void* const pvTimerID,
+	TimerCallbackFunction_t pxCallbackFunction);
+
+TimerDomainHandle_t xTimerGetDomain(const TimerHandle_t xTimer);
+
+/* The tick count of the domain of xTimer, as used by xTimerStart(). */
+TickType_t xTimerGetDomainTickCount(const TimerHandle_t xTimer);
+
+/*
+ * The monotonic clock high resolution timers run on, in nanoseconds
+ * (std::chrono::steady_clock, which is CLOCK_MONOTONIC on Linux and the
+ * performance counter on Windows).
+ */
+uint64_t ullTimerGetMonotonicTime(void);
+
+#if (configUSE_HIGH_RES_TIMERS == 1)
+typedef void* HighResTimerHandle_t;
+typedef void (*HighResTimerCallbackFunction_t)(HighResTimerHandle_t xTimer);
+
+/*
+ * Create a timer whose period is ullPeriod nanoseconds of the monotonic clock
+ * instead of a number of ticks.  It is run by the same timer service task as
+ * tick timers, which blocks until the earlier of the next tick timer expiry
+ * and the next high resolution expiry, so these timers are not limited by
+ * configTICK_RATE_HZ and cost no wake ups between expiries.  An auto-reload
+ * high resolution timer that falls behind skips the periods it missed.
+ */
+HighResTimerHandle_t xHighResTimerCreate(const char* const pcTimerName,
+	const uint64_t ullPeriod,
+	const UBaseType_t uxAutoReload,
+	void* const pvTimerID,
+	HighResTimerCallbackFunction_t pxCallbackFunction);
+
+BaseType_t xHighResTimerGenericCommand(HighResTimerHandle_t xTimer, const BaseType_t xCommandID,
+	const uint64_t ullOptionalValue,
+	const TickType_t xTicksToWait);
+
+void* pvHighResTimerGetTimerID(const HighResTimerHandle_t xTimer);
+
+#define xHighResTimerStart( xTimer, xTicksToWait ) xHighResTimerGenericCommand( ( xTimer ), tmrCOMMAND_HIGH_RES_START, ullTimerGetMonotonicTime(), ( xTicksToWait ) )
+#define xHighResTimerStop( xTimer, xTicksToWait ) xHighResTimerGenericCommand( ( xTimer ), tmrCOMMAND_HIGH_RES_STOP, 0U, ( xTicksToWait ) )
+#define xHighResTimerChangePeriod( xTimer, ullNewPeriod, xTicksToWait ) xHighResTimerGenericCommand( ( xTimer ), tmrCOMMAND_HIGH_RES_CHANGE_PERIOD, ( ullNewPeriod ), ( xTicksToWait ) )
+#define xHighResTimerDelete( xTimer, xTicksToWait ) xHighResTimerGenericCommand( ( xTimer ), tmrCOMMAND_HIGH_RES_DELETE, 0U, ( xTicksToWait ) )
+#endif
+
+#define xTimerStart( xTimer, xTicksToWait ) xTimerGenericCommand( ( xTimer ), tmrCOMMAND_START, ( xTimerGetDomainTickCount( xTimer ) ), NULL, ( xTicksToWait ) )
+#define xTimerStop( xTimer, xTicksToWait ) xTimerGenericCommand( ( xTimer ), tmrCOMMAND_STOP, 0U, NULL, ( xTicksToWait ) )
+#define xTimerReset( xTimer, xTicksToWait ) xTimerGenericCommand( ( xTimer ), tmrCOMMAND_RESET, ( xTimerGetDomainTickCount( xTimer ) ), NULL, ( xTicksToWait ) )
+#define xTimerChangePeriod( xTimer, xNewPeriod, xTicksToWait ) xTimerGenericCommand( ( xTimer ), tmrCOMMAND_CHANGE_PERIOD, ( xNewPeriod ), NULL, ( xTicksToWait ) )
+#define xTimerDelete( xTimer, xTicksToWait ) xTimerGenericCommand( ( xTimer ), tmrCOMMAND_DELETE, 0U, NULL, ( xTicksToWait ) )
 
 BaseType_t xTimerGenericCommand(TimerHandle_t xTimer, const BaseType_t xCommandID,
 	const TickType_t  xOptionalValue,
 	BaseType_t* const pxHigherPriorityTaskWoken,
 	const TickType_t  xTicksToWait);
 
-void Delete();
-void Start();
-void Stop();
-void Reset();
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+/*
+ * Defer xFunctionToPend( pvParameter1, ulParameter2 ) to the timer service
+ * task of the default domain, for example to move slow work out of a handler
+ * installed with vPortSetInterruptHandler().  The call is put on a lock-free
+ * queue of configTIMER_PEND_QUEUE_LENGTH entries, and the timer service task
+ * runs up to configTIMER_PEND_BATCH_LENGTH of them each time round its loop,
+ * in the order they were pended.  Only the call that finds the queue empty
+ * sends a message to wake the timer service task.
+ *
+ * Returns pdFAIL if the queue is full, after waiting up to xTicksToWait ticks
+ * for space in the task version, so the caller can shed or retry the work.
+ * Every rejected call is counted by uxTimerGetPendedFunctionCallsRejected().
+ */
+BaseType_t xTimerPendFunctionCall(PendedFunction_t xFunctionToPend, void* pvParameter1,
+	uint32_t ulParameter2, TickType_t xTicksToWait);
+BaseType_t xTimerPendFunctionCallFromISR(PendedFunction_t xFunctionToPend, void* pvParameter1,
+	uint32_t ulParameter2, BaseType_t* pxHigherPriorityTaskWoken);
+
+UBaseType_t uxTimerGetPendedFunctionCallsRejected(void);
+#endif
+
+#if (configUSE_TIMER_HISTOGRAMS == 1)
+/* The histograms kept by the timer service, see ullTimerGetHistogramPercentile(). */
+#define tmrHISTOGRAM_EXPIRY_LATENESS ((UBaseType_t)0)
+#define tmrHISTOGRAM_COMMAND_LATENCY ((UBaseType_t)1)
+
+/* Pass as uxClass to merge the histograms of every priority class. */
+#define tmrHISTOGRAM_ALL_CLASSES ((UBaseType_t)0xFF)
+
+/* Values below 8 have a bucket each, above that every power of two is split
+into 8 buckets, so a value is rounded down by at most 12.5%. */
+#define tmrHISTOGRAM_BUCKETS ((UBaseType_t)496)
+
+/*
+ * Histograms of nanosecond latencies, one per priority class (see
+ * vTimerSetPriority(), every timer is in tmrPRIORITY_LOWEST otherwise):
+ *
+ * tmrHISTOGRAM_EXPIRY_LATENESS - from the tick at which a timer fell due to
+ * its callback being called.  Domains ticked by xTimerDomainIncrementTick()
+ * have no tick period, so only the time since their last tick is counted.
+ *
+ * tmrHISTOGRAM_COMMAND_LATENCY - from xTimerGenericCommand() being called to
+ * the timer service task taking the command off the queue, including any time
+ * spent waiting for space on the queue.
+ *
+ * Recording is a relaxed atomic increment of one bucket, so the histograms can
+ * be read and reset from any task while the timer service tasks run.
+ */
+uint64_t ullTimerGetHistogramCount(const UBaseType_t uxHistogram, const UBaseType_t uxClass);
+
+/*
+ * The value below which ulPartsPerMillion of the recorded values fall, for
+ * example 999000 for the 99.9th percentile, reported as the highest value of
+ * its bucket.  Returns 0 if nothing has been recorded.
+ */
+uint64_t ullTimerGetHistogramPercentile(const UBaseType_t uxHistogram, const UBaseType_t uxClass,
+	const uint32_t ulPartsPerMillion);
+
+/*
+ * Copy the tmrHISTOGRAM_BUCKETS counts of a histogram to pulCounts, for
+ * exporting it whole.  Bucket uxBucket holds the values from
+ * ullTimerGetHistogramBucketValue( uxBucket ) up to the value of the next
+ * bucket.  Returns the index of the highest bucket that is not empty, plus one.
+ */
+UBaseType_t uxTimerGetHistogramBuckets(const UBaseType_t uxHistogram, const UBaseType_t uxClass,
+	uint32_t* const pulCounts);
+uint64_t ullTimerGetHistogramBucketValue(const UBaseType_t uxBucket);
+
+/* Clear every histogram.  Values recorded while it runs may survive. */
+void vTimerResetHistograms(void);
+#endif
+
+#if (configUSE_TIMER_STATS == 1)
+/* The commands counted by ID in ulCommandsProcessed, see TimerStats_t. */
+#define tmrSTATS_COMMAND_TYPES ((UBaseType_t)(tmrCOMMAND_CHANGE_PERIOD_FROM_ISR + 1))
+
+/*
+ * What the timer service task of one domain has done since it was created.
+ * The average walk of the sorted active list is ullInsertSteps / ullInserts.
+ */
+typedef struct xTIMER_STATS {
+	UBaseType_t uxCurrentListTimers;	/*<< Active timers due before the tick count wraps. */
+	UBaseType_t uxOverflowListTimers;	/*<< Active timers due after the tick count wraps. */
+	UBaseType_t uxQueueDepth;			/*<< Commands waiting in the timer queue. */
+	UBaseType_t uxQueueHighWaterMark;	/*<< The most commands that have waited at once. */
+	uint32_t ulCommandsProcessed[tmrSTATS_COMMAND_TYPES]; /*<< Indexed by tmrCOMMAND_* value. */
+	uint32_t ulOtherMessagesProcessed;	/*<< High resolution commands and pended call wake ups. */
+	uint32_t ulExpirations;				/*<< Callbacks called for timers that expired. */
+	uint32_t ulListSwitches;			/*<< Times the tick count wrapped and the lists swapped. */
+	uint32_t ulWakeUps;					/*<< Times the task woke from waiting on the queue. */
+	uint32_t ulUsefulWakeUps;			/*<< Wake ups followed by an expiry or a message. */
+	uint64_t ullInserts;				/*<< Timers inserted in the sorted active lists. */
+	uint64_t ullInsertSteps;			/*<< Timers walked past by those inserts. */
+} TimerStats_t;
+
+/*
+ * Fill in *pxStats for xDomain, or the default domain if xDomain is NULL.  The
+ * counters are written only by the timer service task of the domain and read
+ * with relaxed atomic loads, so reading them never holds it up, but while it
+ * runs they can be a few events apart from each other.
+ */
+void vTimerGetStats(TimerDomainHandle_t xDomain, TimerStats_t* const pxStats);
+#endif
+
+#if (configUSE_TIMER_CALLBACK_ACCOUNTING == 1)
+/*
+ * What the callback of one timer has cost since the timer was created, in
+ * nanoseconds.  Callbacks registered with xTimerRegisterBatchCallback() run
+ * for many timers at once, so are not counted against any of them.
+ */
+typedef struct xTIMER_CALLBACK_STATS {
+	uint64_t ullCalls;
+	uint64_t ullWallTime;		/*<< Total time from entry to return. */
+	uint64_t ullCpuTime;		/*<< Total CPU time of the timer service task while in the callback. */
+	uint64_t ullMaxWallTime;	/*<< The longest single call. */
+	uint64_t ullOverruns;		/*<< Calls that took longer than the budget. */
+} TimerCallbackStats_t;
+
+/*
+ * Set the wall time, in microseconds, that one call of the callback of xTimer
+ * should stay within, or 0 for no limit.  Every overrun is counted, and the
+ * first after each quiet configTIMER_OVERRUN_REPORT_INTERVAL_MS is passed to
+ * configTIMER_REPORT_OVERRUN() with the name of the timer.
+ */
+void vTimerSetCallbackBudget(TimerHandle_t xTimer, const uint32_t ulBudgetUs);
+
+/* Read the counters of xTimer, see TimerCallbackStats_t. */
+void vTimerGetCallbackStats(TimerHandle_t xTimer, TimerCallbackStats_t* const pxStats);
+#endif
+
+#if (configUSE_TIMER_SNAPSHOT == 1)
+/*
+ * Snapshots of the active timers of the default domain, so a restarted
+ * process gets its timers back without a create and a start command per
+ * timer:
+ *
+ *   static const TimerCallbackFunction_t xCallbacks[] = { prvP2Timeout, prvTesterPresent };
+ *   TimerSnapshotParameters_t xSnapshot = { "timers.snap", xCallbacks, 2, prvFixUpTimer };
+ *
+ *   xTimerSnapshotSave( &xSnapshot );            ... before exiting
+ *   xTimerSnapshotRestore( &xSnapshot, NULL );   ... after restarting, before CreateTimerManageTask()
+ *
+ * Callback addresses change from one run to the next, so timers are saved with
+ * the index of their callback in pxCallbacks, which must list the callbacks in
+ * the same order in every build that shares snapshots.  Timers using any other
+ * callback, including lightweight timers and timers with a context, are left
+ * out.  pvTimerID is restored bit for bit, so an ID that points to memory must
+ * be fixed up by pxRestoredTimer.  Names are truncated to
+ * configMAX_TIMER_NAME_LEN - 1 characters.
+ */
+typedef struct xTIMER_SNAPSHOT_PARAMETERS {
+	const char* pcFileName;
+	const TimerCallbackFunction_t* pxCallbacks;
+	UBaseType_t uxNumberOfCallbacks;
+	void (*pxRestoredTimer)(TimerHandle_t xTimer); /* Called for each restored timer, may be NULL. */
+} TimerSnapshotParameters_t;
+
+/*
+ * Map pcFileName and write every active timer to it with the ticks left until
+ * it expires.  Runs on the timer service task, waiting for it if called from
+ * another task, so the lists are not changing while they are written.
+ * Commands still in the timer queue are not included.
+ */
+BaseType_t xTimerSnapshotSave(const TimerSnapshotParameters_t* const pxParameters);
+
+/*
+ * Map pcFileName and create the timers it holds, linking them straight into
+ * the active list to expire after the ticks they had left when saved, counted
+ * from the tick count now and rescaled if configTICK_RATE_HZ has changed.
+ * Like xTimerCreateStaticTable(), this must be called before
+ * CreateTimerManageTask().  The number of timers restored is written to
+ * puxRestored if it is not NULL.
+ */
+BaseType_t xTimerSnapshotRestore(const TimerSnapshotParameters_t* const pxParameters,
+	UBaseType_t* const puxRestored);
+#endif
+
+#if (configUSE_TIMER_POOL == 0)
+/* Must be called once before any other function is used on the timer. */
+void Init(LightweightTimer_t* timer, uint32_t tick_count, ExpireCallBack callback);
+
+/* The timer expires tick_count ticks after Start() or Reset() is called.  As
+with xTimerStart(), starting a running timer restarts it.  Off the timer
+service task these return pdFAIL if the timer queue was full, as
+xTimerGenericCommand() does with no block time. */
+BaseType_t Start(LightweightTimer_t* timer);
+BaseType_t Reset(LightweightTimer_t* timer);
+BaseType_t Stop(LightweightTimer_t* timer);
+
+/*
+ * Stop the timer so the memory holding it can be reused.  Off the timer
+ * service task this waits for room in the timer queue and then until the timer
+ * service task has processed every command sent for the timer, so returns
+ * pdFAIL without waiting if the timer service task is not running.  On the
+ * timer service task the commands still queued for the timer are cancelled
+ * instead.  Either way no other task may still be calling Start(), Reset() or
+ * Stop() on the timer, and a timer deleted from its own callback must not be
+ * reused until that callback has returned.
+ */
+BaseType_t Delete(LightweightTimer_t* timer);
+#endif
 
 
 #endif
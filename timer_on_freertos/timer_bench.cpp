@@ -0,0 +1,322 @@
+#include "uds.h"
+
+#if (configTIMER_BENCHMARK == 1)
+
+#include "task.h"
+#include "timer.h"
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #include <Windows.h>
+    #include <psapi.h>
+#endif
+
+/*
+ * Throughput of the timer service API, built instead of main.cpp when
+ * configTIMER_BENCHMARK is 1.  It drives the kernel tick itself rather than
+ * starting the port, so it runs headless and as fast as the timer service
+ * allows:
+ *
+ *   uds [scales] [workloads]
+ *   uds 1,1000,100000 uniform,cancel
+ *
+ * Each result is written to stdout as one JSON object per line:
+ *
+ *   {"store":"list","workload":"uniform","timers":1000,"op":"start","ns_per_op":412.7,"rss_kb":5120}
+ *
+ * The commands are timed from the first one being sent until the timer service
+ * task has processed the last, and "expire" from the first tick until every
+ * callback has run.  The active timer list is sorted, so a start costs a walk
+ * of the list and the larger scales take a while; that cost is what the
+ * benchmark is there to show.
+ */
+
+#if (INCLUDE_xTimerPendFunctionCall == 0)
+    #error configTIMER_BENCHMARK needs INCLUDE_xTimerPendFunctionCall to know when commands have been processed
+#endif
+
+#define benchDEFAULT_SCALES "1,10,100,1000,10000,100000"
+#define benchDEFAULT_WORKLOADS "uniform,same,cancel"
+
+/* The periods of the uniform workload are spread over this many ticks. */
+#define benchUNIFORM_PERIOD_RANGE ((TickType_t)1000U)
+#define benchSAME_PERIOD ((TickType_t)100U)
+
+/* One timer in this many is left running by the cancel workload. */
+#define benchCANCEL_SURVIVOR_RATIO 10U
+
+#if (configUSE_TIMER_POOL == 1)
+    #define benchSTORE_NAME "pool"
+#else
+    #define benchSTORE_NAME "list"
+#endif
+
+typedef enum {
+    eBenchUniform = 0,
+    eBenchSamePeriod,
+    eBenchHeavyCancel
+} BenchWorkload_t;
+
+static const char *const pcWorkloadNames[] = {"uniform", "same", "cancel"};
+
+static std::atomic<UBaseType_t> uxTimersExpired(0U);
+
+/* Set by prvFenceReached() on the timer service task. */
+static std::mutex xFenceMutex;
+static std::condition_variable xFenceReached;
+static BaseType_t xFencePassed = pdFALSE;
+
+static void prvBenchTimerCallback(TimerHandle_t xTimer) {
+    (void)xTimer;
+    uxTimersExpired.fetch_add(1U, std::memory_order_relaxed);
+}
+
+static void prvFenceReached(void *pvParameter1, uint32_t ulParameter2) {
+    (void)pvParameter1;
+    (void)ulParameter2;
+
+    {
+        std::lock_guard<std::mutex> xLock(xFenceMutex);
+        xFencePassed = pdTRUE;
+    }
+    xFenceReached.notify_all();
+}
+
+/*
+ * Pended calls are run after the command queue has been emptied, so once this
+ * returns every command sent before it has been processed.
+ */
+static void prvWaitForTimerTask(void) {
+    std::unique_lock<std::mutex> xLock(xFenceMutex);
+
+    xFencePassed = pdFALSE;
+    xLock.unlock();
+    (void)xTimerPendFunctionCall(prvFenceReached, NULL, 0U, portMAX_DELAY);
+    xLock.lock();
+    xFenceReached.wait(xLock, [] { return xFencePassed != pdFALSE; });
+}
+
+static unsigned long prvResidentSetKb(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS xCounters;
+
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &xCounters, sizeof(xCounters)) != 0) {
+        return (unsigned long)(xCounters.WorkingSetSize / 1024U);
+    }
+    return 0UL;
+#else
+    char cLine[128];
+    unsigned long ulKb = 0UL;
+    FILE *pxStatus = fopen("/proc/self/status", "r");
+
+    if (pxStatus != NULL) {
+        while (fgets(cLine, sizeof(cLine), pxStatus) != NULL) {
+            if (sscanf(cLine, "VmRSS: %lu", &ulKb) == 1) {
+                break;
+            }
+        }
+        fclose(pxStatus);
+    }
+    return ulKb;
+#endif
+}
+
+static void prvReport(const BenchWorkload_t eWorkload, const size_t xTimers, const char *const pcOperation,
+                      const std::chrono::steady_clock::time_point xStart, const size_t xOperations) {
+    const double dNanoseconds =
+        (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - xStart).count();
+
+    printf("{\"store\":\"%s\",\"workload\":\"%s\",\"timers\":%lu,\"op\":\"%s\",\"ns_per_op\":%.1f,\"rss_kb\":%lu}\n",
+           benchSTORE_NAME, pcWorkloadNames[eWorkload], (unsigned long)xTimers, pcOperation,
+           (xOperations > 0U) ? (dNanoseconds / (double)xOperations) : 0.0, prvResidentSetKb());
+    fflush(stdout);
+}
+
+/*
+ * Step the kernel tick until uxExpected callbacks have run, without letting
+ * the tick run more than xMaximumPeriod ahead of where it started.
+ */
+static void prvRunUntilExpired(const UBaseType_t uxExpected, const TickType_t xMaximumPeriod) {
+    const TickType_t xStartTick = xTaskGetTickCount();
+
+    while (uxTimersExpired.load(std::memory_order_relaxed) < uxExpected) {
+        if ((TickType_t)(xTaskGetTickCount() - xStartTick) <= xMaximumPeriod) {
+            (void)xTaskIncrementTick();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+static BaseType_t prvRunWorkload(const BenchWorkload_t eWorkload, const size_t xTimers) {
+    std::vector<TimerHandle_t> xHandles(xTimers);
+    std::vector<TickType_t> xPeriods(xTimers);
+    std::mt19937 xRandom(1234U);
+    std::chrono::steady_clock::time_point xStart;
+    size_t x;
+    size_t xSurvivors = 0U;
+
+    for (x = 0; x < xTimers; x++) {
+        xPeriods[x] = (eWorkload == eBenchUniform)
+                          ? (TickType_t)(1U + (xRandom() % benchUNIFORM_PERIOD_RANGE))
+                          : benchSAME_PERIOD;
+    }
+
+    xStart = std::chrono::steady_clock::now();
+    for (x = 0; x < xTimers; x++) {
+        xHandles[x] = xTimerCreate("Bench", xPeriods[x], pdFALSE, NULL, prvBenchTimerCallback);
+        if (xHandles[x] == NULL) {
+            fprintf(stderr, "could not create timer %lu of %lu\n", (unsigned long)x, (unsigned long)xTimers);
+            xHandles.resize(x);
+            for (TimerHandle_t xTimer : xHandles) {
+                (void)xTimerDelete(xTimer, portMAX_DELAY);
+            }
+            prvWaitForTimerTask();
+            return pdFAIL;
+        }
+    }
+    prvReport(eWorkload, xTimers, "create", xStart, xTimers);
+
+    if (eWorkload == eBenchHeavyCancel) {
+        /* Most protocol timeouts are cancelled by the response they guard
+        against, so only one in benchCANCEL_SURVIVOR_RATIO stays running. */
+        xStart = std::chrono::steady_clock::now();
+        for (x = 0; x < xTimers; x++) {
+            (void)xTimerStart(xHandles[x], portMAX_DELAY);
+            if ((x % benchCANCEL_SURVIVOR_RATIO) != 0U) {
+                (void)xTimerStop(xHandles[x], portMAX_DELAY);
+            } else {
+                xSurvivors++;
+            }
+        }
+        prvWaitForTimerTask();
+        prvReport(eWorkload, xTimers, "start_stop", xStart, (xTimers * 2U) - xSurvivors);
+    } else {
+        xStart = std::chrono::steady_clock::now();
+        for (x = 0; x < xTimers; x++) {
+            (void)xTimerStart(xHandles[x], portMAX_DELAY);
+        }
+        prvWaitForTimerTask();
+        prvReport(eWorkload, xTimers, "start", xStart, xTimers);
+
+        xStart = std::chrono::steady_clock::now();
+        for (x = 0; x < xTimers; x++) {
+            (void)xTimerReset(xHandles[x], portMAX_DELAY);
+        }
+        prvWaitForTimerTask();
+        prvReport(eWorkload, xTimers, "reset", xStart, xTimers);
+
+        xStart = std::chrono::steady_clock::now();
+        for (x = 0; x < xTimers; x++) {
+            (void)xTimerChangePeriod(xHandles[x], xPeriods[x], portMAX_DELAY);
+        }
+        prvWaitForTimerTask();
+        prvReport(eWorkload, xTimers, "change_period", xStart, xTimers);
+
+        xStart = std::chrono::steady_clock::now();
+        for (x = 0; x < xTimers; x++) {
+            (void)xTimerStop(xHandles[x], portMAX_DELAY);
+        }
+        prvWaitForTimerTask();
+        prvReport(eWorkload, xTimers, "stop", xStart, xTimers);
+
+        for (x = 0; x < xTimers; x++) {
+            (void)xTimerStart(xHandles[x], portMAX_DELAY);
+        }
+        prvWaitForTimerTask();
+        xSurvivors = xTimers;
+    }
+
+    uxTimersExpired.store(0U);
+    xStart = std::chrono::steady_clock::now();
+    prvRunUntilExpired((UBaseType_t)xSurvivors,
+                       (eWorkload == eBenchUniform) ? benchUNIFORM_PERIOD_RANGE : benchSAME_PERIOD);
+    prvReport(eWorkload, xTimers, "expire", xStart, xSurvivors);
+
+    xStart = std::chrono::steady_clock::now();
+    for (x = 0; x < xTimers; x++) {
+        (void)xTimerDelete(xHandles[x], portMAX_DELAY);
+    }
+    prvWaitForTimerTask();
+    prvReport(eWorkload, xTimers, "delete", xStart, xTimers);
+
+    return pdPASS;
+}
+
+/*
+ * Return the next comma separated field of *ppcList, NUL terminated in place,
+ * or NULL once there are none left.
+ */
+static char *prvNextField(char **ppcList) {
+    char *const pcField = *ppcList;
+    char *pcComma;
+
+    if ((pcField == NULL) || (*pcField == '\0')) {
+        return NULL;
+    }
+
+    pcComma = strchr(pcField, ',');
+    if (pcComma != NULL) {
+        *pcComma = '\0';
+        *ppcList = pcComma + 1;
+    } else {
+        *ppcList = NULL;
+    }
+
+    return pcField;
+}
+
+int main(int argc, char **argv) {
+    char cScales[256];
+    char cWorkloads[64];
+    char *pcScales;
+    char *pcWorkloads;
+    char *pcScale;
+    char *pcWorkload;
+    const UBaseType_t uxNumberOfWorkloads = (UBaseType_t)(sizeof(pcWorkloadNames) / sizeof(pcWorkloadNames[0]));
+    UBaseType_t uxWorkload;
+    BaseType_t xResult = pdPASS;
+
+    snprintf(cScales, sizeof(cScales), "%s", (argc > 1) ? argv[1] : benchDEFAULT_SCALES);
+
+    CreateTimerManageTask();
+
+    pcScales = cScales;
+    while ((pcScale = prvNextField(&pcScales)) != NULL) {
+        snprintf(cWorkloads, sizeof(cWorkloads), "%s", (argc > 2) ? argv[2] : benchDEFAULT_WORKLOADS);
+
+        pcWorkloads = cWorkloads;
+        while ((pcWorkload = prvNextField(&pcWorkloads)) != NULL) {
+            for (uxWorkload = 0U; uxWorkload < uxNumberOfWorkloads; uxWorkload++) {
+                if (strcmp(pcWorkload, pcWorkloadNames[uxWorkload]) == 0) {
+                    break;
+                }
+            }
+
+            if (uxWorkload == uxNumberOfWorkloads) {
+                fprintf(stderr, "unknown workload %s\n", pcWorkload);
+                return 1;
+            }
+
+            if (prvRunWorkload((BenchWorkload_t)uxWorkload, (size_t)std::strtoul(pcScale, NULL, 10)) == pdFAIL) {
+                xResult = pdFAIL;
+            }
+        }
+    }
+
+    /* The timer service task never returns, so leave without waiting for it
+    or running the static destructors under it. */
+    fflush(stdout);
+    std::quick_exit((xResult == pdPASS) ? 0 : 1);
+}
+
+#endif /* configTIMER_BENCHMARK */
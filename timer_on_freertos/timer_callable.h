@@ -0,0 +1,89 @@
+#ifndef __TIMER_CALLABLE_H__
+#define __TIMER_CALLABLE_H__
+
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "uds.h"
+#include "timer.h"
+
+#if (configUSE_TIMER_POOL == 1)
+    #error timer_callable.h needs xTimerCreateWithContext(), which is not available when configUSE_TIMER_POOL is 1
+#endif
+
+#ifndef configTIMER_CALLABLE_SIZE
+    /* Bytes of storage reserved for the callable of each timer created by
+    xTimerCreateCallable() unless the call asks for a different size. */
+#define configTIMER_CALLABLE_SIZE 32
+#endif
+
+/*
+ * Timers with any C++ callable as their callback, for example a lambda with
+ * captures, without storing a pointer in pvTimerID:
+ *
+ *   TimerHandle_t xTimer = xTimerCreateCallable( "P2", pdMS_TO_TICKS( 50 ), pdFALSE,
+ *       [ this, uxRequest ]() { prvP2Expired( uxRequest ); } );
+ *   xTimerStart( xTimer, 0 );
+ *
+ * The callable is moved into a buffer of xCallableSize bytes that is allocated
+ * with the timer itself by xTimerCreateCallable(), so starting, stopping and
+ * expiring the timer never allocates.  A callable that does not fit the buffer
+ * fails to compile rather than falling back to the heap; pass a larger
+ * xCallableSize for it.  The callable is invoked with the timer handle if it
+ * accepts one, otherwise with no arguments, and is destroyed when the timer is
+ * deleted with xTimerDelete().
+ */
+template <typename Callable>
+static auto prvInvokeTimerCallable(Callable &xCallable, TimerHandle_t xTimer, int)
+    -> decltype(xCallable(xTimer), void()) {
+    xCallable(xTimer);
+}
+
+template <typename Callable>
+static auto prvInvokeTimerCallable(Callable &xCallable, TimerHandle_t xTimer, long)
+    -> decltype(xCallable(), void()) {
+    (void)xTimer;
+    xCallable();
+}
+
+template <typename Callable>
+static void prvTimerCallableCallback(TimerHandle_t xTimer) {
+    prvInvokeTimerCallable(*(Callable *)pvTimerGetContext(xTimer), xTimer, 0);
+}
+
+template <typename Callable>
+static void prvDestroyTimerCallable(void *pvContext) {
+    ((Callable *)pvContext)->~Callable();
+}
+
+template <size_t xCallableSize = configTIMER_CALLABLE_SIZE, typename Callable>
+TimerHandle_t xTimerCreateCallable(const char *const pcTimerName,
+                                   const TickType_t xTimerPeriodInTicks,
+                                   const UBaseType_t uxAutoReload, Callable &&xCallable) {
+    typedef typename std::decay<Callable>::type StoredCallable_t;
+    void *pvContext;
+    TimerHandle_t xTimer;
+
+    static_assert(sizeof(StoredCallable_t) <= xCallableSize,
+                  "The callable does not fit in the timer, increase xCallableSize");
+    static_assert(alignof(StoredCallable_t) <= alignof(std::max_align_t),
+                  "The callable needs more alignment than the timer context provides");
+
+    xTimer = xTimerCreateWithContext(
+        pcTimerName, xTimerPeriodInTicks, uxAutoReload, &prvTimerCallableCallback<StoredCallable_t>,
+        xCallableSize, &pvContext,
+        std::is_trivially_destructible<StoredCallable_t>::value
+            ? (TimerContextDestructor_t)NULL
+            : &prvDestroyTimerCallable<StoredCallable_t>);
+
+    if (xTimer != NULL) {
+        /* The timer has not been started, so nothing can call the callable
+        before it is constructed. */
+        new (pvContext) StoredCallable_t(std::forward<Callable>(xCallable));
+    }
+
+    return xTimer;
+}
+
+#endif
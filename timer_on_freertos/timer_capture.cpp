@@ -0,0 +1,307 @@
+#include "uds.h"
+
+#if (configUSE_TIMER_CAPTURE == 1)
+
+#include "timer.h"
+#include "timer_capture.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* Checked without the mutex so calls made while nothing is captured cost a
+load. */
+static std::atomic<BaseType_t> xCaptureRunning(pdFALSE);
+
+/* Everything below is guarded by xCaptureMutex, which also keeps the records
+in the file in time order. */
+static std::mutex xCaptureMutex;
+static FILE *pxCaptureFile = NULL;
+static uint64_t ullCaptureStartTime = 0U;
+static uint32_t ulNextCaptureTimer = 0U;
+static std::unordered_map<TimerHandle_t, uint32_t> xCaptureTimers;
+
+static void prvReplayCallback(TimerHandle_t xTimer);
+
+/*
+ * Write a record stamped with the current time.  xCaptureMutex must be held.
+ */
+static void prvWriteCaptureRecord(TimerCaptureRecord_t *const pxRecord);
+
+/*
+ * The number of xTimer, writing a create record for it first if it has not
+ * been seen before.  xCaptureMutex must be held.
+ */
+static uint32_t prvGetCaptureTimer(TimerHandle_t xTimer, const TickType_t xPeriod,
+                                   const UBaseType_t uxAutoReload);
+
+/* True for the commands whose value is the tick count they were sent at. */
+static BaseType_t prvCommandTakesTickCount(const BaseType_t xCommandID);
+
+BaseType_t xTimerCaptureStart(const char *const pcFileName) {
+    std::lock_guard<std::mutex> xLock(xCaptureMutex);
+    TimerCaptureFileHeader_t xHeader;
+
+    configASSERT(pcFileName);
+
+    if (pxCaptureFile != NULL) {
+        return pdFAIL;
+    }
+
+    pxCaptureFile = fopen(pcFileName, "wb");
+    if (pxCaptureFile == NULL) {
+        return pdFAIL;
+    }
+
+    xHeader.ulMagic      = tmrCAPTURE_FILE_MAGIC;
+    xHeader.ulVersion    = tmrCAPTURE_FILE_VERSION;
+    xHeader.ulRecordSize = (uint32_t)sizeof(TimerCaptureRecord_t);
+    xHeader.ulTickRateHz = (uint32_t)configTICK_RATE_HZ;
+
+    if (fwrite(&xHeader, sizeof(xHeader), 1U, pxCaptureFile) != 1U) {
+        (void)fclose(pxCaptureFile);
+        pxCaptureFile = NULL;
+        return pdFAIL;
+    }
+
+    ullCaptureStartTime = ullTimerGetMonotonicTime();
+    ulNextCaptureTimer  = 0U;
+    xCaptureTimers.clear();
+    xCaptureRunning.store(pdTRUE, std::memory_order_release);
+
+    return pdPASS;
+}
+
+void vTimerCaptureStop(void) {
+    std::lock_guard<std::mutex> xLock(xCaptureMutex);
+
+    xCaptureRunning.store(pdFALSE, std::memory_order_relaxed);
+
+    if (pxCaptureFile != NULL) {
+        (void)fclose(pxCaptureFile);
+        pxCaptureFile = NULL;
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    xCaptureTimers.clear();
+}
+
+static void prvWriteCaptureRecord(TimerCaptureRecord_t *const pxRecord) {
+    pxRecord->ullTime   = ullTimerGetMonotonicTime() - ullCaptureStartTime;
+    pxRecord->ucPadding = 0U;
+
+    if (fwrite(pxRecord, sizeof(TimerCaptureRecord_t), 1U, pxCaptureFile) != 1U) {
+        /* Most likely the disk is full.  Keep what was written so far. */
+        xCaptureRunning.store(pdFALSE, std::memory_order_relaxed);
+        (void)fclose(pxCaptureFile);
+        pxCaptureFile = NULL;
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+static uint32_t prvGetCaptureTimer(TimerHandle_t xTimer, const TickType_t xPeriod,
+                                   const UBaseType_t uxAutoReload) {
+    TimerCaptureRecord_t xRecord;
+    std::unordered_map<TimerHandle_t, uint32_t>::const_iterator xFound = xCaptureTimers.find(xTimer);
+
+    if (xFound != xCaptureTimers.end()) {
+        return xFound->second;
+    }
+
+    xRecord.ulTimer       = ulNextCaptureTimer++;
+    xRecord.ulValue       = (uint32_t)xPeriod;
+    xRecord.ulTicksToWait = 0U;
+    xRecord.cCommand      = tmrCAPTURE_CREATE;
+    xRecord.ucAutoReload  = (uint8_t)uxAutoReload;
+    xRecord.ucResult      = (uint8_t)pdPASS;
+    prvWriteCaptureRecord(&xRecord);
+
+    xCaptureTimers[xTimer] = xRecord.ulTimer;
+    return xRecord.ulTimer;
+}
+
+static BaseType_t prvCommandTakesTickCount(const BaseType_t xCommandID) {
+    return ((xCommandID == tmrCOMMAND_START) || (xCommandID == tmrCOMMAND_RESET) ||
+            (xCommandID == tmrCOMMAND_START_FROM_ISR) || (xCommandID == tmrCOMMAND_RESET_FROM_ISR))
+               ? pdTRUE
+               : pdFALSE;
+}
+
+void vTimerCaptureCreate(TimerHandle_t xTimer, const TickType_t xPeriod, const UBaseType_t uxAutoReload) {
+    if (xCaptureRunning.load(std::memory_order_acquire) == pdFALSE) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> xLock(xCaptureMutex);
+
+    if (pxCaptureFile != NULL) {
+        /* A new timer can have the handle of one that was deleted. */
+        (void)xCaptureTimers.erase(xTimer);
+        (void)prvGetCaptureTimer(xTimer, xPeriod, uxAutoReload);
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+void vTimerCaptureCommand(TimerHandle_t xTimer, const TickType_t xPeriod, const UBaseType_t uxAutoReload,
+                          const TickType_t xTickCount, const BaseType_t xCommandID, const TickType_t xValue,
+                          const TickType_t xTicksToWait, const BaseType_t xResult) {
+    TimerCaptureRecord_t xRecord;
+
+    /* The timer service task restarting auto-reload timers is not traffic. */
+    if ((xCommandID == tmrCOMMAND_START_DONT_TRACE) ||
+        (xCaptureRunning.load(std::memory_order_acquire) == pdFALSE)) {
+        return;
+    }
+
+    /* Starts carry the tick count they were sent at, which is kept as an
+    offset from the tick count of the domain when they were sent so the replay
+    can send it relative to its own. */
+    xRecord.ulValue = (prvCommandTakesTickCount(xCommandID) != pdFALSE)
+                          ? (uint32_t)(xValue - xTickCount)
+                          : (uint32_t)xValue;
+
+    std::lock_guard<std::mutex> xLock(xCaptureMutex);
+
+    if (pxCaptureFile != NULL) {
+        xRecord.ulTimer       = prvGetCaptureTimer(xTimer, xPeriod, uxAutoReload);
+        xRecord.ulTicksToWait = (uint32_t)xTicksToWait;
+        xRecord.cCommand      = (int8_t)xCommandID;
+        xRecord.ucAutoReload  = (uint8_t)uxAutoReload;
+        xRecord.ucResult      = (uint8_t)xResult;
+        prvWriteCaptureRecord(&xRecord);
+
+        if ((xCommandID == tmrCOMMAND_DELETE) && (xResult != pdFAIL)) {
+            (void)xCaptureTimers.erase(xTimer);
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+static void prvReplayCallback(TimerHandle_t xTimer) {
+    (void)xTimer;
+}
+
+BaseType_t xTimerReplay(const char *const pcFileName, const BaseType_t xPaced,
+                        TimerCallbackFunction_t pxCallback, TimerReplayResult_t *const pxResult) {
+    FILE *pxFile;
+    TimerCaptureFileHeader_t xHeader;
+    TimerCaptureRecord_t xRecord;
+    std::vector<TimerHandle_t> xTimers;
+    TimerHandle_t xTimer;
+    TickType_t xValue;
+    BaseType_t xHigherPriorityTaskWoken;
+    BaseType_t xSent;
+    std::chrono::steady_clock::time_point xStart;
+    uint64_t ullStartTime;
+
+    configASSERT(pcFileName);
+    configASSERT(pxResult);
+
+    pxResult->ullRecords                 = 0U;
+    pxResult->ullCommandsFailed          = 0U;
+    pxResult->ullCommandsFailedInCapture = 0U;
+    pxResult->ullCreatesFailed           = 0U;
+    pxResult->ullCapturedDuration        = 0U;
+    pxResult->ullReplayDuration          = 0U;
+
+    pxFile = fopen(pcFileName, "rb");
+    if (pxFile == NULL) {
+        return pdFAIL;
+    }
+
+    if ((fread(&xHeader, sizeof(xHeader), 1U, pxFile) != 1U) || (xHeader.ulMagic != tmrCAPTURE_FILE_MAGIC) ||
+        (xHeader.ulVersion != tmrCAPTURE_FILE_VERSION) ||
+        (xHeader.ulRecordSize != (uint32_t)sizeof(TimerCaptureRecord_t))) {
+        (void)fclose(pxFile);
+        return pdFAIL;
+    }
+
+    if (pxCallback == NULL) {
+        pxCallback = prvReplayCallback;
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    xStart       = std::chrono::steady_clock::now();
+    ullStartTime = ullTimerGetMonotonicTime();
+
+    while (fread(&xRecord, sizeof(xRecord), 1U, pxFile) == 1U) {
+        pxResult->ullRecords++;
+        pxResult->ullCapturedDuration = xRecord.ullTime;
+
+        if (xPaced != pdFALSE) {
+            std::this_thread::sleep_until(xStart + std::chrono::nanoseconds(xRecord.ullTime));
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if (xRecord.cCommand == tmrCAPTURE_CREATE) {
+            if (xTimers.size() <= (size_t)xRecord.ulTimer) {
+                xTimers.resize((size_t)xRecord.ulTimer + 1U, NULL);
+            } else {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            xTimers[xRecord.ulTimer] = xTimerCreate("replay", (TickType_t)xRecord.ulValue,
+                                                    (UBaseType_t)xRecord.ucAutoReload, NULL, pxCallback);
+            if (xTimers[xRecord.ulTimer] == NULL) {
+                pxResult->ullCreatesFailed++;
+            } else {
+                mtCOVERAGE_TEST_MARKER();
+            }
+            continue;
+        }
+
+        if (xRecord.ucResult == (uint8_t)pdFAIL) {
+            pxResult->ullCommandsFailedInCapture++;
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        xTimer = ((size_t)xRecord.ulTimer < xTimers.size()) ? xTimers[xRecord.ulTimer] : NULL;
+        if (xTimer == NULL) {
+            continue;
+        }
+
+        xValue = (prvCommandTakesTickCount((BaseType_t)xRecord.cCommand) != pdFALSE)
+                     ? (TickType_t)(xTimerGetDomainTickCount(xTimer) + (TickType_t)xRecord.ulValue)
+                     : (TickType_t)xRecord.ulValue;
+
+        xHigherPriorityTaskWoken = pdFALSE;
+        xSent = xTimerGenericCommand(xTimer, (BaseType_t)xRecord.cCommand, xValue, &xHigherPriorityTaskWoken,
+                                     (xPaced != pdFALSE) ? (TickType_t)xRecord.ulTicksToWait : portMAX_DELAY);
+
+        if (xSent == pdFAIL) {
+            pxResult->ullCommandsFailed++;
+        } else if (xRecord.cCommand == (int8_t)tmrCOMMAND_DELETE) {
+            xTimers[xRecord.ulTimer] = NULL;
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+
+    pxResult->ullReplayDuration = ullTimerGetMonotonicTime() - ullStartTime;
+    (void)fclose(pxFile);
+
+    for (size_t x = 0U; x < xTimers.size(); x++) {
+        if (xTimers[x] != NULL) {
+            (void)xTimerDelete(xTimers[x], portMAX_DELAY);
+        } else {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+
+    return pdPASS;
+}
+
+#endif /* configUSE_TIMER_CAPTURE */
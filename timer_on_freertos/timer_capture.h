@@ -0,0 +1,112 @@
+#ifndef __TIMER_CAPTURE_H__
+#define __TIMER_CAPTURE_H__
+
+#include "uds.h"
+#include "timer.h"
+
+/*
+ * Capture of the timer API calls made by a running system, and replay of a
+ * capture against the timer service of another build, for measuring changes
+ * to the timer lists and the timer service task with real traffic:
+ *
+ *   xTimerCaptureStart( "timers.capture" );
+ *   ... run the workload ...
+ *   vTimerCaptureStop();
+ *
+ *   xTimerReplay( "timers.capture", pdFALSE, NULL, &xResult );     ... as fast as possible
+ *   xTimerReplay( "timers.capture", pdTRUE, NULL, &xResult );      ... at the pace captured
+ *
+ * Every timer created and every command sent by xTimerGenericCommand() is
+ * written to the file as a TimerCaptureRecord_t, except the restarts the timer
+ * service task sends itself for auto-reload timers.  Timers are numbered in
+ * the order they are first seen, and a timer created before the capture
+ * started gets a create record when its first command is captured.
+ *
+ * The replay recreates the timers in the default domain with pxCallback, or a
+ * callback that does nothing if pxCallback is NULL, and sends the commands
+ * from the calling task.  Paced replays send each command with the block time
+ * it was captured with, while fast replays wait for room in the timer queue.
+ * Start and reset commands are sent relative to the tick count at replay, as
+ * they were at capture.  The timer service task must be running.
+ */
+
+/* The cCommand of a record for a timer being created, other records hold a
+tmrCOMMAND_* value. */
+#define tmrCAPTURE_CREATE ((int8_t)-128)
+
+#define tmrCAPTURE_FILE_MAGIC ((uint32_t)0x50414355U) /* "UCAP" */
+#define tmrCAPTURE_FILE_VERSION ((uint32_t)1U)
+
+/* The start of a capture file, followed by the records in the order the calls
+were made. */
+typedef struct xTIMER_CAPTURE_FILE_HEADER {
+	uint32_t ulMagic;
+	uint32_t ulVersion;
+	uint32_t ulRecordSize;	/*<< sizeof(TimerCaptureRecord_t), checked when the file is read. */
+	uint32_t ulTickRateHz;	/*<< configTICK_RATE_HZ of the captured build. */
+} TimerCaptureFileHeader_t;
+
+/* One timer API call, as held in a capture file. */
+typedef struct xTIMER_CAPTURE_RECORD {
+	uint64_t ullTime;		/*<< Nanoseconds since the capture started. */
+	uint32_t ulTimer;		/*<< The timer, numbered from 0 in the order first seen. */
+	uint32_t ulValue;		/*<< The period of a create, or the value of a command.  For
+							start and reset commands it is taken from the tick count. */
+	uint32_t ulTicksToWait;
+	int8_t   cCommand;
+	uint8_t  ucAutoReload;	/*<< For tmrCAPTURE_CREATE records. */
+	uint8_t  ucResult;		/*<< What xTimerGenericCommand() returned. */
+	uint8_t  ucPadding;
+} TimerCaptureRecord_t;
+
+typedef struct xTIMER_REPLAY_RESULT {
+	uint64_t ullRecords;			/*<< Records replayed. */
+	uint64_t ullCommandsFailed;		/*<< Commands the timer queue did not take. */
+	uint64_t ullCommandsFailedInCapture; /*<< Commands that had failed when captured. */
+	uint64_t ullCreatesFailed;		/*<< Timers that could not be created, whose commands were skipped. */
+	uint64_t ullCapturedDuration;	/*<< Nanoseconds from the first to the last record captured. */
+	uint64_t ullReplayDuration;		/*<< Nanoseconds the replay took. */
+} TimerReplayResult_t;
+
+/*
+ * Start writing the timer API calls to pcFileName, replacing the file.  Fails
+ * if a capture is already running or the file cannot be created.
+ */
+BaseType_t xTimerCaptureStart(const char* const pcFileName);
+
+/* Stop the capture and close the file. */
+void vTimerCaptureStop(void);
+
+/*
+ * Replay pcFileName, pacing the calls as captured if xPaced is pdTRUE.  Returns
+ * once every command has been sent, which for a paced replay is about as long
+ * as the capture ran.  The replayed timers are deleted before returning.
+ */
+BaseType_t xTimerReplay(const char* const pcFileName, const BaseType_t xPaced,
+	TimerCallbackFunction_t pxCallback, TimerReplayResult_t* const pxResult);
+
+/* Called from timer.cpp through the macros below.  vTimerCaptureCommand() is
+called after the command has been sent, when a deleted timer may already have
+been freed, so it is given what it needs of the timer, read before the send,
+and only uses xTimer as a value. */
+void vTimerCaptureCreate(TimerHandle_t xTimer, const TickType_t xPeriod, const UBaseType_t uxAutoReload);
+void vTimerCaptureCommand(TimerHandle_t xTimer, const TickType_t xPeriod, const UBaseType_t uxAutoReload,
+	const TickType_t xTickCount, const BaseType_t xCommandID, const TickType_t xValue,
+	const TickType_t xTicksToWait, const BaseType_t xResult);
+
+#if (configUSE_TIMER_CAPTURE == 1)
+
+#define tmrCAPTURE_CREATE_TIMER( pxTimer ) \
+	vTimerCaptureCreate( ( TimerHandle_t ) ( pxTimer ), ( pxTimer )->xTimerPeriodInTicks, ( pxTimer )->ucAutoReload )
+#define tmrCAPTURE_COMMAND( xTimer, xPeriod, uxAutoReload, xTickCount, xCommandID, xValue, xTicksToWait, xResult ) \
+	vTimerCaptureCommand( ( xTimer ), ( xPeriod ), ( uxAutoReload ), ( xTickCount ), ( xCommandID ), ( xValue ), \
+		( xTicksToWait ), ( xResult ) )
+
+#else
+
+#define tmrCAPTURE_CREATE_TIMER( pxTimer )
+#define tmrCAPTURE_COMMAND( xTimer, xPeriod, uxAutoReload, xTickCount, xCommandID, xValue, xTicksToWait, xResult )
+
+#endif /* configUSE_TIMER_CAPTURE */
+
+#endif
@@ -0,0 +1,120 @@
+#include "uds.h"
+#include "task.h"
+#include "timer.h"
+#include "timer_coroutine.h"
+
+#if defined(__cpp_impl_coroutine)
+
+#include <mutex>
+
+/* The low two bits of TimerAwaitSlot_t::ulState. */
+#define tmrAWAIT_IDLE ((uint32_t)0U)
+#define tmrAWAIT_ARMED ((uint32_t)1U)
+#define tmrAWAIT_CANCELLED ((uint32_t)2U)
+#define tmrAWAIT_STATE_MASK ((uint32_t)3U)
+#define tmrAWAIT_ARMED_INCREMENT ((uint32_t)4U)
+
+/* Slots whose timer is neither running nor about to call back. */
+static TimerAwaitSlot_t *pxFreeAwaitSlots = NULL;
+static std::mutex xAwaitSlotMutex;
+
+static void prvAwaitTimerCallback(TimerHandle_t xTimer);
+static void prvReturnAwaitSlot(TimerAwaitSlot_t *const pxSlot);
+
+static TimerAwaitSlot_t *prvTakeAwaitSlot(void) {
+    TimerAwaitSlot_t *pxSlot;
+
+    {
+        std::lock_guard<std::mutex> xLock(xAwaitSlotMutex);
+
+        pxSlot = pxFreeAwaitSlots;
+        if (pxSlot != NULL) {
+            pxFreeAwaitSlots = pxSlot->pxNextFree;
+        }
+    }
+
+    if (pxSlot == NULL) {
+        /* The pool grows to the largest number of concurrent waits.  The
+        period is replaced each time the slot is armed. */
+        pxSlot = new TimerAwaitSlot_t;
+        pxSlot->ulState.store(tmrAWAIT_IDLE, std::memory_order_relaxed);
+        pxSlot->pxNextFree = NULL;
+        pxSlot->xTimer = xTimerCreate("co_await", 1, pdFALSE, pxSlot, prvAwaitTimerCallback);
+
+        if (pxSlot->xTimer == NULL) {
+            delete pxSlot;
+            pxSlot = NULL;
+        }
+    }
+
+    return pxSlot;
+}
+
+static void prvReturnAwaitSlot(TimerAwaitSlot_t *const pxSlot) {
+    std::lock_guard<std::mutex> xLock(xAwaitSlotMutex);
+
+    pxSlot->pxNextFree = pxFreeAwaitSlots;
+    pxFreeAwaitSlots   = pxSlot;
+}
+
+TimerAwaitSlot_t *pxTimerAwaitArm(const TickType_t xTicks, TimerAwaitFunction_t pxExpiredFunction,
+                                  void *const pvParameter, uint32_t *const pulArmed) {
+    TimerAwaitSlot_t *const pxSlot = prvTakeAwaitSlot();
+    uint32_t ulArmed;
+
+    configASSERT(xTicks > 0);
+
+    if (pxSlot != NULL) {
+        pxSlot->pxExpiredFunction = pxExpiredFunction;
+        pxSlot->pvParameter       = pvParameter;
+
+        /* Only this thread owns an idle slot, so no compare is needed. */
+        ulArmed = (pxSlot->ulState.load(std::memory_order_relaxed) & ~tmrAWAIT_STATE_MASK) +
+                  tmrAWAIT_ARMED_INCREMENT + tmrAWAIT_ARMED;
+        pxSlot->ulState.store(ulArmed, std::memory_order_release);
+        *pulArmed = ulArmed;
+
+        /* Changing the period of a dormant timer also starts it, so arming
+        costs one command. */
+        if (xTimerChangePeriod(pxSlot->xTimer, xTicks, 0) == pdFAIL) {
+            pxSlot->ulState.store(ulArmed & ~tmrAWAIT_STATE_MASK, std::memory_order_relaxed);
+            prvReturnAwaitSlot(pxSlot);
+            return NULL;
+        }
+    }
+
+    return pxSlot;
+}
+
+BaseType_t xTimerAwaitCancel(TimerAwaitSlot_t *const pxSlot, const uint32_t ulArmed) {
+    uint32_t ulExpected = ulArmed;
+
+    /* Lazy - the timer keeps running and the slot is recycled when it
+    expires, which saves a command and a list removal. */
+    return pxSlot->ulState.compare_exchange_strong(ulExpected,
+                                                   (ulArmed & ~tmrAWAIT_STATE_MASK) |
+                                                       tmrAWAIT_CANCELLED,
+                                                   std::memory_order_acq_rel)
+               ? pdTRUE
+               : pdFALSE;
+}
+
+static void prvAwaitTimerCallback(TimerHandle_t xTimer) {
+    TimerAwaitSlot_t *const pxSlot = (TimerAwaitSlot_t *)pvTimerGetTimerID(xTimer);
+    const uint32_t ulState = pxSlot->ulState.exchange(
+        pxSlot->ulState.load(std::memory_order_relaxed) & ~tmrAWAIT_STATE_MASK,
+        std::memory_order_acq_rel);
+    TimerAwaitFunction_t pxExpiredFunction = pxSlot->pxExpiredFunction;
+    void *const pvParameter = pxSlot->pvParameter;
+
+    /* Recycle the slot first, the function may well arm another wait. */
+    prvReturnAwaitSlot(pxSlot);
+
+    if ((ulState & tmrAWAIT_STATE_MASK) == tmrAWAIT_ARMED) {
+        pxExpiredFunction(pvParameter);
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+#endif /* __cpp_impl_coroutine */
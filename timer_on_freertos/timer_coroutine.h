@@ -0,0 +1,342 @@
+#ifndef __TIMER_COROUTINE_H__
+#define __TIMER_COROUTINE_H__
+
+#include "uds.h"
+#include "timer.h"
+
+/*
+ * C++20 coroutine support on top of the timer service.  A protocol handler is
+ * written as a TimerTask<> coroutine and suspends on the timer service instead
+ * of blocking a thread:
+ *
+ *   TimerTask<uint8_t> prvReadResponse( Channel_t *pxChannel );
+ *
+ *   TimerTask<> prvDiagnosticFlow( Channel_t *pxChannel )
+ *   {
+ *       co_await timer_sleep( pdMS_TO_TICKS( 20 ) );
+ *       std::optional<uint8_t> xResponse =
+ *           co_await with_timeout( prvReadResponse( pxChannel ), pdMS_TO_TICKS( 50 ) );
+ *       if( !xResponse ) { ... the P2 timeout expired ... }
+ *   }
+ *
+ *   prvDiagnosticFlow( &xChannel ).vStart();
+ *
+ * Each suspension arms a one-shot timer taken from a pool that grows on
+ * demand and is never freed, so once the pool has reached the number of
+ * concurrent waits no more timers are created.  When the timer expires the
+ * coroutine is resumed on the TimerExecutor given to the awaitable, or
+ * directly on the timer service task if none is given.  Cancelling a wait,
+ * which with_timeout() does when the operation finishes first, is lazy: no
+ * command is sent, the timer is left to expire and is only then returned to
+ * the pool.
+ *
+ * Only compiled when the compiler supports coroutines (__cpp_impl_coroutine).
+ */
+#if defined(__cpp_impl_coroutine)
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Something that can resume a coroutine, for example a thread running an
+ * event loop.  vPost() may be called from the timer service task.
+ */
+class TimerExecutor {
+public:
+    virtual void vPost(std::coroutine_handle<> xCoroutine) = 0;
+
+protected:
+    ~TimerExecutor() = default;
+};
+
+/*
+ * A pooled one-shot timer used for a single wait.  ulState holds the number of
+ * times the slot has been armed, shifted left by two, and one of the
+ * tmrAWAIT_* states, so a late cancel cannot affect a later wait.
+ */
+typedef void (*TimerAwaitFunction_t)(void *pvParameter);
+
+typedef struct tmrTimerAwaitSlot {
+    TimerHandle_t           xTimer;
+    std::atomic<uint32_t>   ulState;
+    TimerAwaitFunction_t    pxExpiredFunction; /*<< Called on the timer service task unless cancelled. */
+    void                   *pvParameter;
+    struct tmrTimerAwaitSlot *pxNextFree;
+} TimerAwaitSlot_t;
+
+/*
+ * Arm a pooled one-shot timer that calls pxExpiredFunction( pvParameter )
+ * after xTicks.  Returns NULL, without calling pxExpiredFunction, if no timer
+ * could be created or the command could not be sent.  *pulArmed identifies
+ * this use of the slot for xTimerAwaitCancel().
+ */
+TimerAwaitSlot_t *pxTimerAwaitArm(const TickType_t xTicks, TimerAwaitFunction_t pxExpiredFunction,
+                                  void *const pvParameter, uint32_t *const pulArmed);
+
+/*
+ * Returns pdTRUE if the wait was cancelled before the timer expired, in which
+ * case pxExpiredFunction will not be called.  Returns pdFALSE if it has
+ * already been called or is about to be.
+ */
+BaseType_t xTimerAwaitCancel(TimerAwaitSlot_t *const pxSlot, const uint32_t ulArmed);
+
+template <typename T = void>
+class TimerTask;
+
+template <typename T>
+class TimerTaskPromiseBase {
+public:
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter_t {
+        bool await_ready() noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> xCoroutine) noexcept {
+            TimerTaskPromiseBase &xPromise = xCoroutine.promise();
+
+            if (xPromise.xContinuation) {
+                return xPromise.xContinuation;
+            }
+
+            /* Started by vStart(), nobody is waiting for the result. */
+            xCoroutine.destroy();
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    FinalAwaiter_t final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { std::terminate(); }
+
+    std::coroutine_handle<> xContinuation;
+};
+
+template <typename T>
+class TimerTaskPromise : public TimerTaskPromiseBase<T> {
+public:
+    TimerTask<T> get_return_object() noexcept;
+    void return_value(T xValue) { xResult.emplace(std::move(xValue)); }
+    T xTakeResult() { return std::move(*xResult); }
+
+    std::optional<T> xResult;
+};
+
+template <>
+class TimerTaskPromise<void> : public TimerTaskPromiseBase<void> {
+public:
+    TimerTask<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+    void xTakeResult() noexcept {}
+};
+
+/*
+ * A lazily started coroutine.  It runs when it is awaited, resuming the
+ * awaiting coroutine when it finishes, or when vStart() is called, after
+ * which it destroys itself when it finishes.
+ */
+template <typename T>
+class TimerTask {
+public:
+    typedef TimerTaskPromise<T> promise_type;
+
+    explicit TimerTask(std::coroutine_handle<promise_type> xCoroutine) noexcept
+        : xCoroutine(xCoroutine) {}
+    TimerTask(TimerTask &&xOther) noexcept : xCoroutine(std::exchange(xOther.xCoroutine, {})) {}
+    TimerTask(const TimerTask &) = delete;
+    TimerTask &operator=(const TimerTask &) = delete;
+
+    ~TimerTask() {
+        if (xCoroutine) {
+            xCoroutine.destroy();
+        }
+    }
+
+    void vStart() { std::exchange(xCoroutine, {}).resume(); }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> xWaiter) noexcept {
+        xCoroutine.promise().xContinuation = xWaiter;
+        return xCoroutine;
+    }
+
+    T await_resume() { return xCoroutine.promise().xTakeResult(); }
+
+private:
+    std::coroutine_handle<promise_type> xCoroutine;
+};
+
+template <typename T>
+TimerTask<T> TimerTaskPromise<T>::get_return_object() noexcept {
+    return TimerTask<T>(std::coroutine_handle<TimerTaskPromise<T>>::from_promise(*this));
+}
+
+inline TimerTask<void> TimerTaskPromise<void>::get_return_object() noexcept {
+    return TimerTask<void>(std::coroutine_handle<TimerTaskPromise<void>>::from_promise(*this));
+}
+
+static inline void prvResumeOn(TimerExecutor *const pxExecutor, std::coroutine_handle<> xCoroutine) {
+    if (pxExecutor != nullptr) {
+        pxExecutor->vPost(xCoroutine);
+    } else {
+        xCoroutine.resume();
+    }
+}
+
+/*
+ * co_await timer_sleep( xTicks ) suspends the coroutine for xTicks ticks.
+ */
+class timer_sleep {
+public:
+    explicit timer_sleep(const TickType_t xTicks, TimerExecutor *const pxExecutor = nullptr) noexcept
+        : xTicks(xTicks), pxExecutor(pxExecutor) {}
+
+    bool await_ready() const noexcept { return xTicks == 0; }
+
+    bool await_suspend(std::coroutine_handle<> xCoroutine) noexcept {
+        uint32_t ulArmed;
+
+        xWaiter = xCoroutine;
+
+        /* If the timer could not be armed carry on rather than never
+        resuming. */
+        return pxTimerAwaitArm(xTicks, &prvExpired, this, &ulArmed) != NULL;
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    static void prvExpired(void *pvParameter) {
+        timer_sleep *const pxSleep = (timer_sleep *)pvParameter;
+        prvResumeOn(pxSleep->pxExecutor, pxSleep->xWaiter);
+    }
+
+    TickType_t              xTicks;
+    TimerExecutor          *pxExecutor;
+    std::coroutine_handle<> xWaiter;
+};
+
+/* with_timeout() produces std::optional<T>, or bool when T is void. */
+template <typename T>
+struct TimerTimeoutResult {
+    typedef std::optional<T> Type_t;
+};
+
+template <>
+struct TimerTimeoutResult<void> {
+    typedef bool Type_t;
+};
+
+/*
+ * co_await with_timeout( xOperation, xTicks ) runs xOperation and produces its
+ * result, or an empty result if xTicks pass first.  An operation that times
+ * out is not interrupted; it runs on to completion and its result is dropped.
+ * With an xTicks of 0 the operation is not started and the result is empty.
+ */
+template <typename T>
+class with_timeout {
+public:
+    typedef typename TimerTimeoutResult<T>::Type_t Result_t;
+
+    with_timeout(TimerTask<T> &&xOperation, const TickType_t xTicks,
+                 TimerExecutor *const pxExecutor = nullptr)
+        : xOperation(std::move(xOperation)), xTicks(xTicks), pxExecutor(pxExecutor) {}
+
+    bool await_ready() const noexcept { return xTicks == 0; }
+
+    void await_suspend(std::coroutine_handle<> xCoroutine) {
+        /* The state is shared with the operation and the timer, either of
+        which can outlive the awaiting coroutine. */
+        State_t *const pxState = new State_t;
+        TimerTask<T>   xStartedOperation(std::move(xOperation));
+
+        pxState->xWaiter    = xCoroutine;
+        pxState->pxExecutor = pxExecutor;
+        pxState->pxResult   = &xResult;
+
+        /* Once armed the timer can expire and resume the awaiting coroutine,
+        destroying this awaiter, so nothing of it is touched from here on. */
+        pxState->pxSlot = pxTimerAwaitArm(xTicks, &prvExpired, pxState, &(pxState->ulArmed));
+
+        if (pxState->pxSlot == NULL) {
+            /* No timeout, so the timer will never drop its reference. */
+            pxState->xRelease(1);
+        }
+
+        prvRunOperation(std::move(xStartedOperation), pxState).vStart();
+    }
+
+    Result_t await_resume() { return std::move(xResult); }
+
+private:
+    struct State_t {
+        std::atomic<uint32_t>   ulReferences{2}; /*<< One for the operation, one for the timer. */
+        std::atomic<bool>       xFinished{false};
+        std::coroutine_handle<> xWaiter;
+        TimerExecutor          *pxExecutor;
+        Result_t               *pxResult;
+        TimerAwaitSlot_t       *pxSlot;
+        uint32_t                ulArmed;
+
+        void xRelease(const uint32_t ulCount) {
+            if (ulReferences.fetch_sub(ulCount, std::memory_order_acq_rel) == ulCount) {
+                delete this;
+            }
+        }
+    };
+
+    static TimerTask<void> prvRunOperation(TimerTask<T> xOperation, State_t *pxState) {
+        if constexpr (std::is_void<T>::value) {
+            co_await xOperation;
+            if (!pxState->xFinished.exchange(true)) {
+                *(pxState->pxResult) = true;
+                prvComplete(pxState);
+            }
+        } else {
+            T xValue = co_await xOperation;
+            if (!pxState->xFinished.exchange(true)) {
+                pxState->pxResult->emplace(std::move(xValue));
+                prvComplete(pxState);
+            }
+        }
+
+        pxState->xRelease(1);
+    }
+
+    static void prvComplete(State_t *const pxState) {
+        /* If the timer is cancelled before it expires prvExpired() will never
+        run to drop its reference, so drop it here. */
+        if ((pxState->pxSlot != NULL) &&
+            (xTimerAwaitCancel(pxState->pxSlot, pxState->ulArmed) != pdFALSE)) {
+            pxState->ulReferences.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        prvResumeOn(pxState->pxExecutor, pxState->xWaiter);
+    }
+
+    static void prvExpired(void *pvParameter) {
+        State_t *const pxState = (State_t *)pvParameter;
+
+        if (!pxState->xFinished.exchange(true)) {
+            /* The result is left empty (or false). */
+            prvResumeOn(pxState->pxExecutor, pxState->xWaiter);
+        }
+
+        pxState->xRelease(1);
+    }
+
+    TimerTask<T>   xOperation;
+    TickType_t     xTicks;
+    TimerExecutor *pxExecutor;
+    Result_t       xResult{};
+};
+
+#endif /* __cpp_impl_coroutine */
+
+#endif
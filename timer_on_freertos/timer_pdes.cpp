@@ -0,0 +1,365 @@
+#include "uds.h"
+
+#if (configUSE_TIMER_PDES == 1)
+
+#if (configUSE_VIRTUAL_TIME == 0)
+    #error configUSE_TIMER_PDES needs configUSE_VIRTUAL_TIME
+#endif
+
+#include "timer.h"
+#include "timer_pdes.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/* The most ticks a domain is advanced by in one xTimerDomainAdvanceTime(), so
+the tick count difference used by ullPdesGetTime() cannot wrap. */
+#define pdesMAX_STEP ((uint64_t)(((TickType_t)~(TickType_t)0U) >> 1))
+
+typedef struct tmrPdesEvent {
+    uint64_t            ullTime;
+    UBaseType_t         uxFrom;
+    uint64_t            ullSequence; /*<< The order in which uxFrom sent its events. */
+    PdesEventFunction_t pxFunction;
+    void *              pvParameter;
+    uint32_t            ulParameter;
+} PdesEvent_t;
+
+/* Orders the inbox earliest first, ties broken so every run agrees. */
+struct PdesEventLater {
+    bool operator()(const PdesEvent_t &xA, const PdesEvent_t &xB) const {
+        if (xA.ullTime != xB.ullTime) {
+            return xA.ullTime > xB.ullTime;
+        }
+        if (xA.uxFrom != xB.uxFrom) {
+            return xA.uxFrom > xB.uxFrom;
+        }
+        return xA.ullSequence > xB.ullSequence;
+    }
+};
+
+typedef struct tmrPdesLogicalProcess {
+    TimerDomainHandle_t xDomain;
+    uint64_t            ullTime;     /*<< The virtual time when the domain tick count was xTickAtTime. */
+    TickType_t          xTickAtTime; /*<< Only changed while the domain is idle. */
+    std::atomic<uint64_t> ullNextSequence;
+    std::mutex          xInboxMutex;
+    std::priority_queue<PdesEvent_t, std::vector<PdesEvent_t>, PdesEventLater> xInbox;
+} PdesLogicalProcess_t;
+
+typedef struct tmrPdesEngine {
+    TickType_t                          xLookahead;
+    uint64_t                            ullTime; /*<< Every process has run up to here. */
+    std::vector<PdesLogicalProcess_t *> xProcesses;
+    std::vector<std::thread *>          xWorkers;
+    UBaseType_t                         uxWorkers;
+
+    /* The window handshake between ullPdesRun() and the workers. */
+    std::mutex              xWindowMutex;
+    std::condition_variable xWindowStarted;
+    std::condition_variable xWindowFinished;
+    uint64_t                ullWindows;    /*<< Counts the windows started. */
+    uint64_t                ullWindowEnd;  /*<< The last tick of the current window. */
+    UBaseType_t             uxWorkersBusy;
+    BaseType_t              xStopping;
+} PdesEngine_t;
+
+static void prvPdesWorker(PdesEngine_t *const pxEngine, const UBaseType_t uxWorker);
+
+/*
+ * Advance pxProcess to ullTime, running the timers due up to then, in steps
+ * of at most pdesMAX_STEP ticks.
+ */
+static void prvAdvanceLogicalProcess(PdesLogicalProcess_t *const pxProcess, const uint64_t ullTime);
+
+/*
+ * Run the events and timers of pxProcess up to and including ullWindowEnd.
+ */
+static void prvRunLogicalProcess(PdesEngine_t *const pxEngine, const UBaseType_t uxProcess,
+                                 const uint64_t ullWindowEnd);
+
+/*
+ * The time of the next timer or event of pxProcess, or UINT64_MAX if it has
+ * neither.  The process must not be running.
+ */
+static uint64_t prvGetNextEventTime(PdesLogicalProcess_t *const pxProcess);
+
+PdesEngineHandle_t xPdesCreate(const UBaseType_t uxWorkers, const TickType_t xLookahead) {
+    PdesEngine_t *pxEngine;
+    UBaseType_t ux;
+
+    configASSERT(uxWorkers > 0U);
+    configASSERT(xLookahead > 0U);
+
+    if ((uxWorkers == 0U) || (xLookahead == 0U)) {
+        return NULL;
+    }
+
+    pxEngine = new (std::nothrow) PdesEngine_t;
+    if (pxEngine == NULL) {
+        return NULL;
+    }
+
+    pxEngine->xLookahead    = xLookahead;
+    pxEngine->ullTime       = 0U;
+    pxEngine->ullWindows    = 0U;
+    pxEngine->ullWindowEnd  = 0U;
+    pxEngine->uxWorkersBusy = 0U;
+    pxEngine->xStopping     = pdFALSE;
+    pxEngine->uxWorkers     = uxWorkers;
+
+    for (ux = 0U; ux < uxWorkers; ux++) {
+        pxEngine->xWorkers.push_back(new std::thread(prvPdesWorker, pxEngine, ux));
+    }
+
+    return (PdesEngineHandle_t)pxEngine;
+}
+
+void vPdesDelete(PdesEngineHandle_t xEngine) {
+    PdesEngine_t *const pxEngine = (PdesEngine_t *)xEngine;
+    size_t x;
+
+    configASSERT(xEngine);
+
+    {
+        std::lock_guard<std::mutex> xLock(pxEngine->xWindowMutex);
+        pxEngine->xStopping = pdTRUE;
+    }
+    pxEngine->xWindowStarted.notify_all();
+
+    for (x = 0U; x < pxEngine->xWorkers.size(); x++) {
+        pxEngine->xWorkers[x]->join();
+        delete pxEngine->xWorkers[x];
+    }
+
+    for (x = 0U; x < pxEngine->xProcesses.size(); x++) {
+        delete pxEngine->xProcesses[x];
+    }
+
+    delete pxEngine;
+}
+
+BaseType_t xPdesAddLogicalProcess(PdesEngineHandle_t xEngine, TimerDomainHandle_t xDomain,
+                                  UBaseType_t *const puxLogicalProcess) {
+    PdesEngine_t *const pxEngine = (PdesEngine_t *)xEngine;
+    PdesLogicalProcess_t *pxProcess;
+
+    configASSERT(xEngine);
+    configASSERT(xDomain);
+    configASSERT(puxLogicalProcess);
+
+    pxProcess = new (std::nothrow) PdesLogicalProcess_t;
+    if (pxProcess == NULL) {
+        return pdFAIL;
+    }
+
+    pxProcess->xDomain     = xDomain;
+    pxProcess->ullTime     = pxEngine->ullTime;
+    pxProcess->xTickAtTime = xTimerDomainGetTickCount(xDomain);
+    pxProcess->ullNextSequence.store(0U, std::memory_order_relaxed);
+
+    *puxLogicalProcess = (UBaseType_t)pxEngine->xProcesses.size();
+    pxEngine->xProcesses.push_back(pxProcess);
+
+    return pdPASS;
+}
+
+uint64_t ullPdesGetTime(PdesEngineHandle_t xEngine, const UBaseType_t uxLogicalProcess) {
+    PdesEngine_t *const pxEngine = (PdesEngine_t *)xEngine;
+    const PdesLogicalProcess_t *pxProcess;
+
+    configASSERT(xEngine);
+    configASSERT(uxLogicalProcess < (UBaseType_t)pxEngine->xProcesses.size());
+
+    pxProcess = pxEngine->xProcesses[uxLogicalProcess];
+    return pxProcess->ullTime +
+           (uint64_t)(TickType_t)(xTimerDomainGetTickCount(pxProcess->xDomain) - pxProcess->xTickAtTime);
+}
+
+BaseType_t xPdesSend(PdesEngineHandle_t xEngine, const UBaseType_t uxFrom, const UBaseType_t uxTo,
+                     const TickType_t xDelay, PdesEventFunction_t pxFunction, void *pvParameter,
+                     uint32_t ulParameter) {
+    PdesEngine_t *const pxEngine = (PdesEngine_t *)xEngine;
+    PdesLogicalProcess_t *pxTo;
+    PdesEvent_t xEvent;
+
+    configASSERT(xEngine);
+    configASSERT(pxFunction);
+
+    /* An event sooner than the lookahead could land in a window another
+    process has already run past. */
+    if ((xDelay < pxEngine->xLookahead) || (uxFrom >= (UBaseType_t)pxEngine->xProcesses.size()) ||
+        (uxTo >= (UBaseType_t)pxEngine->xProcesses.size())) {
+        return pdFAIL;
+    }
+
+    xEvent.ullTime     = ullPdesGetTime(xEngine, uxFrom) + (uint64_t)xDelay;
+    xEvent.uxFrom      = uxFrom;
+    xEvent.ullSequence = pxEngine->xProcesses[uxFrom]->ullNextSequence.fetch_add(1U, std::memory_order_relaxed);
+    xEvent.pxFunction  = pxFunction;
+    xEvent.pvParameter = pvParameter;
+    xEvent.ulParameter = ulParameter;
+
+    pxTo = pxEngine->xProcesses[uxTo];
+    std::lock_guard<std::mutex> xLock(pxTo->xInboxMutex);
+    pxTo->xInbox.push(xEvent);
+
+    return pdPASS;
+}
+
+static void prvAdvanceLogicalProcess(PdesLogicalProcess_t *const pxProcess, const uint64_t ullTime) {
+    uint64_t ullTicksLeft = ullTime - pxProcess->ullTime;
+    uint64_t ullStep;
+
+    configASSERT(ullTime >= pxProcess->ullTime);
+
+    /* Always advance once, even by 0, so the commands sent by the last event
+    are processed before the next. */
+    do {
+        ullStep = (ullTicksLeft < pdesMAX_STEP) ? ullTicksLeft : pdesMAX_STEP;
+
+        (void)xTimerDomainAdvanceTime(pxProcess->xDomain, (TickType_t)ullStep);
+
+        /* The domain is idle, so its callbacks are not reading these. */
+        pxProcess->ullTime += ullStep;
+        pxProcess->xTickAtTime += (TickType_t)ullStep;
+        ullTicksLeft -= ullStep;
+    } while (ullTicksLeft > 0U);
+}
+
+static void prvRunLogicalProcess(PdesEngine_t *const pxEngine, const UBaseType_t uxProcess,
+                                 const uint64_t ullWindowEnd) {
+    PdesLogicalProcess_t *const pxProcess = pxEngine->xProcesses[uxProcess];
+    PdesEvent_t xEvent;
+
+    for (;;) {
+        {
+            /* Events sent during this window are all for later windows, so
+            the head of the inbox cannot change under us. */
+            std::lock_guard<std::mutex> xLock(pxProcess->xInboxMutex);
+
+            if (pxProcess->xInbox.empty() || (pxProcess->xInbox.top().ullTime > ullWindowEnd)) {
+                break;
+            }
+
+            xEvent = pxProcess->xInbox.top();
+            pxProcess->xInbox.pop();
+        }
+
+        /* The timers due on the tick of the event run first. */
+        prvAdvanceLogicalProcess(pxProcess, xEvent.ullTime);
+        xEvent.pxFunction(uxProcess, xEvent.pvParameter, xEvent.ulParameter);
+    }
+
+    prvAdvanceLogicalProcess(pxProcess, ullWindowEnd);
+}
+
+static void prvPdesWorker(PdesEngine_t *const pxEngine, const UBaseType_t uxWorker) {
+    const UBaseType_t uxWorkers = pxEngine->uxWorkers;
+    uint64_t ullWindowsSeen = 0U;
+    uint64_t ullWindowEnd;
+    UBaseType_t uxProcess, uxProcesses;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> xLock(pxEngine->xWindowMutex);
+            pxEngine->xWindowStarted.wait(xLock, [pxEngine, ullWindowsSeen] {
+                return (pxEngine->xStopping != pdFALSE) || (pxEngine->ullWindows != ullWindowsSeen);
+            });
+
+            if (pxEngine->xStopping != pdFALSE) {
+                return;
+            }
+
+            ullWindowsSeen = pxEngine->ullWindows;
+            ullWindowEnd   = pxEngine->ullWindowEnd;
+            uxProcesses    = (UBaseType_t)pxEngine->xProcesses.size();
+        }
+
+        /* The processes are dealt out to the workers in turn. */
+        for (uxProcess = uxWorker; uxProcess < uxProcesses; uxProcess += uxWorkers) {
+            prvRunLogicalProcess(pxEngine, uxProcess, ullWindowEnd);
+        }
+
+        {
+            std::lock_guard<std::mutex> xLock(pxEngine->xWindowMutex);
+            pxEngine->uxWorkersBusy--;
+            if (pxEngine->uxWorkersBusy == 0U) {
+                pxEngine->xWindowFinished.notify_one();
+            } else {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+    }
+}
+
+static uint64_t prvGetNextEventTime(PdesLogicalProcess_t *const pxProcess) {
+    uint64_t ullNext = UINT64_MAX;
+    TickType_t xWakeTick;
+
+    if (xTimerDomainGetNextWake(pxProcess->xDomain, &xWakeTick) != pdFALSE) {
+        ullNext = pxProcess->ullTime + (uint64_t)(TickType_t)(xWakeTick - pxProcess->xTickAtTime);
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    std::lock_guard<std::mutex> xLock(pxProcess->xInboxMutex);
+    if ((pxProcess->xInbox.empty() == false) && (pxProcess->xInbox.top().ullTime < ullNext)) {
+        ullNext = pxProcess->xInbox.top().ullTime;
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return ullNext;
+}
+
+uint64_t ullPdesRun(PdesEngineHandle_t xEngine, const uint64_t ullEndTime) {
+    PdesEngine_t *const pxEngine = (PdesEngine_t *)xEngine;
+    uint64_t ullWindows = 0U;
+    uint64_t ullEarliest, ullNext, ullWindowEnd;
+    UBaseType_t uxProcess;
+
+    configASSERT(xEngine);
+
+    while (pxEngine->ullTime < ullEndTime) {
+        ullEarliest = UINT64_MAX;
+        for (uxProcess = 0U; uxProcess < (UBaseType_t)pxEngine->xProcesses.size(); uxProcess++) {
+            ullNext = prvGetNextEventTime(pxEngine->xProcesses[uxProcess]);
+            if (ullNext < ullEarliest) {
+                ullEarliest = ullNext;
+            } else {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+
+        /* Nothing can arrive anywhere before ullEarliest + xLookahead, so every
+        process can run to just before it.  Stretches with nothing due are
+        passed in the same window. */
+        if ((ullEarliest >= ullEndTime) || ((ullEndTime - ullEarliest) < (uint64_t)pxEngine->xLookahead)) {
+            ullWindowEnd = ullEndTime;
+        } else {
+            ullWindowEnd = ullEarliest + (uint64_t)pxEngine->xLookahead - 1U;
+        }
+
+        {
+            std::unique_lock<std::mutex> xLock(pxEngine->xWindowMutex);
+            pxEngine->ullWindowEnd  = ullWindowEnd;
+            pxEngine->uxWorkersBusy = pxEngine->uxWorkers;
+            pxEngine->ullWindows++;
+            pxEngine->xWindowStarted.notify_all();
+            pxEngine->xWindowFinished.wait(xLock, [pxEngine] { return pxEngine->uxWorkersBusy == 0U; });
+        }
+
+        pxEngine->ullTime = ullWindowEnd;
+        ullWindows++;
+    }
+
+    return ullWindows;
+}
+
+#endif /* configUSE_TIMER_PDES */
@@ -0,0 +1,79 @@
+#ifndef __TIMER_PDES_H__
+#define __TIMER_PDES_H__
+
+#include "uds.h"
+#include "timer.h"
+
+/*
+ * A conservative parallel discrete event engine for simulating networks of
+ * ECUs on virtual time (configUSE_VIRTUAL_TIME) across all the cores of a
+ * machine:
+ *
+ *   xEngine = xPdesCreate( uxCores, xBusLatencyTicks );
+ *   for each partition of the network
+ *   {
+ *       xDomain = xTimerDomainCreate( &xParameters );      ... ulTickRateHz of 0
+ *       xTimerDomainStart( xDomain );
+ *       xPdesAddLogicalProcess( xEngine, xDomain, &uxPartition );
+ *       ... create and start the timers of its ECUs with xTimerCreateInDomain() ...
+ *   }
+ *   ullPdesRun( xEngine, ullEndOfTest );
+ *
+ * Each logical process is a timer domain, so has a timer service task and a
+ * virtual clock of its own.  Processes only affect each other through events
+ * sent with xPdesSend(), which arrive at least xLookahead ticks after they are
+ * sent, typically the least latency of the bus between two partitions.  That
+ * makes every process safe to run xLookahead ticks ahead of the earliest
+ * pending event anywhere, so the engine runs in windows: it finds the earliest
+ * event, lets the worker threads advance their processes in parallel to the
+ * end of the window, waits for all of them and starts the next.  Idle
+ * stretches are skipped in one window.
+ *
+ * The domains, and so the timer service tasks, are limited by
+ * configTIMER_MAX_DOMAINS, so a process normally holds many ECUs, each with
+ * its own timers in the domain.  Events for a process are run on its worker
+ * thread while its timer service task is idle, after the timers due on the
+ * same tick, in the order of time, sending process and sending order, so a
+ * run gives the same result every time.
+ */
+
+typedef struct tmrPdesEngine* PdesEngineHandle_t;
+
+/* Run by the engine when an event sent with xPdesSend() arrives. */
+typedef void (*PdesEventFunction_t)(UBaseType_t uxLogicalProcess, void* pvParameter, uint32_t ulParameter);
+
+/*
+ * Create an engine with uxWorkers threads, whose events take at least
+ * xLookahead ticks, which must not be 0, to arrive.  Returns NULL if it cannot
+ * be created.
+ */
+PdesEngineHandle_t xPdesCreate(const UBaseType_t uxWorkers, const TickType_t xLookahead);
+
+/*
+ * Add the started domain xDomain as a logical process, at time 0, writing its
+ * number, counted from 0, to *puxLogicalProcess.  Processes cannot be added
+ * while ullPdesRun() runs.
+ */
+BaseType_t xPdesAddLogicalProcess(PdesEngineHandle_t xEngine, TimerDomainHandle_t xDomain,
+	UBaseType_t* const puxLogicalProcess);
+
+/* The virtual time of a logical process in ticks.  Callable from its callbacks and events. */
+uint64_t ullPdesGetTime(PdesEngineHandle_t xEngine, const UBaseType_t uxLogicalProcess);
+
+/*
+ * Send an event from the callbacks or events of uxFrom, to run on uxTo xDelay
+ * ticks from now.  Fails if xDelay is less than the lookahead of the engine.
+ */
+BaseType_t xPdesSend(PdesEngineHandle_t xEngine, const UBaseType_t uxFrom, const UBaseType_t uxTo,
+	const TickType_t xDelay, PdesEventFunction_t pxFunction, void* pvParameter, uint32_t ulParameter);
+
+/*
+ * Run every logical process up to and including ullEndTime.  Can be called
+ * again to continue.  Returns the number of windows run.
+ */
+uint64_t ullPdesRun(PdesEngineHandle_t xEngine, const uint64_t ullEndTime);
+
+/* Stop the worker threads and free the engine.  The domains are left as they are. */
+void vPdesDelete(PdesEngineHandle_t xEngine);
+
+#endif
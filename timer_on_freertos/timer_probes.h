@@ -0,0 +1,67 @@
+#ifndef __TIMER_PROBES_H__
+#define __TIMER_PROBES_H__
+
+/*
+ * USDT probes at the trace hook sites, for attaching perf, bpftrace or
+ * SystemTap to a running process without rebuilding it, for example:
+ *
+ *   bpftrace -e 'usdt:./uds:uds:timer_expired { @lateness_ticks = lhist(arg2, 0, 10, 1); }'
+ *   perf probe -x ./uds sdt_uds:command_send && perf record -e sdt_uds:command_send ...
+ *
+ * Each probe compiles to a single nop plus a note in the ELF file describing
+ * where its arguments are, so costs nothing while no tracer is attached.  They
+ * are included when configUSE_TIMER_PROBES is 1, which needs <sys/sdt.h> from
+ * SystemTap (systemtap-sdt-dev or systemtap-sdt-devel) and is the default on
+ * Linux when that header is installed.  Build with configUSE_TIMER_PROBES=0
+ * to leave them out.  The probes of
+ * provider "uds" and their arguments are:
+ *
+ *   timer_create      timer, period in ticks
+ *   command_send      timer, command ID, command value, pdPASS if it was queued
+ *   command_received  timer, command ID, command value
+ *   timer_expired     timer, tick it was due at, ticks late
+ *   callback_entry    timer
+ *   callback_return   timer
+ *   queue_create      queue, length, item size
+ *   tick              tick count
+ */
+
+#if (configUSE_TIMER_PROBES == 1)
+
+#ifdef _WIN32
+    #error configUSE_TIMER_PROBES needs <sys/sdt.h>, which is not available on Windows
+#endif
+
+#include <sys/sdt.h>
+
+#define tmrPROBE_TIMER_CREATE( pvTimer, xPeriod ) \
+	DTRACE_PROBE2( uds, timer_create, ( pvTimer ), ( uint32_t ) ( xPeriod ) )
+#define tmrPROBE_COMMAND_SEND( pvTimer, xCommandID, xValue, xResult ) \
+	DTRACE_PROBE4( uds, command_send, ( pvTimer ), ( int32_t ) ( xCommandID ), ( uint32_t ) ( xValue ), ( int32_t ) ( xResult ) )
+#define tmrPROBE_COMMAND_RECEIVED( pvTimer, xCommandID, xValue ) \
+	DTRACE_PROBE3( uds, command_received, ( pvTimer ), ( int32_t ) ( xCommandID ), ( uint32_t ) ( xValue ) )
+#define tmrPROBE_TIMER_EXPIRED( pvTimer, xExpiryTime, xLateness ) \
+	DTRACE_PROBE3( uds, timer_expired, ( pvTimer ), ( uint32_t ) ( xExpiryTime ), ( uint32_t ) ( xLateness ) )
+#define tmrPROBE_CALLBACK_ENTRY( pvTimer ) \
+	DTRACE_PROBE1( uds, callback_entry, ( pvTimer ) )
+#define tmrPROBE_CALLBACK_RETURN( pvTimer ) \
+	DTRACE_PROBE1( uds, callback_return, ( pvTimer ) )
+#define queuePROBE_CREATE( pvQueue, uxLength, uxItemSize ) \
+	DTRACE_PROBE3( uds, queue_create, ( pvQueue ), ( uint32_t ) ( uxLength ), ( uint32_t ) ( uxItemSize ) )
+#define taskPROBE_TICK( xTickCount ) \
+	DTRACE_PROBE1( uds, tick, ( uint32_t ) ( xTickCount ) )
+
+#else
+
+#define tmrPROBE_TIMER_CREATE( pvTimer, xPeriod )
+#define tmrPROBE_COMMAND_SEND( pvTimer, xCommandID, xValue, xResult )
+#define tmrPROBE_COMMAND_RECEIVED( pvTimer, xCommandID, xValue )
+#define tmrPROBE_TIMER_EXPIRED( pvTimer, xExpiryTime, xLateness )
+#define tmrPROBE_CALLBACK_ENTRY( pvTimer )
+#define tmrPROBE_CALLBACK_RETURN( pvTimer )
+#define queuePROBE_CREATE( pvQueue, uxLength, uxItemSize )
+#define taskPROBE_TICK( xTickCount )
+
+#endif /* configUSE_TIMER_PROBES */
+
+#endif
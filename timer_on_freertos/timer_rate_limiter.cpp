@@ -0,0 +1,357 @@
+#include "uds.h"
+#include "task.h"
+#include "timer.h"
+#include "timer_rate_limiter.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+
+#define tmrNANOSECONDS_PER_SECOND ((uint64_t)1000000000U)
+
+/* A call to xRateLimiterAcquire() waiting for tokens. */
+typedef struct tmrRateLimiterRequest {
+    uint32_t                   ulTokens;
+    RateLimiterGrantFunction_t pxGrantFunction;
+    void *                     pvParameter;
+} RateLimiterRequest_t;
+
+typedef struct tmrRateLimiter {
+    std::atomic<uint32_t>    ulTokens;
+    std::atomic<UBaseType_t> uxPending; /*<< Requests waiting, read without the lock by
+                                           xRateLimiterTryAcquire() so it cannot jump the queue. */
+    std::atomic<bool>        xDeleted;
+    uint32_t                 ulTokensPerSecond;
+    uint32_t                 ulBucketSize;
+    uint64_t                 ullCredit; /*<< The part of a token earned but not yet added, in tokens
+                                           times nanoseconds.  Only used by the timer service
+                                           task. */
+
+    std::mutex            xRequestMutex; /*<< Guards the ring of waiting requests. */
+    RateLimiterRequest_t *pxRequests;
+    UBaseType_t           uxMaxPending;
+    UBaseType_t           uxFirstPending;
+
+    struct tmrRateLimiter *pxNext; /*<< Only changed by the timer service task once linked. */
+} RateLimiter_t;
+
+/* Every limiter, newest first.  New limiters are pushed on the front under the
+mutex, only the timer service task unlinks them, so it can walk the list it
+has seen without holding the mutex. */
+static RateLimiter_t *pxRateLimiters = NULL;
+static std::mutex xRateLimiterListMutex;
+
+static TimerHandle_t xRefillTimer = NULL;
+static std::atomic<bool> xRefillTimerRunning(false);
+static std::atomic<uint64_t> ullLastRefillTime(0U);
+
+static void prvRefillRateLimiters(TimerHandle_t xTimer);
+
+/* When the buckets were last refilled.  Virtual time only moves the tick
+count, so then it is measured in ticks of the refill timer's domain. */
+static uint64_t prvGetRefillTime(void) {
+#if (configUSE_VIRTUAL_TIME == 1)
+    return (uint64_t)xTimerGetDomainTickCount(xRefillTimer);
+#else
+    return ullTimerGetMonotonicTime();
+#endif
+}
+
+/* The nanoseconds from ullLastRefill to ullTimeNow, both from
+prvGetRefillTime(). */
+static uint64_t prvGetRefillElapsed(const uint64_t ullTimeNow, const uint64_t ullLastRefill) {
+#if (configUSE_VIRTUAL_TIME == 1)
+    /* As a tick count, so it wrapping is handled. */
+    return ((uint64_t)(TickType_t)(ullTimeNow - ullLastRefill) * tmrNANOSECONDS_PER_SECOND) /
+           (uint64_t)configTICK_RATE_HZ;
+#else
+    return ullTimeNow - ullLastRefill;
+#endif
+}
+
+static BaseType_t prvTakeTokens(RateLimiter_t *const pxLimiter, const uint32_t ulTokens) {
+    uint32_t ulAvailable = pxLimiter->ulTokens.load(std::memory_order_relaxed);
+
+    do {
+        if (ulAvailable < ulTokens) {
+            return pdFAIL;
+        }
+    } while (!pxLimiter->ulTokens.compare_exchange_weak(ulAvailable, ulAvailable - ulTokens,
+                                                        std::memory_order_acq_rel));
+
+    return pdPASS;
+}
+
+static void prvStartRefillTimer(void) {
+    if (!xRefillTimerRunning.exchange(true)) {
+        /* The buckets were full while the timer was stopped, so time only
+        counts from now. */
+        ullLastRefillTime.store(prvGetRefillTime(), std::memory_order_relaxed);
+
+        if (xTimerStart(xRefillTimer, (TickType_t)0U) == pdFAIL) {
+            /* Let the next caller try again. */
+            xRefillTimerRunning.store(false);
+        }
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+RateLimiterHandle_t xRateLimiterCreate(const uint32_t ulTokensPerSecond,
+                                       const uint32_t ulBucketSize,
+                                       const UBaseType_t uxMaxPending) {
+    RateLimiter_t *pxLimiter;
+
+    configASSERT(ulTokensPerSecond > 0U);
+    configASSERT(ulBucketSize > 0U);
+
+    pxLimiter = new (std::nothrow) RateLimiter_t;
+    if (pxLimiter == NULL) {
+        return NULL;
+    }
+
+    pxLimiter->ulTokens.store(ulBucketSize, std::memory_order_relaxed);
+    pxLimiter->uxPending.store(0U, std::memory_order_relaxed);
+    pxLimiter->xDeleted.store(false, std::memory_order_relaxed);
+    pxLimiter->ulTokensPerSecond = ulTokensPerSecond;
+    pxLimiter->ulBucketSize      = ulBucketSize;
+    pxLimiter->ullCredit         = 0U;
+    pxLimiter->uxMaxPending      = uxMaxPending;
+    pxLimiter->uxFirstPending    = 0U;
+    pxLimiter->pxRequests        = NULL;
+
+    if (uxMaxPending > (UBaseType_t)0U) {
+        pxLimiter->pxRequests = new (std::nothrow) RateLimiterRequest_t[uxMaxPending];
+        if (pxLimiter->pxRequests == NULL) {
+            delete pxLimiter;
+            return NULL;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> xLock(xRateLimiterListMutex);
+
+        if (xRefillTimer == NULL) {
+            xRefillTimer = xTimerCreate("RateLimit", (TickType_t)configRATE_LIMITER_REFILL_TICKS,
+                                        pdTRUE, NULL, prvRefillRateLimiters);
+        }
+
+        if (xRefillTimer != NULL) {
+            pxLimiter->pxNext = pxRateLimiters;
+            pxRateLimiters    = pxLimiter;
+        } else {
+            delete[] pxLimiter->pxRequests;
+            delete pxLimiter;
+            pxLimiter = NULL;
+        }
+    }
+
+    /* The bucket starts full, so the refill timer is not needed yet. */
+    return pxLimiter;
+}
+
+void vRateLimiterDelete(RateLimiterHandle_t xLimiter) {
+    RateLimiter_t *const pxLimiter = (RateLimiter_t *)xLimiter;
+
+    configASSERT(xLimiter);
+
+    pxLimiter->xDeleted.store(true);
+
+    /* Make sure the timer service task runs to free it. */
+    prvStartRefillTimer();
+}
+
+BaseType_t xRateLimiterTryAcquire(RateLimiterHandle_t xLimiter, const uint32_t ulTokens) {
+    RateLimiter_t *const pxLimiter = (RateLimiter_t *)xLimiter;
+
+    configASSERT(xLimiter);
+
+    if (pxLimiter->uxPending.load(std::memory_order_acquire) != (UBaseType_t)0U) {
+        /* Earlier callers of xRateLimiterAcquire() come first. */
+        return pdFAIL;
+    }
+
+    if (prvTakeTokens(pxLimiter, ulTokens) == pdFAIL) {
+        return pdFAIL;
+    }
+
+    prvStartRefillTimer();
+    return pdPASS;
+}
+
+BaseType_t xRateLimiterAcquire(RateLimiterHandle_t xLimiter, const uint32_t ulTokens,
+                               RateLimiterGrantFunction_t pxGrantFunction, void *pvParameter) {
+    RateLimiter_t *const pxLimiter = (RateLimiter_t *)xLimiter;
+    RateLimiterRequest_t *pxRequest;
+
+    configASSERT(xLimiter);
+    configASSERT(pxGrantFunction);
+
+    if (ulTokens > pxLimiter->ulBucketSize) {
+        /* Could never be granted. */
+        return pdFAIL;
+    }
+
+    if (xRateLimiterTryAcquire(xLimiter, ulTokens) != pdFAIL) {
+        return tmrRATE_ACQUIRED;
+    }
+
+    {
+        std::lock_guard<std::mutex> xLock(pxLimiter->xRequestMutex);
+        const UBaseType_t uxPending = pxLimiter->uxPending.load(std::memory_order_relaxed);
+
+        if (uxPending >= pxLimiter->uxMaxPending) {
+            return pdFAIL;
+        }
+
+        pxRequest = &(pxLimiter->pxRequests[(pxLimiter->uxFirstPending + uxPending) %
+                                             pxLimiter->uxMaxPending]);
+        pxRequest->ulTokens        = ulTokens;
+        pxRequest->pxGrantFunction = pxGrantFunction;
+        pxRequest->pvParameter     = pvParameter;
+        pxLimiter->uxPending.store(uxPending + 1U, std::memory_order_release);
+    }
+
+    prvStartRefillTimer();
+    return tmrRATE_PENDING;
+}
+
+uint32_t ulRateLimiterGetTokens(const RateLimiterHandle_t xLimiter) {
+    configASSERT(xLimiter);
+    return ((const RateLimiter_t *)xLimiter)->ulTokens.load(std::memory_order_relaxed);
+}
+
+static void prvRefillBucket(RateLimiter_t *const pxLimiter, const uint64_t ullElapsed) {
+    uint32_t ulAvailable = pxLimiter->ulTokens.load(std::memory_order_relaxed);
+    uint32_t ulNewTokens;
+    uint64_t ullAdd;
+
+    if (ulAvailable >= pxLimiter->ulBucketSize) {
+        pxLimiter->ullCredit = 0U;
+        return;
+    }
+
+    if (ullElapsed > ((((uint64_t)pxLimiter->ulBucketSize * tmrNANOSECONDS_PER_SECOND) /
+                       pxLimiter->ulTokensPerSecond) + 1U)) {
+        /* Long enough to fill any bucket, and the product below could
+        overflow. */
+        ullAdd               = pxLimiter->ulBucketSize;
+        pxLimiter->ullCredit = 0U;
+    } else {
+        pxLimiter->ullCredit += (uint64_t)pxLimiter->ulTokensPerSecond * ullElapsed;
+        ullAdd               = pxLimiter->ullCredit / tmrNANOSECONDS_PER_SECOND;
+        pxLimiter->ullCredit = pxLimiter->ullCredit % tmrNANOSECONDS_PER_SECOND;
+    }
+
+    /* Other tasks only ever take tokens, so only the clamp can race. */
+    do {
+        ulNewTokens = ((uint64_t)ulAvailable + ullAdd >= pxLimiter->ulBucketSize)
+                          ? pxLimiter->ulBucketSize
+                          : (uint32_t)(ulAvailable + ullAdd);
+    } while (!pxLimiter->ulTokens.compare_exchange_weak(ulAvailable, ulNewTokens,
+                                                        std::memory_order_acq_rel));
+}
+
+static void prvGrantPendingRequests(RateLimiter_t *const pxLimiter) {
+    RateLimiterRequest_t xRequest;
+    BaseType_t xGranted;
+
+    do {
+        xGranted = pdFALSE;
+
+        {
+            std::lock_guard<std::mutex> xLock(pxLimiter->xRequestMutex);
+            const UBaseType_t uxPending = pxLimiter->uxPending.load(std::memory_order_relaxed);
+
+            if ((uxPending > (UBaseType_t)0U) &&
+                (prvTakeTokens(pxLimiter,
+                               pxLimiter->pxRequests[pxLimiter->uxFirstPending].ulTokens) != pdFAIL)) {
+                xRequest = pxLimiter->pxRequests[pxLimiter->uxFirstPending];
+                pxLimiter->uxFirstPending = (pxLimiter->uxFirstPending + 1U) % pxLimiter->uxMaxPending;
+                pxLimiter->uxPending.store(uxPending - 1U, std::memory_order_release);
+                xGranted = pdTRUE;
+            }
+        }
+
+        /* Called without the lock so it can acquire again. */
+        if (xGranted != pdFALSE) {
+            xRequest.pxGrantFunction((RateLimiterHandle_t)pxLimiter, xRequest.pvParameter);
+        }
+    } while (xGranted != pdFALSE);
+}
+
+static BaseType_t prvRateLimitersAreIdle(void) {
+    RateLimiter_t *pxLimiter;
+
+    {
+        std::lock_guard<std::mutex> xLock(xRateLimiterListMutex);
+        pxLimiter = pxRateLimiters;
+    }
+
+    for (; pxLimiter != NULL; pxLimiter = pxLimiter->pxNext) {
+        if ((pxLimiter->xDeleted.load() != false) ||
+            (pxLimiter->ulTokens.load() < pxLimiter->ulBucketSize) ||
+            (pxLimiter->uxPending.load() != (UBaseType_t)0U)) {
+            return pdFALSE;
+        }
+    }
+
+    return pdTRUE;
+}
+
+static void prvRefillRateLimiters(TimerHandle_t xTimer) {
+    const uint64_t ullTimeNow = prvGetRefillTime();
+    const uint64_t ullElapsed = prvGetRefillElapsed(ullTimeNow, ullLastRefillTime.exchange(ullTimeNow));
+    RateLimiter_t **ppxLimiter;
+    RateLimiter_t *pxLimiter;
+    RateLimiter_t *pxDeleted = NULL;
+    RateLimiter_t *pxFirst;
+
+    {
+        std::lock_guard<std::mutex> xLock(xRateLimiterListMutex);
+
+        ppxLimiter = &pxRateLimiters;
+        while (*ppxLimiter != NULL) {
+            pxLimiter = *ppxLimiter;
+
+            if (pxLimiter->xDeleted.load() != false) {
+                *ppxLimiter       = pxLimiter->pxNext;
+                pxLimiter->pxNext = pxDeleted;
+                pxDeleted         = pxLimiter;
+            } else {
+                prvRefillBucket(pxLimiter, ullElapsed);
+                ppxLimiter = &(pxLimiter->pxNext);
+            }
+        }
+
+        pxFirst = pxRateLimiters;
+    }
+
+    while (pxDeleted != NULL) {
+        pxLimiter = pxDeleted;
+        pxDeleted = pxDeleted->pxNext;
+        delete[] pxLimiter->pxRequests;
+        delete pxLimiter;
+    }
+
+    /* One refill can grant any number of waiting requests. */
+    for (pxLimiter = pxFirst; pxLimiter != NULL; pxLimiter = pxLimiter->pxNext) {
+        prvGrantPendingRequests(pxLimiter);
+    }
+
+    if (prvRateLimitersAreIdle() != pdFALSE) {
+        /* Stop before clearing the flag, so a start sent by a task that sees
+        the flag clear is queued behind the stop. */
+        if (xTimerStop(xTimer, (TickType_t)0U) != pdFAIL) {
+            xRefillTimerRunning.store(false);
+
+            /* A token taken while the flag was still set did not start the
+            timer, so look again. */
+            if (prvRateLimitersAreIdle() == pdFALSE) {
+                prvStartRefillTimer();
+            }
+        }
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef __TIMER_RATE_LIMITER_H__
+#define __TIMER_RATE_LIMITER_H__
+
+#include "uds.h"
+#include "timer.h"
+
+/*
+ * Token bucket rate limiters for pacing traffic, for example the STmin between
+ * consecutive frames or a maximum number of bytes per second:
+ *
+ *   xFrames = xRateLimiterCreate( 1000 / ucSTmin, 1, 8 );
+ *   xBytes = xRateLimiterCreate( 4096, 1024, 8 );
+ *
+ *   if( xRateLimiterTryAcquire( xBytes, xLength ) == pdPASS ) { ... send now ... }
+ *
+ *   if( xRateLimiterAcquire( xFrames, 1, prvSendNextFrame, pxChannel ) == tmrRATE_ACQUIRED )
+ *   {
+ *       prvSendNextFrame( xFrames, pxChannel );
+ *   }
+ *
+ * A bucket holds up to ulBucketSize tokens and is refilled at
+ * ulTokensPerSecond.  Every limiter is refilled by one shared auto-reload timer
+ * every configRATE_LIMITER_REFILL_TICKS ticks, which also hands tokens to the
+ * waiting acquirers, as many as the bucket allows in each refill, oldest
+ * first.  The shared timer is stopped while every bucket is full and nobody is
+ * waiting, so idle limiters cost no wake ups.  Buckets start full.  With
+ * configUSE_VIRTUAL_TIME the refills follow the tick count rather than the
+ * monotonic clock.
+ */
+typedef void* RateLimiterHandle_t;
+
+/*
+ * Called on the timer service task once the tokens asked for by
+ * xRateLimiterAcquire() have been taken from the bucket.
+ */
+typedef void (*RateLimiterGrantFunction_t)(RateLimiterHandle_t xLimiter, void* pvParameter);
+
+/* Values returned by xRateLimiterAcquire() as well as pdFAIL. */
+#define tmrRATE_ACQUIRED ((BaseType_t)1)
+#define tmrRATE_PENDING ((BaseType_t)2)
+
+/*
+ * Up to uxMaxPending calls to xRateLimiterAcquire() can wait at once.  Returns
+ * NULL if the memory or the shared timer could not be allocated.
+ */
+RateLimiterHandle_t xRateLimiterCreate(const uint32_t ulTokensPerSecond,
+	const uint32_t ulBucketSize,
+	const UBaseType_t uxMaxPending);
+
+/*
+ * The limiter is freed by the timer service task on its next refill.  Grant
+ * functions still waiting are not called.
+ */
+void vRateLimiterDelete(RateLimiterHandle_t xLimiter);
+
+/*
+ * Take ulTokens tokens if the bucket holds that many and nobody is waiting,
+ * without blocking or locking.  Returns pdPASS if they were taken.
+ */
+BaseType_t xRateLimiterTryAcquire(RateLimiterHandle_t xLimiter, const uint32_t ulTokens);
+
+/*
+ * Take ulTokens tokens now if xRateLimiterTryAcquire() would, returning
+ * tmrRATE_ACQUIRED without calling pxGrantFunction.  Otherwise queue the
+ * request and return tmrRATE_PENDING; pxGrantFunction( xLimiter, pvParameter )
+ * is called on the timer service task once the tokens have been taken.
+ * Returns pdFAIL if ulTokens is larger than the bucket or uxMaxPending
+ * requests are already waiting.
+ */
+BaseType_t xRateLimiterAcquire(RateLimiterHandle_t xLimiter, const uint32_t ulTokens,
+	RateLimiterGrantFunction_t pxGrantFunction, void* pvParameter);
+
+uint32_t ulRateLimiterGetTokens(const RateLimiterHandle_t xLimiter);
+
+#endif
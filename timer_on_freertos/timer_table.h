@@ -0,0 +1,71 @@
+#ifndef __TIMER_TABLE_H__
+#define __TIMER_TABLE_H__
+
+#include <stddef.h>
+#include "uds.h"
+#include "timer.h"
+
+/*
+ * Compile time construction of the tables used by xTimerCreateStaticTable().
+ * The definitions are kept in read only data, and the order in which the
+ * auto-start timers are linked into the active timer list is worked out by the
+ * compiler, so creating the whole table at startup is a single pass over the
+ * timer buffers with no allocation and no timer commands:
+ *
+ *   static constexpr TimerDefinition_t xTimerDefinitions[] = {
+ *       { "P2", pdMS_TO_TICKS( 50 ), pdFALSE, NULL, prvP2Callback, pdFALSE },
+ *       { "TesterPresent", pdMS_TO_TICKS( 2000 ), pdTRUE, NULL, prvTesterPresent, pdTRUE },
+ *   };
+ *   static constexpr auto xTimerTable = xMakeTimerTable( xTimerDefinitions );
+ *   static StaticTimer_t xTimerBuffers[ xTimerTable.uxNumberOfTimers ];
+ *   static TimerHandle_t xTimers[ xTimerTable.uxNumberOfTimers ];
+ *
+ *   xTimerCreateTable( xTimerTable, xTimerBuffers, xTimers );
+ *   CreateTimerManageTask();
+ */
+template <size_t N>
+struct TimerTable_t {
+    static constexpr UBaseType_t uxNumberOfTimers = (UBaseType_t)N;
+
+    TimerDefinition_t xDefinitions[N];
+    UBaseType_t       uxStartOrder[N]; /*<< Indexes of the auto-start timers, shortest period first. */
+    UBaseType_t       uxNumberToStart;
+};
+
+template <size_t N>
+constexpr TimerTable_t<N> xMakeTimerTable(const TimerDefinition_t (&xDefinitions)[N]) {
+    TimerTable_t<N> xTable{};
+    UBaseType_t     uxIndex    = 0;
+    UBaseType_t     uxPosition = 0;
+
+    for (size_t x = 0; x < N; x++) {
+        xTable.xDefinitions[x] = xDefinitions[x];
+
+        if (xDefinitions[x].uxAutoStart != (UBaseType_t)pdFALSE) {
+            /* Insertion sort on the period.  Timers with equal periods keep
+            their table order. */
+            uxIndex    = (UBaseType_t)x;
+            uxPosition = xTable.uxNumberToStart;
+            while ((uxPosition > 0) &&
+                   (xDefinitions[xTable.uxStartOrder[uxPosition - 1]].xTimerPeriodInTicks >
+                    xDefinitions[uxIndex].xTimerPeriodInTicks)) {
+                xTable.uxStartOrder[uxPosition] = xTable.uxStartOrder[uxPosition - 1];
+                uxPosition--;
+            }
+            xTable.uxStartOrder[uxPosition] = uxIndex;
+            xTable.uxNumberToStart++;
+        }
+    }
+
+    return xTable;
+}
+
+template <size_t N>
+inline BaseType_t xTimerCreateTable(const TimerTable_t<N> &xTable,
+                                    StaticTimer_t (&xTimerBuffers)[N],
+                                    TimerHandle_t *const pxCreatedTimers) {
+    return xTimerCreateStaticTable(xTable.xDefinitions, (UBaseType_t)N, xTable.uxStartOrder,
+                                   xTable.uxNumberToStart, xTimerBuffers, pxCreatedTimers);
+}
+
+#endif
@@ -0,0 +1,390 @@
+#include "uds.h"
+
+#if (configUSE_TIMER_TRACE == 1)
+
+#include "timer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+
+#if ((configTIMER_TRACE_BUFFER_LENGTH & (configTIMER_TRACE_BUFFER_LENGTH - 1)) != 0)
+    #error configTIMER_TRACE_BUFFER_LENGTH must be a power of two
+#endif
+
+#define tmrTRACE_FILE_MAGIC ((uint32_t)0x43525455U) /* "UTRC" */
+#define tmrTRACE_FILE_VERSION ((uint32_t)1U)
+#define tmrTRACE_THREAD_NAME_LEN 16U
+
+/* The trace events of one thread.  Only that thread writes to it, so an event
+is filled in and then published by advancing ullEventsWritten. */
+typedef struct tmrTraceBuffer {
+    std::atomic<uint64_t> ullEventsWritten;
+    char                  cThreadName[tmrTRACE_THREAD_NAME_LEN];
+    TimerTraceEvent_t     xEvents[configTIMER_TRACE_BUFFER_LENGTH];
+} TraceBuffer_t;
+
+/* The start of a trace file, followed for each buffer by a
+TraceFileBuffer_t and its events, oldest first. */
+typedef struct tmrTraceFileHeader {
+    uint32_t ulMagic;
+    uint32_t ulVersion;
+    uint32_t ulNumberOfBuffers;
+    uint32_t ulEventSize; /*<< sizeof(TimerTraceEvent_t), checked when the file is read. */
+} TraceFileHeader_t;
+
+typedef struct tmrTraceFileBuffer {
+    char     cThreadName[tmrTRACE_THREAD_NAME_LEN];
+    uint32_t ulThreadNumber;
+    uint32_t ulNumberOfEvents;
+} TraceFileBuffer_t;
+
+static TraceBuffer_t xTraceBuffers[configTIMER_TRACE_THREADS];
+static std::atomic<UBaseType_t> uxTraceBuffersClaimed(0U);
+static std::atomic<UBaseType_t> uxTraceEventsDropped(0U);
+
+/* The buffer of the calling thread, claimed by its first event. */
+static thread_local TraceBuffer_t *pxThreadTraceBuffer = NULL;
+static thread_local BaseType_t xThreadTraceBufferClaimed = pdFALSE;
+
+/*
+ * Give the calling thread a buffer of its own, or return NULL if they have all
+ * been claimed.  Buffers are not given back when a thread exits.
+ */
+static TraceBuffer_t *prvClaimTraceBuffer(void) {
+    UBaseType_t uxBuffer;
+
+    if (xThreadTraceBufferClaimed == pdFALSE) {
+        xThreadTraceBufferClaimed = pdTRUE;
+
+        uxBuffer = uxTraceBuffersClaimed.load(std::memory_order_relaxed);
+        while (uxBuffer < (UBaseType_t)configTIMER_TRACE_THREADS) {
+            if (uxTraceBuffersClaimed.compare_exchange_weak(uxBuffer, uxBuffer + 1U,
+                                                            std::memory_order_acq_rel)) {
+                pxThreadTraceBuffer = &(xTraceBuffers[uxBuffer]);
+                break;
+            }
+        }
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return pxThreadTraceBuffer;
+}
+
+void vTimerTraceRecord(const uint8_t ucEvent, const void *const pvObject, const BaseType_t xCommand,
+                       const uint32_t ulValue, const BaseType_t xResult) {
+    TraceBuffer_t *pxBuffer = pxThreadTraceBuffer;
+    TimerTraceEvent_t *pxEvent;
+    uint64_t ullEventsWritten;
+
+    if (pxBuffer == NULL) {
+        pxBuffer = prvClaimTraceBuffer();
+        if (pxBuffer == NULL) {
+            uxTraceEventsDropped.fetch_add(1U, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    ullEventsWritten = pxBuffer->ullEventsWritten.load(std::memory_order_relaxed);
+    pxEvent          = &(pxBuffer->xEvents[ullEventsWritten & (configTIMER_TRACE_BUFFER_LENGTH - 1U)]);
+
+    pxEvent->ullTime   = ullTimerGetMonotonicTime();
+    pxEvent->ullObject = (uint64_t)(uintptr_t)pvObject;
+    pxEvent->ulValue   = ulValue;
+    pxEvent->sCommand  = (int16_t)xCommand;
+    pxEvent->ucEvent   = ucEvent;
+    pxEvent->ucResult  = (uint8_t)xResult;
+
+    pxBuffer->ullEventsWritten.store(ullEventsWritten + 1U, std::memory_order_release);
+}
+
+void vTimerTraceSetThreadName(const char *const pcName) {
+    TraceBuffer_t *const pxBuffer = (pxThreadTraceBuffer != NULL) ? pxThreadTraceBuffer : prvClaimTraceBuffer();
+
+    configASSERT(pcName);
+
+    if (pxBuffer != NULL) {
+        strncpy(pxBuffer->cThreadName, pcName, tmrTRACE_THREAD_NAME_LEN - 1U);
+    } else {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+
+UBaseType_t uxTimerTraceGetEventsDropped(void) {
+    return uxTraceEventsDropped.load(std::memory_order_relaxed);
+}
+
+BaseType_t xTimerTraceSave(const char *const pcFileName) {
+    const UBaseType_t uxBuffers = uxTraceBuffersClaimed.load(std::memory_order_acquire);
+    TimerTraceEvent_t *const pxCopy = new (std::nothrow) TimerTraceEvent_t[configTIMER_TRACE_BUFFER_LENGTH];
+    TraceFileHeader_t xHeader;
+    TraceFileBuffer_t xFileBuffer;
+    TraceBuffer_t *pxBuffer;
+    uint64_t ullFirst, ullEnd, ullEvent, ullFirstIntact;
+    UBaseType_t uxBuffer;
+    BaseType_t xReturn = pdPASS;
+    FILE *pxFile;
+
+    configASSERT(pcFileName);
+
+    if (pxCopy == NULL) {
+        return pdFAIL;
+    }
+
+    pxFile = fopen(pcFileName, "wb");
+    if (pxFile == NULL) {
+        delete[] pxCopy;
+        return pdFAIL;
+    }
+
+    xHeader.ulMagic           = tmrTRACE_FILE_MAGIC;
+    xHeader.ulVersion         = tmrTRACE_FILE_VERSION;
+    xHeader.ulNumberOfBuffers = (uint32_t)uxBuffers;
+    xHeader.ulEventSize       = (uint32_t)sizeof(TimerTraceEvent_t);
+    if (fwrite(&xHeader, sizeof(xHeader), 1U, pxFile) != 1U) {
+        xReturn = pdFAIL;
+    }
+
+    for (uxBuffer = 0U; (uxBuffer < uxBuffers) && (xReturn == pdPASS); uxBuffer++) {
+        pxBuffer = &(xTraceBuffers[uxBuffer]);
+
+        ullEnd   = pxBuffer->ullEventsWritten.load(std::memory_order_acquire);
+        ullFirst = (ullEnd > (uint64_t)configTIMER_TRACE_BUFFER_LENGTH)
+                       ? (ullEnd - (uint64_t)configTIMER_TRACE_BUFFER_LENGTH)
+                       : 0U;
+        for (ullEvent = ullFirst; ullEvent < ullEnd; ullEvent++) {
+            pxCopy[ullEvent - ullFirst] =
+                pxBuffer->xEvents[ullEvent & (configTIMER_TRACE_BUFFER_LENGTH - 1U)];
+        }
+
+        /* The thread may have wrapped round onto the oldest events while
+        they were copied, and may be part way through overwriting the next
+        one, so only keep those that are still in the buffer. */
+        std::atomic_thread_fence(std::memory_order_acquire);
+        ullFirstIntact = pxBuffer->ullEventsWritten.load(std::memory_order_relaxed) + 1U;
+        ullFirstIntact = (ullFirstIntact > (uint64_t)configTIMER_TRACE_BUFFER_LENGTH)
+                             ? (ullFirstIntact - (uint64_t)configTIMER_TRACE_BUFFER_LENGTH)
+                             : 0U;
+        if (ullFirstIntact > ullEnd) {
+            ullFirstIntact = ullEnd;
+        }
+
+        memset(&xFileBuffer, 0, sizeof(xFileBuffer));
+        memcpy(xFileBuffer.cThreadName, pxBuffer->cThreadName, tmrTRACE_THREAD_NAME_LEN - 1U);
+        xFileBuffer.ulThreadNumber = (uint32_t)uxBuffer;
+
+        if (ullFirstIntact > ullFirst) {
+            xFileBuffer.ulNumberOfEvents = (uint32_t)(ullEnd - ullFirstIntact);
+            ullFirst = ullFirstIntact - ullFirst;
+        } else {
+            xFileBuffer.ulNumberOfEvents = (uint32_t)(ullEnd - ullFirst);
+            ullFirst = 0U;
+        }
+
+        if ((fwrite(&xFileBuffer, sizeof(xFileBuffer), 1U, pxFile) != 1U) ||
+            (fwrite(&(pxCopy[ullFirst]), sizeof(TimerTraceEvent_t), xFileBuffer.ulNumberOfEvents, pxFile) !=
+             xFileBuffer.ulNumberOfEvents)) {
+            xReturn = pdFAIL;
+        }
+    }
+
+    if (fclose(pxFile) != 0) {
+        xReturn = pdFAIL;
+    }
+    delete[] pxCopy;
+
+    return xReturn;
+}
+
+static const char *prvTraceCommandName(const int16_t sCommand) {
+    switch (sCommand) {
+    case tmrCOMMAND_START_DONT_TRACE:
+        return "reload";
+    case tmrCOMMAND_START:
+    case tmrCOMMAND_START_FROM_ISR:
+        return "start";
+    case tmrCOMMAND_RESET:
+    case tmrCOMMAND_RESET_FROM_ISR:
+        return "reset";
+    case tmrCOMMAND_STOP:
+    case tmrCOMMAND_STOP_FROM_ISR:
+        return "stop";
+    case tmrCOMMAND_CHANGE_PERIOD:
+    case tmrCOMMAND_CHANGE_PERIOD_FROM_ISR:
+        return "change_period";
+    case tmrCOMMAND_DELETE:
+        return "delete";
+    default:
+        return "command";
+    }
+}
+
+/*
+ * Write pcString as a JSON string, quotes included.  Thread names come from
+ * the application, so may hold anything.
+ */
+static void prvWriteJsonString(FILE *const pxFile, const char *pcString) {
+    fputc('"', pxFile);
+    for (; *pcString != '\0'; pcString++) {
+        const unsigned char ucChar = (unsigned char)*pcString;
+
+        if ((ucChar == '"') || (ucChar == '\\')) {
+            fputc('\\', pxFile);
+            fputc(ucChar, pxFile);
+        } else if (ucChar < 0x20U) {
+            fprintf(pxFile, "\\u%04x", (unsigned)ucChar);
+        } else {
+            fputc(ucChar, pxFile);
+        }
+    }
+    fputc('"', pxFile);
+}
+
+/*
+ * Write one event as a Chrome trace event, with its time in microseconds since
+ * ullStartTime.
+ */
+static void prvWriteJsonEvent(FILE *const pxFile, const TimerTraceEvent_t *const pxEvent,
+                              const uint32_t ulThread, const uint64_t ullStartTime) {
+    const uint64_t ullTime = pxEvent->ullTime - ullStartTime;
+
+    fprintf(pxFile, ",\n{\"pid\":1,\"tid\":%lu,\"ts\":%llu.%03llu,", (unsigned long)ulThread,
+            (unsigned long long)(ullTime / 1000U), (unsigned long long)(ullTime % 1000U));
+
+    switch (pxEvent->ucEvent) {
+    case tmrTRACE_CALLBACK_ENTER:
+        fprintf(pxFile, "\"ph\":\"B\",\"cat\":\"timer\",\"name\":\"callback\",\"args\":{\"timer\":\"0x%llx\"}}",
+                (unsigned long long)pxEvent->ullObject);
+        break;
+    case tmrTRACE_CALLBACK_EXIT:
+        fprintf(pxFile, "\"ph\":\"E\"}");
+        break;
+    case tmrTRACE_TASK_BLOCK:
+        fprintf(pxFile, "\"ph\":\"B\",\"cat\":\"task\",\"name\":\"blocked\",\"args\":{\"ticks\":%lu}}",
+                (unsigned long)pxEvent->ulValue);
+        break;
+    case tmrTRACE_TASK_WAKE:
+        fprintf(pxFile, "\"ph\":\"E\"}");
+        break;
+    case tmrTRACE_TICK:
+        fprintf(pxFile, "\"ph\":\"C\",\"name\":\"tick\",\"args\":{\"tick\":%lu}}", (unsigned long)pxEvent->ulValue);
+        break;
+    case tmrTRACE_COMMAND_SEND:
+    case tmrTRACE_COMMAND_RECEIVED:
+        fprintf(pxFile,
+                "\"ph\":\"i\",\"s\":\"t\",\"cat\":\"command\",\"name\":\"%s %s\",\"args\":{\"timer\":\"0x%llx\","
+                "\"value\":%lu,\"result\":%u}}",
+                (pxEvent->ucEvent == tmrTRACE_COMMAND_SEND) ? "send" : "receive",
+                prvTraceCommandName(pxEvent->sCommand), (unsigned long long)pxEvent->ullObject,
+                (unsigned long)pxEvent->ulValue, (unsigned)pxEvent->ucResult);
+        break;
+    case tmrTRACE_TIMER_CREATE:
+    case tmrTRACE_TIMER_EXPIRED:
+        fprintf(pxFile,
+                "\"ph\":\"i\",\"s\":\"t\",\"cat\":\"timer\",\"name\":\"%s\",\"args\":{\"timer\":\"0x%llx\","
+                "\"period\":%lu}}",
+                (pxEvent->ucEvent == tmrTRACE_TIMER_CREATE) ? "create" : "expired",
+                (unsigned long long)pxEvent->ullObject, (unsigned long)pxEvent->ulValue);
+        break;
+    default:
+        fprintf(pxFile, "\"ph\":\"i\",\"s\":\"t\",\"name\":\"event %u\",\"args\":{\"object\":\"0x%llx\"}}",
+                (unsigned)pxEvent->ucEvent, (unsigned long long)pxEvent->ullObject);
+        break;
+    }
+}
+
+BaseType_t xTimerTraceConvertToJson(const char *const pcTraceFileName, const char *const pcJsonFileName) {
+    TraceFileHeader_t xHeader;
+    TraceFileBuffer_t xFileBuffer;
+    TimerTraceEvent_t xEvent;
+    uint64_t ullStartTime = UINT64_MAX;
+    long lFirstBuffer;
+    uint32_t ulBuffer, ulEvent;
+    BaseType_t xReturn = pdPASS;
+    FILE *pxTrace;
+    FILE *pxJson;
+
+    configASSERT(pcTraceFileName);
+    configASSERT(pcJsonFileName);
+
+    pxTrace = fopen(pcTraceFileName, "rb");
+    if (pxTrace == NULL) {
+        return pdFAIL;
+    }
+
+    if ((fread(&xHeader, sizeof(xHeader), 1U, pxTrace) != 1U) || (xHeader.ulMagic != tmrTRACE_FILE_MAGIC) ||
+        (xHeader.ulVersion != tmrTRACE_FILE_VERSION) || (xHeader.ulEventSize != sizeof(TimerTraceEvent_t))) {
+        fclose(pxTrace);
+        return pdFAIL;
+    }
+    lFirstBuffer = ftell(pxTrace);
+
+    /* Times are written relative to the earliest event, so find it first. */
+    for (ulBuffer = 0U; (ulBuffer < xHeader.ulNumberOfBuffers) && (xReturn == pdPASS); ulBuffer++) {
+        if (fread(&xFileBuffer, sizeof(xFileBuffer), 1U, pxTrace) != 1U) {
+            xReturn = pdFAIL;
+        } else if (xFileBuffer.ulNumberOfEvents != 0U) {
+            if (fread(&xEvent, sizeof(xEvent), 1U, pxTrace) != 1U) {
+                xReturn = pdFAIL;
+            } else {
+                if (xEvent.ullTime < ullStartTime) {
+                    ullStartTime = xEvent.ullTime;
+                }
+                if (fseek(pxTrace, (long)(sizeof(xEvent) * (xFileBuffer.ulNumberOfEvents - 1U)), SEEK_CUR) != 0) {
+                    xReturn = pdFAIL;
+                }
+            }
+        }
+    }
+
+    pxJson = (xReturn == pdPASS) ? fopen(pcJsonFileName, "w") : NULL;
+    if ((pxJson == NULL) || (fseek(pxTrace, lFirstBuffer, SEEK_SET) != 0)) {
+        if (pxJson != NULL) {
+            fclose(pxJson);
+        }
+        fclose(pxTrace);
+        return pdFAIL;
+    }
+
+    fprintf(pxJson, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+                    "{\"pid\":1,\"ph\":\"M\",\"name\":\"process_name\",\"args\":{\"name\":\"timers\"}}");
+
+    for (ulBuffer = 0U; (ulBuffer < xHeader.ulNumberOfBuffers) && (xReturn == pdPASS); ulBuffer++) {
+        if (fread(&xFileBuffer, sizeof(xFileBuffer), 1U, pxTrace) != 1U) {
+            xReturn = pdFAIL;
+            break;
+        }
+
+        xFileBuffer.cThreadName[tmrTRACE_THREAD_NAME_LEN - 1U] = '\0';
+        if (xFileBuffer.cThreadName[0] != '\0') {
+            fprintf(pxJson, ",\n{\"pid\":1,\"tid\":%lu,\"ph\":\"M\",\"name\":\"thread_name\",\"args\":{\"name\":",
+                    (unsigned long)xFileBuffer.ulThreadNumber);
+            prvWriteJsonString(pxJson, xFileBuffer.cThreadName);
+            fprintf(pxJson, "}}");
+        } else {
+            fprintf(pxJson, ",\n{\"pid\":1,\"tid\":%lu,\"ph\":\"M\",\"name\":\"thread_name\",\"args\":{\"name\":\"thread %lu\"}}",
+                    (unsigned long)xFileBuffer.ulThreadNumber, (unsigned long)xFileBuffer.ulThreadNumber);
+        }
+
+        for (ulEvent = 0U; ulEvent < xFileBuffer.ulNumberOfEvents; ulEvent++) {
+            if (fread(&xEvent, sizeof(xEvent), 1U, pxTrace) != 1U) {
+                xReturn = pdFAIL;
+                break;
+            }
+            prvWriteJsonEvent(pxJson, &xEvent, xFileBuffer.ulThreadNumber, ullStartTime);
+        }
+    }
+
+    fprintf(pxJson, "\n]}\n");
+
+    if (fclose(pxJson) != 0) {
+        xReturn = pdFAIL;
+    }
+    fclose(pxTrace);
+
+    return xReturn;
+}
+
+#endif /* configUSE_TIMER_TRACE */
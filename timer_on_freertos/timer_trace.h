@@ -0,0 +1,88 @@
+#ifndef __TIMER_TRACE_H__
+#define __TIMER_TRACE_H__
+
+/*
+ * A binary tracer behind the trace macros of uds.h, included by uds.h when
+ * configUSE_TIMER_TRACE is 1.  Every thread that hits a trace macro writes
+ * fixed size events to a ring buffer of its own, configTIMER_TRACE_BUFFER_LENGTH
+ * events long, so recording takes no lock and the oldest events are
+ * overwritten once the ring is full:
+ *
+ *   xTimerTraceSave( "timers.trace" );                            ... while running
+ *   xTimerTraceConvertToJson( "timers.trace", "timers.json" );    ... any time later
+ *
+ * The second step is also the uds_trace_convert command.  The JSON file opens in chrome://tracing and ui.perfetto.dev, with a track
+ * per thread showing the callbacks and the time the timer service tasks spend
+ * blocked, and the tick count as a counter.
+ */
+
+/* The event types, see TimerTraceEvent_t. */
+#define tmrTRACE_TIMER_CREATE ((uint8_t)1)
+#define tmrTRACE_TIMER_EXPIRED ((uint8_t)2)
+#define tmrTRACE_COMMAND_SEND ((uint8_t)3)
+#define tmrTRACE_COMMAND_RECEIVED ((uint8_t)4)
+#define tmrTRACE_QUEUE_CREATE ((uint8_t)5)
+#define tmrTRACE_TICK ((uint8_t)6)
+#define tmrTRACE_CALLBACK_ENTER ((uint8_t)7)
+#define tmrTRACE_CALLBACK_EXIT ((uint8_t)8)
+#define tmrTRACE_TASK_BLOCK ((uint8_t)9)
+#define tmrTRACE_TASK_WAKE ((uint8_t)10)
+
+/* One event as it is held in a ring buffer and written to a trace file. */
+typedef struct xTIMER_TRACE_EVENT {
+	uint64_t ullTime;   /*<< See ullTimerGetMonotonicTime(). */
+	uint64_t ullObject; /*<< The timer or queue handle, or 0. */
+	uint32_t ulValue;   /*<< The period, command value, tick count or block time. */
+	int16_t  sCommand;  /*<< The command ID of tmrTRACE_COMMAND_* events. */
+	uint8_t  ucEvent;
+	uint8_t  ucResult;  /*<< What xTimerGenericCommand() returned, for tmrTRACE_COMMAND_SEND. */
+} TimerTraceEvent_t;
+
+void vTimerTraceRecord(const uint8_t ucEvent, const void* const pvObject, const BaseType_t xCommand,
+	const uint32_t ulValue, const BaseType_t xResult);
+
+/*
+ * Name the ring buffer of the calling thread, as shown by the converted trace.
+ * Names are truncated to 15 characters.
+ */
+void vTimerTraceSetThreadName(const char* const pcName);
+
+/*
+ * Write the events in every ring buffer to pcFileName.  The threads carry on
+ * recording while their buffers are copied, and any event overwritten before
+ * it was copied is left out.
+ */
+BaseType_t xTimerTraceSave(const char* const pcFileName);
+
+/*
+ * Convert a file written by xTimerTraceSave() to Chrome trace event JSON.
+ * Needs nothing from the process that saved the trace, so can be run from any
+ * build with configUSE_TIMER_TRACE set.
+ */
+BaseType_t xTimerTraceConvertToJson(const char* const pcTraceFileName, const char* const pcJsonFileName);
+
+/* Events lost because more than configTIMER_TRACE_THREADS threads traced. */
+UBaseType_t uxTimerTraceGetEventsDropped(void);
+
+#define traceTIMER_CREATE( pxNewTimer ) \
+	vTimerTraceRecord( tmrTRACE_TIMER_CREATE, ( pxNewTimer ), 0, ( uint32_t ) ( pxNewTimer )->xTimerPeriodInTicks, pdPASS )
+#define traceTIMER_EXPIRED( pxTimer ) \
+	vTimerTraceRecord( tmrTRACE_TIMER_EXPIRED, ( pxTimer ), 0, ( uint32_t ) ( pxTimer )->xTimerPeriodInTicks, pdPASS )
+#define traceTIMER_COMMAND_SEND( xTimer, xMessageID, xMessageValueValue, xReturn ) \
+	vTimerTraceRecord( tmrTRACE_COMMAND_SEND, ( xTimer ), ( xMessageID ), ( uint32_t ) ( xMessageValueValue ), ( xReturn ) )
+#define traceTIMER_COMMAND_RECEIVED( pxTimer, xMessageID, xMessageValue ) \
+	vTimerTraceRecord( tmrTRACE_COMMAND_RECEIVED, ( pxTimer ), ( xMessageID ), ( uint32_t ) ( xMessageValue ), pdPASS )
+#define traceQUEUE_CREATE( pxNewQueue ) \
+	vTimerTraceRecord( tmrTRACE_QUEUE_CREATE, ( pxNewQueue ), 0, 0U, pdPASS )
+#define traceTASK_INCREMENT_TICK( xTickCount ) \
+	vTimerTraceRecord( tmrTRACE_TICK, NULL, 0, ( uint32_t ) ( xTickCount ), pdPASS )
+#define traceTIMER_CALLBACK_ENTER( pvTimer ) \
+	vTimerTraceRecord( tmrTRACE_CALLBACK_ENTER, ( pvTimer ), 0, 0U, pdPASS )
+#define traceTIMER_CALLBACK_EXIT( pvTimer ) \
+	vTimerTraceRecord( tmrTRACE_CALLBACK_EXIT, ( pvTimer ), 0, 0U, pdPASS )
+#define traceTIMER_TASK_BLOCK( xTicksToWait ) \
+	vTimerTraceRecord( tmrTRACE_TASK_BLOCK, NULL, 0, ( uint32_t ) ( xTicksToWait ), pdPASS )
+#define traceTIMER_TASK_WAKE() \
+	vTimerTraceRecord( tmrTRACE_TASK_WAKE, NULL, 0, 0U, pdPASS )
+
+#endif
@@ -0,0 +1,35 @@
+#include "uds.h"
+
+#if (configTIMER_TRACE_CONVERTER == 1)
+
+#include <stdio.h>
+
+/*
+ * Converts a file written by xTimerTraceSave() to Chrome trace event JSON,
+ * built instead of main.cpp when configTIMER_TRACE_CONVERTER is 1:
+ *
+ *   uds_trace_convert timers.trace timers.json
+ *
+ * It starts no tasks, so a trace can be converted on a host other than the
+ * one that recorded it.
+ */
+
+#if (configUSE_TIMER_TRACE == 0)
+    #error configTIMER_TRACE_CONVERTER needs configUSE_TIMER_TRACE for xTimerTraceConvertToJson()
+#endif
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <trace file> <json file>\n", argv[0]);
+        return 2;
+    }
+
+    if (xTimerTraceConvertToJson(argv[1], argv[2]) == pdFAIL) {
+        fprintf(stderr, "%s: cannot convert %s to %s\n", argv[0], argv[1], argv[2]);
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif /* configTIMER_TRACE_CONVERTER */
@@ -29,6 +29,26 @@ extern "C" {
 	#define mtCOVERAGE_TEST_DELAY()
 #endif
 
+#ifndef configUSE_TIMER_TRACE
+    /* Set to 1 to record the trace macros below into ring buffers, see
+    timer_trace.h. */
+#define configUSE_TIMER_TRACE 0
+#endif
+
+#ifndef configTIMER_TRACE_THREADS
+    /* The number of threads that can record trace events. */
+#define configTIMER_TRACE_THREADS 8
+#endif
+
+#ifndef configTIMER_TRACE_BUFFER_LENGTH
+    /* The events kept per thread, must be a power of two. */
+#define configTIMER_TRACE_BUFFER_LENGTH 4096
+#endif
+
+#if (configUSE_TIMER_TRACE == 1)
+	#include "timer_trace.h"
+#endif
+
 #ifndef traceTIMER_EXPIRED
 	#define traceTIMER_EXPIRED(pxTimer)
 #endif
@@ -48,10 +68,30 @@ extern "C" {
     #define traceQUEUE_CREATE(pxNewQueue)
 #endif
 
+#ifndef traceTIMER_COMMAND_SEND
+    #define traceTIMER_COMMAND_SEND( xTimer, xMessageID, xMessageValueValue, xReturn )
+#endif
+
 #ifndef traceTIMER_COMMAND_RECEIVED
     #define traceTIMER_COMMAND_RECEIVED( pxTimer, xMessageID, xMessageValue )
 #endif
 
+#ifndef traceTIMER_CALLBACK_ENTER
+    #define traceTIMER_CALLBACK_ENTER( pvTimer )
+#endif
+
+#ifndef traceTIMER_CALLBACK_EXIT
+    #define traceTIMER_CALLBACK_EXIT( pvTimer )
+#endif
+
+#ifndef traceTIMER_TASK_BLOCK
+    #define traceTIMER_TASK_BLOCK( xTicksToWait )
+#endif
+
+#ifndef traceTIMER_TASK_WAKE
+    #define traceTIMER_TASK_WAKE()
+#endif
+
 #ifndef configSUPPORT_STATIC_ALLOCATION
     /* Defaults to 0 for backward compatibility. */
 #define configSUPPORT_STATIC_ALLOCATION 0
@@ -62,6 +102,222 @@ extern "C" {
 #define configSUPPORT_DYNAMIC_ALLOCATION 1
 #endif
 
+#ifndef configUSE_TIMER_POOL
+    /* Set to 1 to allocate all timers from a fixed pool linked with 32-bit
+    indices (see IndexListItem_t in list.h) rather than from the heap. */
+#define configUSE_TIMER_POOL 0
+#endif
+
+#ifndef configTIMER_POOL_SIZE
+#define configTIMER_POOL_SIZE 1024
+#endif
+
+#ifndef configUSE_TIMER_BATCH_CALLBACKS
+    /* Set to 1 to allow callbacks to be registered in a batch form that
+    receives all the timers using them that expired in one sweep. */
+#define configUSE_TIMER_BATCH_CALLBACKS 0
+#endif
+
+#ifndef configTIMER_BATCH_CALLBACKS
+#define configTIMER_BATCH_CALLBACKS 8
+#endif
+
+#ifndef configTIMER_BATCH_LENGTH
+#define configTIMER_BATCH_LENGTH 32
+#endif
+
+#ifndef configUSE_TIMER_PRIORITIES
+    /* Set to 1 to call the timers due in one sweep in priority order, see
+    vTimerSetPriority(). */
+#define configUSE_TIMER_PRIORITIES 0
+#endif
+
+#ifndef configTIMER_SWEEP_BUDGET_US
+    /* With configUSE_TIMER_PRIORITIES, the time after which a sweep defers
+    its remaining lower priority timers, or 0 for no limit. */
+#define configTIMER_SWEEP_BUDGET_US 0
+#endif
+
+#ifndef configTIMER_MAX_DOMAINS
+    /* The number of timer domains that can exist, including the default
+    domain, see xTimerDomainCreate(). */
+#define configTIMER_MAX_DOMAINS 4
+#endif
+
+#ifndef INCLUDE_xTimerPendFunctionCall
+#define INCLUDE_xTimerPendFunctionCall 1
+#endif
+
+#ifndef configTIMER_PEND_QUEUE_LENGTH
+    /* The number of pended function calls that can wait, must be a power of
+    two, see xTimerPendFunctionCall(). */
+#define configTIMER_PEND_QUEUE_LENGTH 64
+#endif
+
+#ifndef configTIMER_PEND_BATCH_LENGTH
+    /* The number of pended function calls run each time round the loop of
+    the timer service task. */
+#define configTIMER_PEND_BATCH_LENGTH 16
+#endif
+
+#ifndef configTIMER_BENCHMARK
+    /* Set to 1 to build the throughput benchmark in timer_bench.cpp in place
+    of the demo in main.cpp. */
+#define configTIMER_BENCHMARK 0
+#endif
+
+#ifndef configTIMER_SELF_TEST
+    /* Set to 1 to build the self checks in main_test.cpp in place of the demo
+    in main.cpp.  They need configUSE_VIRTUAL_TIME. */
+#define configTIMER_SELF_TEST 0
+#endif
+
+#ifndef configTIMER_TRACE_CONVERTER
+    /* Set to 1 to build the trace to JSON converter in timer_trace_convert.cpp
+    in place of the demo in main.cpp.  It needs configUSE_TIMER_TRACE. */
+#define configTIMER_TRACE_CONVERTER 0
+#endif
+
+#ifndef configUSE_TIMER_SNAPSHOT
+    /* Set to 1 to include xTimerSnapshotSave() and xTimerSnapshotRestore(),
+    which need the port to provide pvPortMapFile(). */
+#define configUSE_TIMER_SNAPSHOT 0
+#endif
+
+#ifndef configMAX_TIMER_NAME_LEN
+    /* The space for a timer name in a snapshot, including the terminator. */
+#define configMAX_TIMER_NAME_LEN 16
+#endif
+
+#ifndef configUSE_TIMER_HISTOGRAMS
+    /* Set to 1 to record expiry lateness and command latency in histograms,
+    see ullTimerGetHistogramPercentile(). */
+#define configUSE_TIMER_HISTOGRAMS 0
+#endif
+
+#ifndef configUSE_TIMER_STATS
+    /* Set to 1 to count what the timer service tasks do, see
+    vTimerGetStats(). */
+#define configUSE_TIMER_STATS 0
+#endif
+
+#ifndef configUSE_TIMER_CALLBACK_ACCOUNTING
+    /* Set to 1 to measure the wall and CPU time of every timer callback and
+    report callbacks that overrun their budget, see vTimerSetCallbackBudget().
+    Needs the port to provide ullPortGetThreadCpuTime(). */
+#define configUSE_TIMER_CALLBACK_ACCOUNTING 0
+#endif
+
+#ifndef configTIMER_DEFAULT_CALLBACK_BUDGET_US
+    /* The budget new timers start with, or 0 for none. */
+#define configTIMER_DEFAULT_CALLBACK_BUDGET_US 0
+#endif
+
+#ifndef configTIMER_OVERRUN_REPORT_INTERVAL_MS
+    /* The least time between two overrun reports from one timer service
+    task.  Overruns in between are only counted. */
+#define configTIMER_OVERRUN_REPORT_INTERVAL_MS 1000
+#endif
+
+#ifndef configTIMER_REPORT_OVERRUN
+    /* How an overrun is reported.  Times are in nanoseconds, and
+    ulUnreported is the number of overruns since the last report. */
+#define configTIMER_REPORT_OVERRUN(pcTimerName, ullWallTime, ullCpuTime, ullBudget, ulUnreported)   \
+    fprintf(stderr, "timer %s: callback took %lluus (%lluus CPU), budget %lluus, %lu overruns not reported\n", \
+            (pcTimerName), (unsigned long long)((ullWallTime) / 1000U),                            \
+            (unsigned long long)((ullCpuTime) / 1000U), (unsigned long long)((ullBudget) / 1000U), \
+            (unsigned long)(ulUnreported))
+#endif
+
+#ifndef configUSE_TIMER_CAPTURE
+    /* Set to 1 to include the capture and replay of timer API calls, see
+    timer_capture.h. */
+#define configUSE_TIMER_CAPTURE 0
+#endif
+
+#ifndef configUSE_VIRTUAL_TIME
+    /* Set to 1 for ticks that only advance when a test harness says so, see
+    xTimerDomainAdvanceTime().  Neither the port nor the timer domains then
+    generate ticks of their own. */
+#define configUSE_VIRTUAL_TIME 0
+#endif
+
+#ifndef configUSE_TIMER_PDES
+    /* Set to 1 to include the parallel simulation engine of timer_pdes.h,
+    which needs configUSE_VIRTUAL_TIME. */
+#define configUSE_TIMER_PDES 0
+#endif
+
+#ifndef configTIMER_TASK_AFFINITY
+    /* The CPUs the timer service tasks run on as a bit mask, 0 for any.  See
+    xPortConfigureThread() for these and the settings below, and
+    ulPortGetConfigureFailures() for whether they could be applied. */
+#define configTIMER_TASK_AFFINITY 0
+#endif
+
+#ifndef configTIMER_TASK_REALTIME_PRIORITY
+    /* 1 to 99 to run the timer service tasks SCHED_FIFO, 0 to leave them at
+    the priority they are created with. */
+#define configTIMER_TASK_REALTIME_PRIORITY 0
+#endif
+
+#ifndef configTICK_THREAD_AFFINITY
+    /* As configTIMER_TASK_AFFINITY, for the threads generating the ticks of
+    the port and of the timer domains.  The Windows port uses CPU 0 when 0. */
+#define configTICK_THREAD_AFFINITY 0
+#endif
+
+#ifndef configTICK_THREAD_REALTIME_PRIORITY
+#define configTICK_THREAD_REALTIME_PRIORITY 0
+#endif
+
+#ifndef configINTERRUPT_THREAD_AFFINITY
+    /* As configTIMER_TASK_AFFINITY, for the thread that runs the simulated
+    interrupt handlers.  The Windows port uses CPU 0 when 0. */
+#define configINTERRUPT_THREAD_AFFINITY 0
+#endif
+
+#ifndef configINTERRUPT_THREAD_REALTIME_PRIORITY
+    /* As configTIMER_TASK_REALTIME_PRIORITY, for the same thread.  The
+    Windows port never puts it below its own simulated interrupt priority. */
+#define configINTERRUPT_THREAD_REALTIME_PRIORITY 0
+#endif
+
+#ifndef configTIMER_THREAD_STACK_PREFAULT
+    /* The bytes of stack each of the threads above touches when it starts. */
+#define configTIMER_THREAD_STACK_PREFAULT 0
+#endif
+
+#ifndef configTIMER_LOCK_MEMORY
+    /* Set to 1 for CreateTimerManageTask() to lock the process in memory. */
+#define configTIMER_LOCK_MEMORY 0
+#endif
+
+#ifndef configRATE_LIMITER_REFILL_TICKS
+    /* The period of the timer that refills every rate limiter, see
+    timer_rate_limiter.h. */
+#define configRATE_LIMITER_REFILL_TICKS 1
+#endif
+
+#ifndef configUSE_TIMER_PROBES
+    /* Set to 1 to add USDT probes for perf and bpftrace, see
+    timer_probes.h.  On by default on Linux when <sys/sdt.h> is installed. */
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define configUSE_TIMER_PROBES 1
+#endif
+#endif
+#ifndef configUSE_TIMER_PROBES
+#define configUSE_TIMER_PROBES 0
+#endif
+#endif
+
+#ifndef configUSE_HIGH_RES_TIMERS
+    /* Set to 1 to include timers with nanosecond periods on the monotonic
+    clock, see xHighResTimerCreate(). */
+#define configUSE_HIGH_RES_TIMERS 0
+#endif
+
 typedef void *QueueHandle_t;
 typedef void *TaskHandle_t;
 
@@ -75,20 +331,36 @@ struct xSTATIC_LIST_ITEM {
 };
 typedef struct xSTATIC_LIST_ITEM StaticListItem_t;
 
+/* Mirrors the hot Timer_t part followed by the cold TimerMetadata_t part of a
+timer, see timer.cpp.  It has no alignment beyond that of its members, so a
+LightweightTimer_t embedded in a user structure does not make the structure
+over-aligned, which plain new would not honour before C++17. */
 typedef struct xSTATIC_TIMER {
-    void *           pvDummy1;
-    StaticListItem_t xDummy2;
-    TickType_t       xDummy3;
-    UBaseType_t      uxDummy4;
-    void *           pvDummy5[2];
+    struct {
+        TickType_t xDummy1[2];
+        void *     pvDummy2[3];
+        uint8_t    ucDummy3[2];
+        uint16_t   usDummy9;
+        void *     pvDummy4;
+    } xDummyHot;
+    struct {
+        void *pvDummy5[4];
 #if (configUSE_TRACE_FACILITY == 1)
-    UBaseType_t uxDummy6;
+        UBaseType_t uxDummy6;
 #endif
 
 #if ((configSUPPORT_STATIC_ALLOCATION == 1) && (configSUPPORT_DYNAMIC_ALLOCATION == 1))
-    uint8_t ucDummy7;
+        uint8_t ucDummy7;
 #endif
 
+#if (configUSE_TIMER_POOL == 0)
+        void *pvDummy8[2];
+#endif
+
+#if (configUSE_TIMER_CALLBACK_ACCOUNTING == 1)
+        uint64_t ullDummy10[6];
+#endif
+    } xDummyCold;
 } StaticTimer_t;
 
 
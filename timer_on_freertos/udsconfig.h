@@ -1,8 +1,10 @@
 #pragma once
 #ifndef __UDSCONFIG_H__
 
+#ifndef configTICK_RATE_HZ
 #define configTICK_RATE_HZ (100) /* This is a simulated environment and therefore not real-time.   \
                                   */
+#endif
 
 #define configTIMER_QUEUE_LENGTH 20
 